@@ -42,6 +42,10 @@ G_DEFINE_TYPE (BgPicturesSource, bg_pictures_source, BG_TYPE_SOURCE)
 	G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
         G_FILE_ATTRIBUTE_TIME_MODIFIED
 
+/* Number of directory entries asked for at a time, so that the first
+ * rows show up before large directories are fully listed */
+#define PICTURES_PAGE_SIZE 100
+
 struct _BgPicturesSourcePrivate
 {
   GCancellable *cancellable;
@@ -136,6 +140,57 @@ remove_placeholder (BgPicturesSource *bg_source, CcBackgroundItem *item)
   gtk_list_store_remove (store, &iter);
 }
 
+static void
+add_picture (BgPicturesSource *bg_source,
+             CcBackgroundItem *item,
+             GdkPixbuf        *pixbuf)
+{
+  const char *uri;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  GtkTreeRowReference *row_ref;
+  GtkListStore *store;
+  cairo_surface_t *surface;
+  int scale_factor;
+
+  store = bg_source_get_liststore (BG_SOURCE (bg_source));
+  uri = cc_background_item_get_uri (item);
+  if (uri == NULL)
+    uri = cc_background_item_get_source_url (item);
+
+  scale_factor = bg_source_get_scale_factor (BG_SOURCE (bg_source));
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale_factor, NULL);
+  cc_background_item_load (item, NULL);
+
+  row_ref = g_object_get_data (G_OBJECT (item), "row-ref");
+  if (row_ref == NULL)
+    {
+      /* insert the item into the liststore if it did not exist */
+      gtk_list_store_insert_with_values (store, NULL, -1,
+                                         0, surface,
+                                         1, item,
+                                         -1);
+    }
+  else
+    {
+      path = gtk_tree_row_reference_get_path (row_ref);
+      if (gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path))
+        {
+          /* otherwise update the thumbnail */
+          gtk_list_store_set (store, &iter,
+                              0, surface,
+                              -1);
+        }
+      gtk_tree_path_free (path);
+    }
+
+  g_hash_table_insert (bg_source->priv->known_items,
+                       bg_pictures_source_get_unique_filename (uri),
+                       GINT_TO_POINTER (TRUE));
+
+  cairo_surface_destroy (surface);
+}
+
 static void
 picture_scaled (GObject *source_object,
                 GAsyncResult *res,
@@ -147,12 +202,6 @@ picture_scaled (GObject *source_object,
   GdkPixbuf *pixbuf = NULL;
   const char *software;
   const char *uri;
-  GtkTreeIter iter;
-  GtkTreePath *path;
-  GtkTreeRowReference *row_ref;
-  GtkListStore *store;
-  cairo_surface_t *surface = NULL;
-  int scale_factor;
 
   item = g_object_get_data (source_object, "item");
   pixbuf = gdk_pixbuf_new_from_stream_finish (res, &error);
@@ -172,7 +221,6 @@ picture_scaled (GObject *source_object,
    * back to BgPicturesSource.
    */
   bg_source = BG_PICTURES_SOURCE (user_data);
-  store = bg_source_get_liststore (BG_SOURCE (bg_source));
   uri = cc_background_item_get_uri (item);
   if (uri == NULL)
     uri = cc_background_item_get_source_url (item);
@@ -187,38 +235,9 @@ picture_scaled (GObject *source_object,
       goto out;
     }
 
-  scale_factor = bg_source_get_scale_factor (BG_SOURCE (bg_source));
-  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale_factor, NULL);
-  cc_background_item_load (item, NULL);
-
-  row_ref = g_object_get_data (G_OBJECT (item), "row-ref");
-  if (row_ref == NULL)
-    {
-      /* insert the item into the liststore if it did not exist */
-      gtk_list_store_insert_with_values (store, NULL, -1,
-                                         0, surface,
-                                         1, item,
-                                         -1);
-    }
-  else
-    {
-      path = gtk_tree_row_reference_get_path (row_ref);
-      if (gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path))
-        {
-          /* otherwise update the thumbnail */
-          gtk_list_store_set (store, &iter,
-                              0, surface,
-                              -1);
-        }
-    }
-
-  g_hash_table_insert (bg_source->priv->known_items,
-                       bg_pictures_source_get_unique_filename (uri),
-                       GINT_TO_POINTER (TRUE));
-
+  add_picture (bg_source, item, pixbuf);
 
  out:
-  g_clear_pointer (&surface, (GDestroyNotify) cairo_surface_destroy);
   g_clear_object (&pixbuf);
 }
 
@@ -307,6 +326,196 @@ picture_copied_for_read (GObject *source_object,
   g_clear_error (&error);
 }
 
+typedef struct
+{
+  BgPicturesSource *bg_source;
+  CcBackgroundItem *item;
+  GFile *file;
+  gchar *uri;
+  gchar *content_type;
+  guint64 mtime;
+  gboolean check_screenshot;
+  GnomeDesktopThumbnailFactory *thumb_factory;
+  GCancellable *cancellable;
+  gint thumbnail_height;
+  gint thumbnail_width;
+
+  /* Set by the worker */
+  GdkPixbuf *pixbuf;
+  gboolean is_screenshot;
+  GError *error;
+} ThumbnailData;
+
+static void
+thumbnail_data_free (ThumbnailData *data)
+{
+  g_object_unref (data->item);
+  g_object_unref (data->file);
+  g_free (data->uri);
+  g_free (data->content_type);
+  g_object_unref (data->thumb_factory);
+  g_object_unref (data->cancellable);
+  g_clear_object (&data->pixbuf);
+  g_clear_error (&data->error);
+  g_free (data);
+}
+
+/* Looks for the "Software" text chunk gnome-screenshot puts in its PNGs,
+ * without decoding the picture. Like gdk-pixbuf, only the chunks before
+ * the image data are considered. */
+static gboolean
+is_gnome_screenshot (GFile        *file,
+                     GCancellable *cancellable)
+{
+  static const guchar png_signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+  static const gchar software[] = "Software\0gnome-screenshot";
+  GFileInputStream *stream;
+  GInputStream *input;
+  gboolean retval = FALSE;
+  guchar header[8];
+  gchar text[sizeof (software)];
+  guint32 length;
+  gsize n_read;
+
+  stream = g_file_read (file, cancellable, NULL);
+  if (stream == NULL)
+    return FALSE;
+  input = G_INPUT_STREAM (stream);
+
+  if (!g_input_stream_read_all (input, header, sizeof (header), &n_read, cancellable, NULL) ||
+      n_read != sizeof (header) ||
+      memcmp (header, png_signature, sizeof (png_signature)) != 0)
+    goto out;
+
+  /* Each chunk is a big endian length, a type, the data and a CRC */
+  while (g_input_stream_read_all (input, header, sizeof (header), &n_read, cancellable, NULL) &&
+         n_read == sizeof (header))
+    {
+      length = ((guint32) header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+
+      if (memcmp (header + 4, "IDAT", 4) == 0 ||
+          memcmp (header + 4, "IEND", 4) == 0)
+        break;
+
+      if (memcmp (header + 4, "tEXt", 4) == 0 &&
+          length == sizeof (software) - 1)
+        {
+          if (!g_input_stream_read_all (input, text, length, &n_read, cancellable, NULL) ||
+              n_read != length)
+            break;
+
+          if (memcmp (text, software, length) == 0)
+            {
+              retval = TRUE;
+              break;
+            }
+
+          length = 0;
+        }
+
+      if (g_input_stream_skip (input, (gsize) length + 4, cancellable, NULL) != (gssize) length + 4)
+        break;
+    }
+
+ out:
+  g_object_unref (stream);
+
+  return retval;
+}
+
+static gboolean
+picture_thumbnail_ready (gpointer user_data)
+{
+  ThumbnailData *data = user_data;
+  BgPicturesSource *bg_source;
+
+  if (g_cancellable_is_cancelled (data->cancellable))
+    goto out;
+
+  /* since we were not cancelled, the source is still around */
+  bg_source = data->bg_source;
+
+  if (data->is_screenshot)
+    {
+      g_debug ("Ignored URL '%s' as it's a screenshot from gnome-screenshot", data->uri);
+      remove_placeholder (bg_source, data->item);
+      goto out;
+    }
+
+  if (data->pixbuf == NULL)
+    {
+      if (!g_error_matches (data->error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Failed to load picture '%s': %s", data->uri,
+                     data->error ? data->error->message : "no thumbnail");
+          remove_placeholder (bg_source, data->item);
+        }
+      goto out;
+    }
+
+  add_picture (bg_source, data->item, data->pixbuf);
+
+ out:
+  thumbnail_data_free (data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+picture_thumbnail_job (gpointer user_data,
+                       gpointer unused)
+{
+  ThumbnailData *data = user_data;
+  GFileInputStream *stream;
+  gchar *path;
+  gint width, height;
+
+  if (g_cancellable_set_error_if_cancelled (data->cancellable, &data->error))
+    goto out;
+
+  if (data->check_screenshot &&
+      is_gnome_screenshot (data->file, data->cancellable))
+    {
+      data->is_screenshot = TRUE;
+      goto out;
+    }
+
+  /* Large thumbnails are enough for the chooser, but not on HiDPI
+   * screens, and pictures smaller than the thumbnail size are stored as
+   * they are. The original is only decoded in those cases. */
+  path = bg_source_ensure_cached_thumbnail (data->thumb_factory,
+                                            data->uri,
+                                            data->content_type,
+                                            data->mtime);
+  if (path != NULL &&
+      gdk_pixbuf_get_file_info (path, &width, &height) != NULL &&
+      (width >= data->thumbnail_width || height >= data->thumbnail_height))
+    data->pixbuf = gdk_pixbuf_new_from_file_at_scale (path,
+                                                      data->thumbnail_width,
+                                                      data->thumbnail_height,
+                                                      TRUE,
+                                                      NULL);
+  g_free (path);
+
+  if (data->pixbuf != NULL)
+    goto out;
+
+  stream = g_file_read (data->file, data->cancellable, &data->error);
+  if (stream == NULL)
+    goto out;
+
+  data->pixbuf = gdk_pixbuf_new_from_stream_at_scale (G_INPUT_STREAM (stream),
+                                                      data->thumbnail_width,
+                                                      data->thumbnail_height,
+                                                      TRUE,
+                                                      data->cancellable,
+                                                      &data->error);
+  g_object_unref (stream);
+
+ out:
+  g_idle_add (picture_thumbnail_ready, data);
+}
+
 static gboolean
 in_content_types (const char *content_type)
 {
@@ -476,10 +685,22 @@ add_single_file (BgPicturesSource     *bg_source,
   media = g_object_get_data (G_OBJECT (file), "grl-media");
   if (media == NULL)
     {
-      g_object_set_data_full (G_OBJECT (file), "item", g_object_ref (item), g_object_unref);
-      g_file_read_async (file, G_PRIORITY_DEFAULT,
-                         bg_source->priv->cancellable,
-                         picture_opened_for_read, bg_source);
+      ThumbnailData *data;
+
+      data = g_new0 (ThumbnailData, 1);
+      data->bg_source = bg_source;
+      data->item = g_object_ref (item);
+      data->file = g_object_ref (file);
+      data->uri = g_file_get_uri (file);
+      data->content_type = g_strdup (content_type);
+      data->mtime = mtime;
+      data->check_screenshot = !ret_row_ref && in_screenshot_types (content_type);
+      data->thumb_factory = g_object_ref (bg_source->priv->thumb_factory);
+      data->cancellable = g_object_ref (bg_source->priv->cancellable);
+      data->thumbnail_height = bg_source_get_thumbnail_height (BG_SOURCE (bg_source));
+      data->thumbnail_width = bg_source_get_thumbnail_width (BG_SOURCE (bg_source));
+
+      bg_source_run_thumbnail_job (picture_thumbnail_job, data);
     }
   else
     {
@@ -673,6 +894,14 @@ file_info_async_ready (GObject      *source,
 
       g_list_foreach (files, (GFunc) g_object_unref, NULL);
       g_list_free (files);
+      g_object_unref (source);
+      return;
+    }
+
+  /* the last page is empty */
+  if (files == NULL)
+    {
+      g_object_unref (source);
       return;
     }
 
@@ -680,6 +909,8 @@ file_info_async_ready (GObject      *source,
 
   parent = g_file_enumerator_get_container (G_FILE_ENUMERATOR (source));
 
+  /* the store is sorted as well, this only makes the newest pictures of
+   * each page come first */
   files = g_list_sort (files, file_sort_func);
 
   /* iterate over the available files */
@@ -695,6 +926,14 @@ file_info_async_ready (GObject      *source,
 
   g_list_foreach (files, (GFunc) g_object_unref, NULL);
   g_list_free (files);
+
+  /* the enumerator is kept alive until the last page */
+  g_file_enumerator_next_files_async (G_FILE_ENUMERATOR (source),
+                                      PICTURES_PAGE_SIZE,
+                                      G_PRIORITY_LOW,
+                                      bg_source->priv->cancellable,
+                                      file_info_async_ready,
+                                      bg_source);
 }
 
 static void
@@ -718,14 +957,14 @@ dir_enum_async_ready (GObject      *source,
 
   priv = BG_PICTURES_SOURCE (user_data)->priv;
 
-  /* get the files */
+  /* get the files, a page at a time. file_info_async_ready() owns the
+   * enumerator from now on */
   g_file_enumerator_next_files_async (enumerator,
-                                      G_MAXINT,
+                                      PICTURES_PAGE_SIZE,
                                       G_PRIORITY_LOW,
                                       priv->cancellable,
                                       file_info_async_ready,
                                       user_data);
-  g_object_unref (enumerator);
 }
 
 char *
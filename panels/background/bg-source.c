@@ -26,6 +26,9 @@
 #define THUMBNAIL_WIDTH 256
 #define THUMBNAIL_HEIGHT (THUMBNAIL_WIDTH * 3 / 4)
 
+/* Decoding large images is mostly CPU bound, a few threads are enough */
+#define MAX_THUMBNAIL_WORKERS 4
+
 G_DEFINE_ABSTRACT_TYPE (BgSource, bg_source, G_TYPE_OBJECT)
 
 #define SOURCE_PRIVATE(o) \
@@ -37,8 +40,25 @@ struct _BgSourcePrivate
   GtkWidget *window;
   gint thumbnail_height;
   gint thumbnail_width;
+  cairo_surface_t *placeholder;
 };
 
+typedef struct
+{
+  GFunc func;
+  gpointer data;
+  gconstpointer source;
+  gint position;
+  guint serial;
+} ThumbnailJob;
+
+/* The rows of a source that are on screen, their jobs go first. Jobs are
+ * only ever queued and sorted from the main thread, which is also the
+ * only one to change these. The source is only compared, never used. */
+static gconstpointer visible_source = NULL;
+static gint visible_start = -1;
+static gint visible_end = -1;
+
 enum
 {
   PROP_LISTSTORE = 1,
@@ -118,6 +138,7 @@ bg_source_dispose (GObject *object)
   BgSourcePrivate *priv = BG_SOURCE (object)->priv;
 
   g_clear_object (&priv->store);
+  g_clear_pointer (&priv->placeholder, cairo_surface_destroy);
 
   G_OBJECT_CLASS (bg_source_parent_class)->dispose (object);
 }
@@ -191,3 +212,177 @@ bg_source_get_thumbnail_width (BgSource *source)
 
   return source->priv->thumbnail_width;
 }
+
+/* Shown until the real thumbnail of a row is ready */
+cairo_surface_t *
+bg_source_get_placeholder (BgSource *source)
+{
+  BgSourcePrivate *priv;
+  gint scale_factor;
+  cairo_t *cr;
+
+  g_return_val_if_fail (BG_IS_SOURCE (source), NULL);
+
+  priv = source->priv;
+
+  if (priv->placeholder == NULL)
+    {
+      scale_factor = bg_source_get_scale_factor (source);
+      priv->placeholder = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                      priv->thumbnail_width,
+                                                      priv->thumbnail_height);
+      cairo_surface_set_device_scale (priv->placeholder, scale_factor, scale_factor);
+
+      cr = cairo_create (priv->placeholder);
+      cairo_set_source_rgba (cr, 0.5, 0.5, 0.5, 0.2);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+    }
+
+  return priv->placeholder;
+}
+
+static void
+thumbnail_job_run (gpointer data,
+                   gpointer user_data)
+{
+  ThumbnailJob *job = data;
+
+  job->func (job->data, NULL);
+  g_free (job);
+}
+
+static gboolean
+thumbnail_job_is_visible (const ThumbnailJob *job)
+{
+  return job->source != NULL &&
+         job->source == visible_source &&
+         job->position >= visible_start &&
+         job->position <= visible_end;
+}
+
+/* Visible rows first, then in the order the jobs were queued */
+static gint
+thumbnail_job_compare (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  const ThumbnailJob *job_a = a;
+  const ThumbnailJob *job_b = b;
+  gboolean visible_a, visible_b;
+
+  visible_a = thumbnail_job_is_visible (job_a);
+  visible_b = thumbnail_job_is_visible (job_b);
+  if (visible_a != visible_b)
+    return visible_a ? -1 : 1;
+
+  if (job_a->serial != job_b->serial)
+    return job_a->serial < job_b->serial ? -1 : 1;
+
+  return 0;
+}
+
+static GThreadPool *
+get_thumbnail_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (thumbnail_job_run,
+                                    NULL,
+                                    CLAMP (g_get_num_processors (), 1, MAX_THUMBNAIL_WORKERS),
+                                    FALSE,
+                                    NULL);
+      g_thread_pool_set_sort_function (new_pool, thumbnail_job_compare, NULL);
+      g_once_init_leave (&pool, (gsize) new_pool);
+    }
+
+  return (GThreadPool *) pool;
+}
+
+/* Runs func in one of the threads shared by all the sources. Jobs for
+ * the rows on screen, as set with bg_source_set_visible_rows(), run
+ * first, and the others in the order they were queued. */
+void
+bg_source_run_row_thumbnail_job (BgSource *source,
+                                 gint      position,
+                                 GFunc     func,
+                                 gpointer  data)
+{
+  static guint serial = 0;
+  ThumbnailJob *job;
+
+  job = g_new0 (ThumbnailJob, 1);
+  job->func = func;
+  job->data = data;
+  job->source = source;
+  job->position = position;
+  job->serial = serial++;
+
+  g_thread_pool_push (get_thumbnail_pool (), job, NULL);
+}
+
+/* For work that has no row yet */
+void
+bg_source_run_thumbnail_job (GFunc    func,
+                             gpointer data)
+{
+  bg_source_run_row_thumbnail_job (NULL, -1, func, data);
+}
+
+/* Moves the jobs for the rows between start and end, both included,
+ * ahead of the queue */
+void
+bg_source_set_visible_rows (BgSource *source,
+                            gint      start,
+                            gint      end)
+{
+  g_return_if_fail (BG_IS_SOURCE (source));
+
+  if (visible_source == source &&
+      visible_start == start &&
+      visible_end == end)
+    return;
+
+  visible_source = source;
+  visible_start = start;
+  visible_end = end;
+
+  /* Setting the function again sorts the jobs still queued */
+  g_thread_pool_set_sort_function (get_thumbnail_pool (), thumbnail_job_compare, NULL);
+}
+
+/* Returns the path of the freedesktop.org thumbnail for uri, creating
+ * it when missing. Blocks, so only call it from a thumbnail job. */
+gchar *
+bg_source_ensure_cached_thumbnail (GnomeDesktopThumbnailFactory *thumb_factory,
+                                   const gchar                  *uri,
+                                   const gchar                  *mime_type,
+                                   guint64                       mtime)
+{
+  GdkPixbuf *pixbuf;
+  gchar *path;
+
+  path = gnome_desktop_thumbnail_factory_lookup (thumb_factory, uri, mtime);
+  if (path != NULL)
+    return path;
+
+  if (gnome_desktop_thumbnail_factory_has_valid_failed_thumbnail (thumb_factory, uri, mtime) ||
+      !gnome_desktop_thumbnail_factory_can_thumbnail (thumb_factory, uri, mime_type, mtime))
+    return NULL;
+
+  pixbuf = gnome_desktop_thumbnail_factory_generate_thumbnail (thumb_factory, uri, mime_type);
+  if (pixbuf == NULL)
+    {
+      gnome_desktop_thumbnail_factory_create_failed_thumbnail (thumb_factory, uri, mtime);
+      return NULL;
+    }
+
+  gnome_desktop_thumbnail_factory_save_thumbnail (thumb_factory, pixbuf, uri, mtime);
+  g_object_unref (pixbuf);
+
+  return gnome_desktop_thumbnail_factory_lookup (thumb_factory, uri, mtime);
+}
@@ -22,6 +22,7 @@
 #define _BG_SOURCE_H
 
 #include <gtk/gtk.h>
+#include <libgnome-desktop/gnome-desktop-thumbnail.h>
 
 G_BEGIN_DECLS
 
@@ -73,6 +74,25 @@ gint bg_source_get_thumbnail_height (BgSource *source);
 
 gint bg_source_get_thumbnail_width (BgSource *source);
 
+cairo_surface_t *bg_source_get_placeholder (BgSource *source);
+
+void bg_source_run_thumbnail_job (GFunc    func,
+                                  gpointer data);
+
+void bg_source_run_row_thumbnail_job (BgSource *source,
+                                      gint      position,
+                                      GFunc     func,
+                                      gpointer  data);
+
+void bg_source_set_visible_rows (BgSource *source,
+                                 gint      start,
+                                 gint      end);
+
+gchar *bg_source_ensure_cached_thumbnail (GnomeDesktopThumbnailFactory *thumb_factory,
+                                          const gchar                  *uri,
+                                          const gchar                  *mime_type,
+                                          guint64                       mtime);
+
 G_END_DECLS
 
 #endif /* _BG_SOURCE_H */
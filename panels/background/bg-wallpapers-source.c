@@ -38,8 +38,107 @@ struct _BgWallpapersSourcePrivate
 {
   GnomeDesktopThumbnailFactory *thumb_factory;
   CcBackgroundXml *xml;
+  GCancellable *cancellable;
 };
 
+typedef struct
+{
+  CcBackgroundItem *item;
+  gchar *uri;
+  GtkTreeRowReference *row;
+  GnomeDesktopThumbnailFactory *thumb_factory;
+  GCancellable *cancellable;
+  gint scale_factor;
+  gint thumbnail_height;
+  gint thumbnail_width;
+} ThumbnailData;
+
+static void
+thumbnail_data_free (ThumbnailData *data)
+{
+  g_object_unref (data->item);
+  g_free (data->uri);
+  gtk_tree_row_reference_free (data->row);
+  g_object_unref (data->thumb_factory);
+  g_object_unref (data->cancellable);
+  g_free (data);
+}
+
+/* Back in the main thread, the decoded picture is in the thumbnail cache
+ * by now and GnomeBG only has to compose the result from it */
+static gboolean
+thumbnail_ready (gpointer user_data)
+{
+  ThumbnailData *data = user_data;
+  GtkTreeModel *model;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GdkPixbuf *pixbuf;
+  cairo_surface_t *surface;
+
+  if (g_cancellable_is_cancelled (data->cancellable) ||
+      !gtk_tree_row_reference_valid (data->row))
+    goto out;
+
+  model = gtk_tree_row_reference_get_model (data->row);
+  path = gtk_tree_row_reference_get_path (data->row);
+  gtk_tree_model_get_iter (model, &iter, path);
+  gtk_tree_path_free (path);
+
+  pixbuf = cc_background_item_get_thumbnail (data->item, data->thumb_factory,
+                                             data->thumbnail_width, data->thumbnail_height,
+                                             data->scale_factor);
+  if (pixbuf == NULL)
+    {
+      gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
+      goto out;
+    }
+
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, data->scale_factor, NULL);
+  gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, surface, -1);
+  cairo_surface_destroy (surface);
+  g_object_unref (pixbuf);
+
+ out:
+  thumbnail_data_free (data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+thumbnail_job (gpointer user_data,
+               gpointer unused)
+{
+  ThumbnailData *data = user_data;
+  GFileInfo *info;
+  GFile *file;
+  gchar *path;
+
+  if (!g_cancellable_is_cancelled (data->cancellable) &&
+      data->uri != NULL)
+    {
+      /* Slideshows have no thumbnailer, those are left to GnomeBG */
+      file = g_file_new_for_uri (data->uri);
+      info = g_file_query_info (file,
+                                G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                G_FILE_QUERY_INFO_NONE,
+                                data->cancellable,
+                                NULL);
+      if (info != NULL)
+        {
+          path = bg_source_ensure_cached_thumbnail (data->thumb_factory,
+                                                    data->uri,
+                                                    g_file_info_get_content_type (info),
+                                                    g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+          g_free (path);
+          g_object_unref (info);
+        }
+      g_object_unref (file);
+    }
+
+  g_idle_add (thumbnail_ready, data);
+}
 
 static void
 load_wallpapers (gchar              *key,
@@ -48,41 +147,38 @@ load_wallpapers (gchar              *key,
 {
   BgWallpapersSourcePrivate *priv = source->priv;
   GtkTreeIter iter;
-  GdkPixbuf *pixbuf;
+  GtkTreePath *path;
   GtkListStore *store = bg_source_get_liststore (BG_SOURCE (source));
-  cairo_surface_t *surface = NULL;
+  ThumbnailData *data;
   gboolean deleted;
-  gint scale_factor;
-  gint thumbnail_height;
-  gint thumbnail_width;
+  gint position;
 
   g_object_get (G_OBJECT (item), "is-deleted", &deleted, NULL);
 
   if (deleted)
     return;
 
-  gtk_list_store_append (store, &iter);
-
-  scale_factor = bg_source_get_scale_factor (BG_SOURCE (source));
-  thumbnail_height = bg_source_get_thumbnail_height (BG_SOURCE (source));
-  thumbnail_width = bg_source_get_thumbnail_width (BG_SOURCE (source));
-  pixbuf = cc_background_item_get_thumbnail (item, priv->thumb_factory,
-					     thumbnail_width, thumbnail_height,
-					     scale_factor);
-  if (pixbuf == NULL)
-    goto out;
-
-  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale_factor, NULL);
-  gtk_list_store_set (store, &iter,
-                      0, surface,
-                      1, item,
-                      2, cc_background_item_get_name (item),
-                      -1);
-
- out:
-  g_clear_pointer (&surface, (GDestroyNotify) cairo_surface_destroy);
-  if (pixbuf)
-    g_object_unref (pixbuf);
+  gtk_list_store_insert_with_values (store, &iter, -1,
+                                     0, bg_source_get_placeholder (BG_SOURCE (source)),
+                                     1, item,
+                                     2, cc_background_item_get_name (item),
+                                     -1);
+
+  data = g_new0 (ThumbnailData, 1);
+  data->item = g_object_ref (item);
+  data->uri = g_strdup (cc_background_item_get_uri (item));
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), &iter);
+  data->row = gtk_tree_row_reference_new (GTK_TREE_MODEL (store), path);
+  position = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+  data->thumb_factory = g_object_ref (priv->thumb_factory);
+  data->cancellable = g_object_ref (priv->cancellable);
+  data->scale_factor = bg_source_get_scale_factor (BG_SOURCE (source));
+  data->thumbnail_height = bg_source_get_thumbnail_height (BG_SOURCE (source));
+  data->thumbnail_width = bg_source_get_thumbnail_width (BG_SOURCE (source));
+
+  /* Rows on screen are thumbnailed first, the others in order */
+  bg_source_run_row_thumbnail_job (BG_SOURCE (source), position, thumbnail_job, data);
 }
 
 static void
@@ -146,6 +242,12 @@ bg_wallpapers_source_dispose (GObject *object)
 {
   BgWallpapersSourcePrivate *priv = BG_WALLPAPERS_SOURCE (object)->priv;
 
+  if (priv->cancellable)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_clear_object (&priv->cancellable);
+    }
+
   g_clear_object (&priv->thumb_factory);
   g_clear_object (&priv->xml);
 
@@ -162,6 +264,7 @@ bg_wallpapers_source_init (BgWallpapersSource *self)
   priv->thumb_factory =
     gnome_desktop_thumbnail_factory_new (GNOME_DESKTOP_THUMBNAIL_SIZE_LARGE);
   priv->xml = cc_background_xml_new ();
+  priv->cancellable = g_cancellable_new ();
 }
 
 static void
@@ -385,14 +385,36 @@ out:
   gtk_drag_finish (context, ret, FALSE, time);
 }
 
+static void
+on_view_scrolled (GtkIconView *icon_view)
+{
+  GtkTreePath *start, *end;
+  BgSource *source;
+
+  if (!gtk_icon_view_get_visible_range (icon_view, &start, &end))
+    return;
+
+  /* Get the thumbnails on screen done before the others */
+  source = g_object_get_data (G_OBJECT (icon_view), "bg-source");
+  bg_source_set_visible_rows (source,
+                              gtk_tree_path_get_indices (start)[0],
+                              gtk_tree_path_get_indices (end)[0]);
+
+  gtk_tree_path_free (start);
+  gtk_tree_path_free (end);
+}
+
 static GtkWidget *
-create_view (CcBackgroundChooserDialog *chooser, GtkTreeModel *model)
+create_view (CcBackgroundChooserDialog *chooser, BgSource *source)
 {
   GtkCellRenderer *renderer;
+  GtkTreeModel *model;
   GtkWidget *icon_view;
   GtkWidget *sw;
   GtkWindow *parent;
 
+  model = GTK_TREE_MODEL (bg_source_get_liststore (source));
+
   sw = gtk_scrolled_window_new (NULL, NULL);
   gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
   gtk_widget_set_hexpand (sw, TRUE);
@@ -405,6 +427,13 @@ create_view (CcBackgroundChooserDialog *chooser, GtkTreeModel *model)
   g_signal_connect (icon_view, "selection-changed", G_CALLBACK (on_selection_changed), chooser);
   g_signal_connect (icon_view, "item-activated", G_CALLBACK (on_item_activated), chooser);
 
+  g_object_set_data_full (G_OBJECT (icon_view), "bg-source", g_object_ref (source), g_object_unref);
+  g_signal_connect_object (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw)),
+                           "value-changed",
+                           G_CALLBACK (on_view_scrolled),
+                           icon_view,
+                           G_CONNECT_SWAPPED);
+
   parent = gtk_window_get_transient_for (GTK_WINDOW (chooser));
   if (parent == NULL || !gtk_window_is_maximized (parent))
     gtk_icon_view_set_columns (GTK_ICON_VIEW (icon_view), 3);
@@ -426,23 +455,19 @@ cc_background_chooser_dialog_constructed (GObject *object)
 {
   CcBackgroundChooserDialog *chooser = CC_BACKGROUND_CHOOSER_DIALOG (object);
   CcBackgroundChooserDialogPrivate *priv = chooser->priv;
-  GtkListStore *model;
   GtkWidget *sw;
   GtkWidget *vbox;
 
   G_OBJECT_CLASS (cc_background_chooser_dialog_parent_class)->constructed (object);
 
-  model = bg_source_get_liststore (BG_SOURCE (priv->wallpapers_source));
-  sw = create_view (chooser, GTK_TREE_MODEL (model));
+  sw = create_view (chooser, BG_SOURCE (priv->wallpapers_source));
   gtk_stack_add_titled (GTK_STACK (priv->stack), sw, "wallpapers", _("Wallpapers"));
   gtk_container_child_set (GTK_CONTAINER (priv->stack), sw, "position", 0, NULL);
 
-  model = bg_source_get_liststore (BG_SOURCE (priv->pictures_source));
-  sw = create_view (chooser, GTK_TREE_MODEL (model));
+  sw = create_view (chooser, BG_SOURCE (priv->pictures_source));
   gtk_stack_add_named (GTK_STACK (priv->pictures_stack), sw, "view");
 
-  model = bg_source_get_liststore (BG_SOURCE (priv->colors_source));
-  sw = create_view (chooser, GTK_TREE_MODEL (model));
+  sw = create_view (chooser, BG_SOURCE (priv->colors_source));
   gtk_stack_add_titled (GTK_STACK (priv->stack), sw, "colors", _("Colors"));
 
   vbox = gtk_dialog_get_content_area (GTK_DIALOG (chooser));
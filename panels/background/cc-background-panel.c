@@ -70,12 +70,21 @@ struct _CcBackgroundPanelPrivate
 
   GdkPixbuf *display_screenshot;
   char *screenshot_path;
+
+  /* Composited previews, only rendered again when the background, the
+   * screenshot or the scale factor change */
+  cairo_surface_t *desktop_preview;
+  cairo_surface_t *lock_preview;
+  gint preview_scale_factor;
 };
 
 #define WID(y) (GtkWidget *) gtk_builder_get_object (priv->builder, y)
 #define CURRENT_BG (settings == priv->settings ? priv->current_background : priv->current_lock_background)
 #define SAVE_PATH (settings == priv->settings ? "last-edited.xml" : "last-edited-lock.xml")
 
+#define PREVIEW_WIDTH 309
+#define PREVIEW_HEIGHT 168
+
 static const char *
 cc_background_panel_get_help_uri (CcPanel *panel)
 {
@@ -120,6 +129,9 @@ cc_background_panel_dispose (GObject *object)
   g_clear_object (&priv->thumb_factory);
   g_clear_object (&priv->display_screenshot);
 
+  g_clear_pointer (&priv->desktop_preview, cairo_surface_destroy);
+  g_clear_pointer (&priv->lock_preview, cairo_surface_destroy);
+
   g_clear_pointer (&priv->screenshot_path, g_free);
 
   G_OBJECT_CLASS (cc_background_panel_parent_class)->dispose (object);
@@ -171,6 +183,11 @@ update_preview (CcBackgroundPanelPrivate *priv,
       cc_background_item_load (current_background, NULL);
     }
 
+  if (settings == priv->settings)
+    g_clear_pointer (&priv->desktop_preview, cairo_surface_destroy);
+  else
+    g_clear_pointer (&priv->lock_preview, cairo_surface_destroy);
+
   changes_with_time = FALSE;
 
   if (current_background)
@@ -204,51 +221,41 @@ get_save_path (const char *filename)
                            NULL);
 }
 
-static void
-update_display_preview (CcBackgroundPanel *panel,
+static cairo_surface_t *
+render_display_preview (CcBackgroundPanel *panel,
                         GtkWidget         *widget,
                         CcBackgroundItem  *current_background)
 {
   CcBackgroundPanelPrivate *priv = panel->priv;
-  GtkAllocation allocation;
-  const gint preview_width = 309;
-  const gint preview_height = 168;
-  gint scale_factor;
+  cairo_surface_t *surface;
   GdkPixbuf *pixbuf;
   cairo_t *cr;
 
-  gtk_widget_get_allocation (widget, &allocation);
-
-  if (!current_background)
-    return;
+  surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                               CAIRO_CONTENT_COLOR_ALPHA,
+                                               PREVIEW_WIDTH,
+                                               PREVIEW_HEIGHT);
+  cr = cairo_create (surface);
 
-  scale_factor = gtk_widget_get_scale_factor (widget);
   pixbuf = cc_background_item_get_frame_thumbnail (current_background,
                                                    priv->thumb_factory,
-                                                   preview_width,
-                                                   preview_height,
-                                                   scale_factor,
+                                                   PREVIEW_WIDTH,
+                                                   PREVIEW_HEIGHT,
+                                                   priv->preview_scale_factor,
                                                    -2, TRUE);
-
-  cr = gdk_cairo_create (gtk_widget_get_window (widget));
   gdk_cairo_set_source_pixbuf (cr,
                                pixbuf,
                                0, 0);
   cairo_paint (cr);
   g_object_unref (pixbuf);
 
-  pixbuf = NULL;
   if (current_background == priv->current_background &&
-      panel->priv->display_screenshot != NULL)
+      priv->display_screenshot != NULL)
     {
-      pixbuf = gdk_pixbuf_scale_simple (panel->priv->display_screenshot,
-                                        preview_width,
-                                        preview_height,
+      pixbuf = gdk_pixbuf_scale_simple (priv->display_screenshot,
+                                        PREVIEW_WIDTH,
+                                        PREVIEW_HEIGHT,
                                         GDK_INTERP_BILINEAR);
-    }
-
-  if (pixbuf)
-    {
       gdk_cairo_set_source_pixbuf (cr,
                                    pixbuf,
                                    0, 0);
@@ -257,6 +264,41 @@ update_display_preview (CcBackgroundPanel *panel,
     }
 
   cairo_destroy (cr);
+
+  return surface;
+}
+
+static void
+update_display_preview (CcBackgroundPanel *panel,
+                        GtkWidget         *widget,
+                        cairo_t           *cr,
+                        CcBackgroundItem  *current_background)
+{
+  CcBackgroundPanelPrivate *priv = panel->priv;
+  cairo_surface_t **preview;
+  gint scale_factor;
+
+  if (!current_background)
+    return;
+
+  scale_factor = gtk_widget_get_scale_factor (widget);
+  if (scale_factor != priv->preview_scale_factor)
+    {
+      g_clear_pointer (&priv->desktop_preview, cairo_surface_destroy);
+      g_clear_pointer (&priv->lock_preview, cairo_surface_destroy);
+      priv->preview_scale_factor = scale_factor;
+    }
+
+  if (current_background == priv->current_background)
+    preview = &priv->desktop_preview;
+  else
+    preview = &priv->lock_preview;
+
+  if (*preview == NULL)
+    *preview = render_display_preview (panel, widget, current_background);
+
+  cairo_set_source_surface (cr, *preview, 0, 0);
+  cairo_paint (cr);
 }
 
 typedef struct {
@@ -334,6 +376,7 @@ on_screenshot_finished (GObject *source,
   }
 
   g_clear_object (&panel->priv->display_screenshot);
+  g_clear_pointer (&panel->priv->desktop_preview, cairo_surface_destroy);
   panel->priv->display_screenshot = gdk_pixbuf_get_from_surface (surface,
                                                                  0, 0,
                                                                  data->monitor_rect.width,
@@ -347,7 +390,7 @@ on_screenshot_finished (GObject *source,
   cairo_surface_destroy (surface);
 
  out:
-  update_display_preview (panel, WID ("background-desktop-drawingarea"), priv->current_background);
+  gtk_widget_queue_draw (WID ("background-desktop-drawingarea"));
   g_free (data);
 }
 
@@ -441,7 +484,7 @@ on_preview_draw (GtkWidget         *widget,
       get_screenshot_async (panel);
     }
   else
-    update_display_preview (panel, widget, priv->current_background);
+    update_display_preview (panel, widget, cr, priv->current_background);
 
   return TRUE;
 }
@@ -452,7 +495,7 @@ on_lock_preview_draw (GtkWidget         *widget,
                       CcBackgroundPanel *panel)
 {
   CcBackgroundPanelPrivate *priv = panel->priv;
-  update_display_preview (panel, widget, priv->current_lock_background);
+  update_display_preview (panel, widget, cr, priv->current_lock_background);
   return TRUE;
 }
 
@@ -31,7 +31,46 @@
 
 /* The number of items we signal as "added" before
  * returning to the main loop */
-#define NUM_ITEMS_PER_BATCH 1
+#define NUM_ITEMS_PER_BATCH 32
+
+/* The maximum number of files parsed at the same time */
+#define MAX_PARSE_THREADS 4
+
+#define PARSE_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+	G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+	G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+/* A wallpaper and the id used to weed out duplicates */
+typedef struct {
+	gchar            *id;
+	CcBackgroundItem *item;
+} XmlEntry;
+
+/* The wallpapers found in a file, when it was last parsed. Shared by
+ * all the CcBackgroundXml objects through parse_cache, the items must
+ * not be changed. */
+typedef struct {
+	gint       ref_count;
+	guint64    mtime;
+	guint32    mtime_usec;
+	goffset    size;
+	GPtrArray *entries; /* XmlEntry */
+} ParsedFile;
+
+/* A file of the list, parsed in one of the threads of the pool */
+typedef struct {
+	gchar     *filename;
+	GPtrArray *entries; /* XmlEntry */
+	gboolean   done;
+} ParseJob;
+
+typedef struct {
+	GMutex mutex;
+	GCond  cond;
+} ParseJobs;
+
+G_LOCK_DEFINE_STATIC (parse_cache);
+static GHashTable *parse_cache = NULL; /* filename -> ParsedFile */
 
 struct CcBackgroundXmlPrivate
 {
@@ -112,17 +151,71 @@ enum_string_to_value (GType type,
 	return value->value;
 }
 
+static XmlEntry *
+xml_entry_new (const gchar      *id,
+	       CcBackgroundItem *item)
+{
+	XmlEntry *entry;
+
+	entry = g_new (XmlEntry, 1);
+	entry->id = g_strdup (id);
+	entry->item = g_object_ref (item);
+
+	return entry;
+}
+
+static void
+xml_entry_free (XmlEntry *entry)
+{
+	g_free (entry->id);
+	g_object_unref (entry->item);
+	g_free (entry);
+}
+
+static ParsedFile *
+parsed_file_ref (ParsedFile *parsed)
+{
+	g_atomic_int_inc (&parsed->ref_count);
+	return parsed;
+}
+
+static void
+parsed_file_unref (ParsedFile *parsed)
+{
+	if (g_atomic_int_dec_and_test (&parsed->ref_count)) {
+		g_ptr_array_unref (parsed->entries);
+		g_free (parsed);
+	}
+}
+
+/* Adds the wallpaper unless one with the same id is already known,
+ * this is only ever done in the main thread */
+static gboolean
+add_entry (CcBackgroundXml *xml,
+	   XmlEntry        *entry)
+{
+	if (g_hash_table_lookup (xml->priv->wp_hash, entry->id) != NULL)
+		return FALSE;
+
+	g_hash_table_insert (xml->priv->wp_hash,
+			     g_strdup (entry->id),
+			     g_object_ref (entry->item));
+	g_signal_emit (G_OBJECT (xml), signals[ADDED], 0, entry->item);
+
+	return TRUE;
+}
+
 static gboolean
 idle_emit (CcBackgroundXml *xml)
 {
-	GObject *item;
+	XmlEntry *entry;
 	guint i = NUM_ITEMS_PER_BATCH;
 
 	g_async_queue_lock (xml->priv->item_added_queue);
 
-	while (i > 0 && (item = g_async_queue_try_pop_unlocked (xml->priv->item_added_queue)) != NULL) {
-		g_signal_emit (G_OBJECT (xml), signals[ADDED], 0, item);
-		g_object_unref (item);
+	while (i > 0 && (entry = g_async_queue_try_pop_unlocked (xml->priv->item_added_queue)) != NULL) {
+		add_entry (xml, entry);
+		xml_entry_free (entry);
 		i--;
 	}
 
@@ -136,38 +229,47 @@ idle_emit (CcBackgroundXml *xml)
         }
 }
 
+/* Takes the entries, the whole file is queued at once */
 static void
 emit_added_in_idle (CcBackgroundXml *xml,
-		    GObject         *object)
+		    GPtrArray       *entries)
 {
+	guint i;
+
+	g_ptr_array_set_free_func (entries, NULL);
+
 	g_async_queue_lock (xml->priv->item_added_queue);
-	g_async_queue_push_unlocked (xml->priv->item_added_queue, object);
-	if (xml->priv->item_added_id == 0)
+	for (i = 0; i < entries->len; i++)
+		g_async_queue_push_unlocked (xml->priv->item_added_queue, entries->pdata[i]);
+	if (entries->len > 0 && xml->priv->item_added_id == 0)
 		xml->priv->item_added_id = g_idle_add ((GSourceFunc) idle_emit, xml);
 	g_async_queue_unlock (xml->priv->item_added_queue);
+
+	g_ptr_array_unref (entries);
 }
 
 #define NONE "(none)"
 #define UNSET_FLAG(flag) G_STMT_START{ (flags&=~(flag)); }G_STMT_END
 #define SET_FLAG(flag) G_STMT_START{ (flags|=flag); }G_STMT_END
 
-static gboolean
-cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
-				     const gchar     *filename,
-				     gboolean         in_thread)
+/* Returns all the wallpapers in the file, or NULL if it could not be
+ * parsed. Can be called from any thread. */
+static GPtrArray *
+cc_background_xml_parse_file (const gchar *filename)
 {
   xmlDoc * wplist;
   xmlNode * root, * list, * wpa;
   xmlChar * nodelang;
   const gchar * const * syslangs;
+  GPtrArray *entries;
   gint i;
-  gboolean retval;
 
   wplist = xmlParseFile (filename);
-  retval = FALSE;
 
   if (!wplist)
-    return retval;
+    return NULL;
+
+  entries = g_ptr_array_new_with_free_func ((GDestroyNotify) xml_entry_free);
 
   syslangs = g_get_language_names ();
 
@@ -277,26 +379,6 @@ cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
 	}
       }
 
-      /* Check whether the target file exists */
-      {
-        GFile *file;
-        const char *uri;
-
-	uri = cc_background_item_get_uri (item);
-	if (uri != NULL)
-	  {
-            file = g_file_new_for_uri (uri);
-	    if (g_file_query_exists (file, NULL) == FALSE)
-	      {
-	        g_free (cname);
-	        g_object_unref (file);
-	        g_object_unref (item);
-	        continue;
-	      }
-	    g_object_unref (file);
-	  }
-      }
-
       /* FIXME, this is a broken way of doing,
        * need to use proper code here */
       uri = g_filename_to_uri (filename, NULL, NULL);
@@ -304,32 +386,140 @@ cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
       g_free (cname);
       g_free (uri);
 
-      /* Make sure we don't already have this one and that filename exists */
-      if (g_hash_table_lookup (xml->priv->wp_hash, id) != NULL) {
-	g_object_unref (item);
-	g_free (id);
-	continue;
-      }
-
       g_object_set (G_OBJECT (item), "flags", flags, NULL);
-      g_hash_table_insert (xml->priv->wp_hash,
-                           g_strdup (id),
-                           g_object_ref (item));
-      if (in_thread)
-        emit_added_in_idle (xml, g_object_ref (item));
-      else
-        g_signal_emit (G_OBJECT (xml), signals[ADDED], 0, item);
+      g_ptr_array_add (entries, xml_entry_new (id, item));
 
       g_object_unref (item);
       g_free (id);
-      retval = TRUE;
     }
   }
   xmlFreeDoc (wplist);
 
+  return entries;
+}
+
+/* Returns copies of the wallpapers in the file whose picture exists,
+ * or NULL if the file could not be parsed. Files are only parsed again
+ * once they changed. Can be called from any thread. */
+static GPtrArray *
+cc_background_xml_load_entries (const gchar *filename)
+{
+  GFile *file;
+  GFileInfo *info;
+  ParsedFile *parsed;
+  GPtrArray *entries;
+  guint64 mtime;
+  guint32 mtime_usec;
+  goffset size;
+  guint i;
+
+  file = g_file_new_for_path (filename);
+  info = g_file_query_info (file, PARSE_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (file);
+  if (info == NULL)
+    return NULL;
+
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  mtime_usec = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  size = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  G_LOCK (parse_cache);
+  if (parse_cache == NULL)
+    parse_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, (GDestroyNotify) parsed_file_unref);
+  parsed = g_hash_table_lookup (parse_cache, filename);
+  if (parsed != NULL &&
+      parsed->mtime == mtime &&
+      parsed->mtime_usec == mtime_usec &&
+      parsed->size == size)
+    parsed_file_ref (parsed);
+  else
+    parsed = NULL;
+  G_UNLOCK (parse_cache);
+
+  if (parsed == NULL) {
+    entries = cc_background_xml_parse_file (filename);
+    if (entries == NULL)
+      return NULL;
+
+    parsed = g_new0 (ParsedFile, 1);
+    parsed->ref_count = 1;
+    parsed->mtime = mtime;
+    parsed->mtime_usec = mtime_usec;
+    parsed->size = size;
+    parsed->entries = entries;
+
+    G_LOCK (parse_cache);
+    g_hash_table_insert (parse_cache, g_strdup (filename), parsed_file_ref (parsed));
+    G_UNLOCK (parse_cache);
+  }
+
+  entries = g_ptr_array_new_with_free_func ((GDestroyNotify) xml_entry_free);
+
+  for (i = 0; i < parsed->entries->len; i++) {
+    XmlEntry *entry = parsed->entries->pdata[i];
+    CcBackgroundItem *item;
+    const char *uri;
+
+    /* Check whether the target file exists */
+    uri = cc_background_item_get_uri (entry->item);
+    if (uri != NULL) {
+      file = g_file_new_for_uri (uri);
+      if (g_file_query_exists (file, NULL) == FALSE) {
+        g_object_unref (file);
+        continue;
+      }
+      g_object_unref (file);
+    }
+
+    item = cc_background_item_copy (entry->item);
+    g_ptr_array_add (entries, xml_entry_new (entry->id, item));
+    g_object_unref (item);
+  }
+
+  parsed_file_unref (parsed);
+
+  return entries;
+}
+
+static gboolean
+cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
+				     const gchar     *filename)
+{
+  GPtrArray *entries;
+  gboolean retval;
+  guint i;
+
+  entries = cc_background_xml_load_entries (filename);
+  if (entries == NULL)
+    return FALSE;
+
+  retval = FALSE;
+  for (i = 0; i < entries->len; i++) {
+    if (add_entry (xml, entries->pdata[i]))
+      retval = TRUE;
+  }
+  g_ptr_array_unref (entries);
+
   return retval;
 }
 
+static void
+load_changed_file_thread (GTask        *task,
+			  gpointer      source_object,
+			  gpointer      task_data,
+			  GCancellable *cancellable)
+{
+  GPtrArray *entries;
+
+  entries = cc_background_xml_load_entries (task_data);
+  if (entries != NULL)
+    emit_added_in_idle (CC_BACKGROUND_XML (source_object), entries);
+
+  g_task_return_boolean (task, TRUE);
+}
+
 static void
 gnome_wp_file_changed (GFileMonitor *monitor,
 		       GFile *file,
@@ -338,13 +528,17 @@ gnome_wp_file_changed (GFileMonitor *monitor,
 		       CcBackgroundXml *data)
 {
   gchar *filename;
+  GTask *task;
 
   switch (event_type) {
   case G_FILE_MONITOR_EVENT_CHANGED:
   case G_FILE_MONITOR_EVENT_CREATED:
+    /* Only the file that changed is parsed again, out of the main thread */
     filename = g_file_get_path (file);
-    cc_background_xml_load_xml_internal (data, filename, FALSE);
-    g_free (filename);
+    task = g_task_new (data, NULL, NULL, NULL);
+    g_task_set_task_data (task, filename, g_free);
+    g_task_run_in_thread (task, load_changed_file_thread);
+    g_object_unref (task);
     break;
   default:
     break;
@@ -380,10 +574,11 @@ cc_background_xml_add_monitor (GFile      *directory,
   data->priv->monitors = g_slist_prepend (data->priv->monitors, monitor);
 }
 
+/* Lists the files of the directory in jobs, and starts monitoring it */
 static void
 cc_background_xml_load_from_dir (const gchar      *path,
 				 CcBackgroundXml  *data,
-				 gboolean          in_thread)
+				 GPtrArray        *jobs)
 {
   GFile *directory;
   GFileEnumerator *enumerator;
@@ -409,14 +604,13 @@ cc_background_xml_load_from_dir (const gchar      *path,
 
   while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL))) {
     const gchar *filename;
-    gchar *fullpath;
+    ParseJob *job;
 
     filename = g_file_info_get_name (info);
-    fullpath = g_build_filename (path, filename, NULL);
+    job = g_new0 (ParseJob, 1);
+    job->filename = g_build_filename (path, filename, NULL);
+    g_ptr_array_add (jobs, job);
     g_object_unref (info);
-
-    cc_background_xml_load_xml_internal (data, fullpath, in_thread);
-    g_free (fullpath);
   }
   g_file_enumerator_close (enumerator, NULL, NULL);
 
@@ -427,17 +621,48 @@ cc_background_xml_load_from_dir (const gchar      *path,
 }
 
 static void
-cc_background_xml_load_list (CcBackgroundXml *data,
-			     gboolean         in_thread)
+parse_job_free (ParseJob *job)
+{
+  g_free (job->filename);
+  if (job->entries != NULL)
+    g_ptr_array_unref (job->entries);
+  g_free (job);
+}
+
+static void
+parse_job_run (ParseJob  *job,
+	       ParseJobs *jobs)
+{
+  GPtrArray *entries;
+
+  entries = cc_background_xml_load_entries (job->filename);
+
+  g_mutex_lock (&jobs->mutex);
+  job->entries = entries;
+  job->done = TRUE;
+  g_cond_broadcast (&jobs->cond);
+  g_mutex_unlock (&jobs->mutex);
+}
+
+/* Files are parsed in parallel, but their wallpapers are still queued in
+ * the order of the files, so that the same one wins among duplicates */
+static void
+cc_background_xml_load_list (CcBackgroundXml *data)
 {
   const char * const *system_data_dirs;
   gchar * datadir;
-  gint i;
+  GPtrArray *jobs;
+  GThreadPool *pool;
+  ParseJobs parse_jobs;
+  guint n_threads;
+  guint i;
+
+  jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) parse_job_free);
 
   datadir = g_build_filename (g_get_user_data_dir (),
                               "gnome-background-properties",
                               NULL);
-  cc_background_xml_load_from_dir (datadir, data, in_thread);
+  cc_background_xml_load_from_dir (datadir, data, jobs);
   g_free (datadir);
 
   system_data_dirs = g_get_system_data_dirs ();
@@ -445,9 +670,37 @@ cc_background_xml_load_list (CcBackgroundXml *data,
     datadir = g_build_filename (system_data_dirs[i],
                                 "gnome-background-properties",
 				NULL);
-    cc_background_xml_load_from_dir (datadir, data, in_thread);
+    cc_background_xml_load_from_dir (datadir, data, jobs);
     g_free (datadir);
   }
+
+  g_mutex_init (&parse_jobs.mutex);
+  g_cond_init (&parse_jobs.cond);
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_PARSE_THREADS);
+  pool = g_thread_pool_new ((GFunc) parse_job_run, &parse_jobs, n_threads, FALSE, NULL);
+  for (i = 0; i < jobs->len; i++)
+    g_thread_pool_push (pool, jobs->pdata[i], NULL);
+
+  for (i = 0; i < jobs->len; i++) {
+    ParseJob *job = jobs->pdata[i];
+    GPtrArray *entries;
+
+    g_mutex_lock (&parse_jobs.mutex);
+    while (!job->done)
+      g_cond_wait (&parse_jobs.cond, &parse_jobs.mutex);
+    entries = job->entries;
+    job->entries = NULL;
+    g_mutex_unlock (&parse_jobs.mutex);
+
+    if (entries != NULL)
+      emit_added_in_idle (data, entries);
+  }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_mutex_clear (&parse_jobs.mutex);
+  g_cond_clear (&parse_jobs.cond);
+  g_ptr_array_unref (jobs);
 }
 
 const GHashTable *
@@ -471,7 +724,7 @@ load_list_thread (GSimpleAsyncResult *res,
 	CcBackgroundXml *data;
 
 	data = g_simple_async_result_get_op_res_gpointer (res);
-	cc_background_xml_load_list (data, TRUE);
+	cc_background_xml_load_list (data);
 }
 
 void cc_background_xml_load_list_async (CcBackgroundXml *xml,
@@ -498,7 +751,7 @@ cc_background_xml_load_xml (CcBackgroundXml *xml,
 	if (g_file_test (filename, G_FILE_TEST_IS_REGULAR) == FALSE)
 		return FALSE;
 
-	return cc_background_xml_load_xml_internal (xml, filename, FALSE);
+	return cc_background_xml_load_xml_internal (xml, filename);
 }
 
 static void
@@ -648,6 +901,9 @@ cc_background_xml_class_init (CcBackgroundXmlClass *klass)
 {
         GObjectClass  *object_class = G_OBJECT_CLASS (klass);
 
+        /* Files are parsed from several threads */
+        xmlInitParser ();
+
         object_class->finalize = cc_background_xml_finalize;
 
 	signals[ADDED] = g_signal_new ("added",
@@ -669,7 +925,7 @@ cc_background_xml_init (CcBackgroundXml *xml)
 						    g_str_equal,
 						    (GDestroyNotify) g_free,
 						    (GDestroyNotify) g_object_unref);
-	xml->priv->item_added_queue = g_async_queue_new_full ((GDestroyNotify) g_object_unref);
+	xml->priv->item_added_queue = g_async_queue_new_full ((GDestroyNotify) xml_entry_free);
 }
 
 CcBackgroundXml *
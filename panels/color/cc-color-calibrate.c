@@ -25,13 +25,13 @@
 #include <gio/gunixfdlist.h>
 #include <glib/gi18n.h>
 #include <glib-object.h>
-#include <math.h>
 #include <colord-session/cd-session.h>
 
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-rr.h>
 
 #include "cc-color-calibrate.h"
+#include "cc-color-gamma-ramp.h"
 
 #define CC_COLOR_CALIBRATE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), CC_TYPE_COLOR_CALIBRATE, CcColorCalibratePrivate))
 
@@ -53,6 +53,7 @@ struct _CcColorCalibratePrivate
   GtkWindow       *window;
   GtkWidget       *sample_widget;
   guint            gamma_size;
+  CcColorGammaRamp *gamma_ramp;
   CdProfileQuality quality;
   guint            target_whitepoint;   /* in Kelvin */
   gdouble          target_gamma;
@@ -200,7 +201,10 @@ cc_color_calibrate_calib_setup_screen (CcColorCalibrate *calibrate,
                            CD_SESSION_ERROR,
                            CD_SESSION_ERROR_INTERNAL,
                            "gamma size is zero");
+      goto out;
     }
+  cc_color_gamma_ramp_free (priv->gamma_ramp);
+  priv->gamma_ramp = cc_color_gamma_ramp_new (priv->gamma_size);
 out:
   return ret;
 }
@@ -219,20 +223,12 @@ out:
  **/
 static gboolean
 cc_color_calibrate_calib_set_output_gamma (CcColorCalibrate *calibrate,
-                                           GPtrArray *array,
+                                           GArray *array,
                                            GError **error)
 {
   CcColorCalibratePrivate *priv = calibrate->priv;
-  CdColorRGB *p1;
-  CdColorRGB *p2;
-  CdColorRGB result;
   gboolean ret = TRUE;
-  gdouble mix;
   GnomeRRCrtc *crtc;
-  guint16 *blue = NULL;
-  guint16 *green = NULL;
-  guint16 *red = NULL;
-  guint i;
 
   /* no length? */
   if (array->len == 0)
@@ -245,26 +241,12 @@ cc_color_calibrate_calib_set_output_gamma (CcColorCalibrate *calibrate,
       goto out;
     }
 
-  /* convert to a type X understands of the right size */
-  red = g_new (guint16, priv->gamma_size);
-  green = g_new (guint16, priv->gamma_size);
-  blue = g_new (guint16, priv->gamma_size);
-  cd_color_rgb_set (&result, 1.0, 1.0, 1.0);
-  for (i = 0; i < priv->gamma_size; i++)
-    {
-      mix = (gdouble) (array->len - 1) /
-            (gdouble) (priv->gamma_size - 1) *
-            (gdouble) i;
-      p1 = g_ptr_array_index (array, (guint) floor (mix));
-      p2 = g_ptr_array_index (array, (guint) ceil (mix));
-      cd_color_rgb_interpolate (p1,
-                                p2,
-                                mix - (gint) mix,
-                                &result);
-      red[i] = result.R * 0xffff;
-      green[i] = result.G * 0xffff;
-      blue[i] = result.B * 0xffff;
-    }
+  /* convert to a type X understands of the right size, the helper asks
+   * for the same ramp for several patches in a row */
+  if (!cc_color_gamma_ramp_update (priv->gamma_ramp,
+                                   (const CdColorRGB *) array->data,
+                                   array->len))
+    goto out;
 
   /* send to LUT */
   crtc = gnome_rr_output_get_crtc (priv->output);
@@ -276,14 +258,14 @@ cc_color_calibrate_calib_set_output_gamma (CcColorCalibrate *calibrate,
                    CD_SESSION_ERROR_INTERNAL,
                    "failed to get ctrc for %s",
                    gnome_rr_output_get_name (priv->output));
+      cc_color_gamma_ramp_reset (priv->gamma_ramp);
       goto out;
     }
   gnome_rr_crtc_set_gamma (crtc, priv->gamma_size,
-                           red, green, blue);
+                           cc_color_gamma_ramp_get_red (priv->gamma_ramp),
+                           cc_color_gamma_ramp_get_green (priv->gamma_ramp),
+                           cc_color_gamma_ramp_get_blue (priv->gamma_ramp));
 out:
-  g_free (red);
-  g_free (green);
-  g_free (blue);
   return ret;
 }
 
@@ -496,7 +478,6 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
 {
   CcColorCalibratePrivate *priv = calibrate->priv;
   CdColorRGB color;
-  CdColorRGB *color_tmp;
   CdSessionInteraction code;
   const gchar *image = NULL;
   const gchar *message;
@@ -504,7 +485,7 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
   const gchar *str = NULL;
   gboolean ret;
   GError *error = NULL;
-  GPtrArray *array = NULL;
+  GArray *array = NULL;
   GtkImage *img;
   GtkLabel *label;
   GVariantIter *iter;
@@ -572,16 +553,13 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
       g_variant_get (parameters,
                      "(a(ddd))",
                      &iter);
-      array = g_ptr_array_new_with_free_func (g_free);
+      array = g_array_sized_new (FALSE, FALSE, sizeof (CdColorRGB),
+                                 g_variant_iter_n_children (iter));
       while (g_variant_iter_loop (iter, "(ddd)",
                                   &color.R,
                                   &color.G,
                                   &color.B))
-        {
-          color_tmp = cd_color_rgb_new ();
-          cd_color_rgb_copy (&color, color_tmp);
-          g_ptr_array_add (array, color_tmp);
-        }
+        g_array_append_val (array, color);
       g_variant_iter_free (iter);
       ret = cc_color_calibrate_calib_set_output_gamma (calibrate,
                                                        array,
@@ -599,6 +577,8 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
 out:
   if (dict != NULL)
     g_variant_unref (dict);
+  if (array != NULL)
+    g_array_unref (array);
 }
 
 static void
@@ -1044,6 +1024,7 @@ cc_color_calibrate_finalize (GObject *object)
   g_clear_object (&priv->proxy_inhibit);
   g_clear_object (&priv->sensor);
   g_clear_object (&priv->x11_screen);
+  g_clear_pointer (&priv->gamma_ramp, cc_color_gamma_ramp_free);
   g_free (priv->title);
   g_main_loop_unref (priv->loop);
 
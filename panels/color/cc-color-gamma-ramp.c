@@ -0,0 +1,230 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2012 Richard Hughes <richard@hughsie.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "cc-color-gamma-ramp.h"
+
+struct _CcColorGammaRamp
+{
+  guint     size;
+
+  /* interpolation weights for clut_len entries, entry i of the ramp is
+   * weight_lo[i] * clut[index_lo[i]] + weight_hi[i] * clut[index_hi[i]] */
+  guint     clut_len;
+  guint    *index_lo;
+  guint    *index_hi;
+  gdouble  *weight_lo;
+  gdouble  *weight_hi;
+
+  /* the CLUT, one array per channel */
+  guint     clut_allocated;
+  gdouble  *clut[3];
+
+  /* the ramp last handed out, and the one being built */
+  gboolean  valid;
+  guint16  *ramp[3];
+  guint16  *next[3];
+};
+
+CcColorGammaRamp *
+cc_color_gamma_ramp_new (guint size)
+{
+  CcColorGammaRamp *ramp;
+  guint c;
+
+  g_return_val_if_fail (size > 0, NULL);
+
+  ramp = g_new0 (CcColorGammaRamp, 1);
+  ramp->size = size;
+  ramp->index_lo = g_new (guint, size);
+  ramp->index_hi = g_new (guint, size);
+  ramp->weight_lo = g_new (gdouble, size);
+  ramp->weight_hi = g_new (gdouble, size);
+  for (c = 0; c < 3; c++)
+    {
+      ramp->ramp[c] = g_new0 (guint16, size);
+      ramp->next[c] = g_new0 (guint16, size);
+    }
+  return ramp;
+}
+
+void
+cc_color_gamma_ramp_free (CcColorGammaRamp *ramp)
+{
+  guint c;
+
+  if (ramp == NULL)
+    return;
+
+  g_free (ramp->index_lo);
+  g_free (ramp->index_hi);
+  g_free (ramp->weight_lo);
+  g_free (ramp->weight_hi);
+  for (c = 0; c < 3; c++)
+    {
+      g_free (ramp->clut[c]);
+      g_free (ramp->ramp[c]);
+      g_free (ramp->next[c]);
+    }
+  g_free (ramp);
+}
+
+/* This has to give the very same numbers as interpolating with
+ * cd_color_rgb_interpolate() between the two closest CLUT entries. */
+static void
+cc_color_gamma_ramp_set_clut_len (CcColorGammaRamp *ramp,
+                                  guint clut_len)
+{
+  gdouble mix;
+  guint i;
+
+  for (i = 0; i < ramp->size; i++)
+    {
+      /* a single entry ramp only ever looks at the first CLUT entry */
+      if (ramp->size == 1)
+        mix = 0.0;
+      else
+        mix = (gdouble) (clut_len - 1) /
+              (gdouble) (ramp->size - 1) *
+              (gdouble) i;
+      ramp->index_lo[i] = (guint) floor (mix);
+      ramp->index_hi[i] = (guint) ceil (mix);
+      ramp->weight_hi[i] = mix - (gint) mix;
+      ramp->weight_lo[i] = 1.0 - ramp->weight_hi[i];
+    }
+  ramp->clut_len = clut_len;
+}
+
+static void
+cc_color_gamma_ramp_fill_channel (CcColorGammaRamp *ramp,
+                                  const gdouble *clut,
+                                  guint16 *out)
+{
+  const guint *index_lo = ramp->index_lo;
+  const guint *index_hi = ramp->index_hi;
+  const gdouble *weight_lo = ramp->weight_lo;
+  const gdouble *weight_hi = ramp->weight_hi;
+  gdouble value;
+  guint i;
+
+  for (i = 0; i < ramp->size; i++)
+    {
+      value = weight_lo[i] * clut[index_lo[i]] + weight_hi[i] * clut[index_hi[i]];
+      out[i] = value * 0xffff;
+    }
+}
+
+/**
+ * cc_color_gamma_ramp_update:
+ *
+ * Builds the ramp for @clut, which has to have at least one entry.
+ *
+ * Returns: %TRUE if the ramp is different from the one built last time
+ **/
+gboolean
+cc_color_gamma_ramp_update (CcColorGammaRamp *ramp,
+                            const CdColorRGB *clut,
+                            guint clut_len)
+{
+  guint16 *tmp;
+  guint c;
+  guint i;
+
+  g_return_val_if_fail (clut_len > 0, FALSE);
+
+  /* the weights only depend on the lengths */
+  if (clut_len != ramp->clut_len)
+    cc_color_gamma_ramp_set_clut_len (ramp, clut_len);
+
+  /* split the channels so that each of them is filled in a plain loop */
+  if (clut_len > ramp->clut_allocated)
+    {
+      for (c = 0; c < 3; c++)
+        {
+          g_free (ramp->clut[c]);
+          ramp->clut[c] = g_new (gdouble, clut_len);
+        }
+      ramp->clut_allocated = clut_len;
+    }
+  for (i = 0; i < clut_len; i++)
+    {
+      ramp->clut[0][i] = clut[i].R;
+      ramp->clut[1][i] = clut[i].G;
+      ramp->clut[2][i] = clut[i].B;
+    }
+
+  for (c = 0; c < 3; c++)
+    cc_color_gamma_ramp_fill_channel (ramp, ramp->clut[c], ramp->next[c]);
+
+  if (ramp->valid)
+    {
+      for (c = 0; c < 3; c++)
+        {
+          if (memcmp (ramp->ramp[c], ramp->next[c], ramp->size * sizeof (guint16)) != 0)
+            break;
+        }
+      if (c == 3)
+        return FALSE;
+    }
+
+  for (c = 0; c < 3; c++)
+    {
+      tmp = ramp->ramp[c];
+      ramp->ramp[c] = ramp->next[c];
+      ramp->next[c] = tmp;
+    }
+  ramp->valid = TRUE;
+  return TRUE;
+}
+
+/* forget the last ramp, e.g. when something else might have changed the
+ * hardware gamma table */
+void
+cc_color_gamma_ramp_reset (CcColorGammaRamp *ramp)
+{
+  ramp->valid = FALSE;
+}
+
+guint
+cc_color_gamma_ramp_get_size (CcColorGammaRamp *ramp)
+{
+  return ramp->size;
+}
+
+guint16 *
+cc_color_gamma_ramp_get_red (CcColorGammaRamp *ramp)
+{
+  return ramp->ramp[0];
+}
+
+guint16 *
+cc_color_gamma_ramp_get_green (CcColorGammaRamp *ramp)
+{
+  return ramp->ramp[1];
+}
+
+guint16 *
+cc_color_gamma_ramp_get_blue (CcColorGammaRamp *ramp)
+{
+  return ramp->ramp[2];
+}
@@ -0,0 +1,45 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2012 Richard Hughes <richard@hughsie.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __CC_COLOR_GAMMA_RAMP_H__
+#define __CC_COLOR_GAMMA_RAMP_H__
+
+#include <glib.h>
+#include <colord.h>
+
+G_BEGIN_DECLS
+
+typedef struct _CcColorGammaRamp CcColorGammaRamp;
+
+CcColorGammaRamp *cc_color_gamma_ramp_new       (guint                    size);
+void              cc_color_gamma_ramp_free      (CcColorGammaRamp        *ramp);
+
+gboolean          cc_color_gamma_ramp_update    (CcColorGammaRamp        *ramp,
+                                                 const CdColorRGB        *clut,
+                                                 guint                    clut_len);
+void              cc_color_gamma_ramp_reset     (CcColorGammaRamp        *ramp);
+
+guint             cc_color_gamma_ramp_get_size  (CcColorGammaRamp        *ramp);
+guint16          *cc_color_gamma_ramp_get_red   (CcColorGammaRamp        *ramp);
+guint16          *cc_color_gamma_ramp_get_green (CcColorGammaRamp        *ramp);
+guint16          *cc_color_gamma_ramp_get_blue  (CcColorGammaRamp        *ramp);
+
+G_END_DECLS
+
+#endif /* __CC_COLOR_GAMMA_RAMP_H__ */
@@ -49,6 +49,8 @@ struct _CcColorPanelPrivate
   GPtrArray     *devices;
   GPtrArray     *sensors;
   GCancellable  *cancellable;
+  GCancellable  *assign_cancellable;
+  guint          devices_connecting;
   GDBusProxy    *proxy;
   GSettings     *settings;
   GSettings     *settings_colord;
@@ -108,9 +110,117 @@ enum {
 
 static void gcm_prefs_refresh_toolbar_buttons (CcColorPanel *panel);
 
+/* what the assign dialog needs to know about a profile, so that reopening
+ * it does not have to connect to every profile known to colord again */
+typedef struct
+{
+  gchar           *title;
+  CdProfileKind    kind;
+  CdColorspace     colorspace;
+  gchar           *data_source;
+  gchar           *standard_space;
+  gboolean         has_access;
+  gboolean         has_warnings;
+} GcmPrefsProfileInfo;
+
+/* object path -> GcmPrefsProfileInfo, kept across panel instances */
+static GHashTable *profile_info_cache = NULL;
+static CdClient *profile_info_client = NULL;
+
+static void
+gcm_prefs_profile_info_free (GcmPrefsProfileInfo *info)
+{
+  g_free (info->title);
+  g_free (info->data_source);
+  g_free (info->standard_space);
+  g_free (info);
+}
+
+static void
+gcm_prefs_profile_info_changed_cb (CdClient *client,
+                                   CdProfile *profile,
+                                   gpointer user_data)
+{
+  g_hash_table_remove (profile_info_cache,
+                       cd_profile_get_object_path (profile));
+}
+
+static void
+gcm_prefs_profile_info_client_changed_cb (CdClient *client,
+                                          gpointer user_data)
+{
+  g_hash_table_remove_all (profile_info_cache);
+}
+
+static void
+gcm_prefs_profile_info_ensure_cache (CdClient *client)
+{
+  if (profile_info_cache != NULL)
+    return;
+
+  profile_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify) gcm_prefs_profile_info_free);
+
+  /* the client is shared by the whole process, keep it around so that
+   * the cache hears about profiles changing while the panel is closed */
+  profile_info_client = g_object_ref (client);
+  g_signal_connect (profile_info_client, "profile-changed",
+                    G_CALLBACK (gcm_prefs_profile_info_changed_cb), NULL);
+  g_signal_connect (profile_info_client, "profile-removed",
+                    G_CALLBACK (gcm_prefs_profile_info_changed_cb), NULL);
+  g_signal_connect (profile_info_client, "changed",
+                    G_CALLBACK (gcm_prefs_profile_info_client_changed_cb), NULL);
+}
+
+static GcmPrefsProfileInfo *
+gcm_prefs_profile_info_lookup (CdClient *client,
+                               CdProfile *profile)
+{
+  gcm_prefs_profile_info_ensure_cache (client);
+  return g_hash_table_lookup (profile_info_cache,
+                              cd_profile_get_object_path (profile));
+}
+
+/* profile has to be connected */
+static GcmPrefsProfileInfo *
+gcm_prefs_profile_info_update (CdClient *client,
+                               CdProfile *profile)
+{
+  GcmPrefsProfileInfo *info;
+#if CD_CHECK_VERSION(0,1,25)
+  gchar **warnings;
+#endif
+
+  info = g_new0 (GcmPrefsProfileInfo, 1);
+  info->title = g_strdup (cd_profile_get_title (profile));
+  info->kind = cd_profile_get_kind (profile);
+  info->colorspace = cd_profile_get_colorspace (profile);
+  info->data_source = g_strdup (cd_profile_get_metadata_item (profile,
+                                                              CD_PROFILE_METADATA_DATA_SOURCE));
+  info->standard_space = g_strdup (cd_profile_get_metadata_item (profile,
+                                                                 CD_PROFILE_METADATA_STANDARD_SPACE));
+#if CD_CHECK_VERSION(0,1,13)
+  info->has_access = cd_profile_has_access (profile);
+#else
+  info->has_access = TRUE;
+#endif
+#if CD_CHECK_VERSION(0,1,25)
+  warnings = cd_profile_get_warnings (profile);
+  info->has_warnings = warnings != NULL && warnings[0] != NULL;
+#endif
+
+  gcm_prefs_profile_info_ensure_cache (client);
+  g_hash_table_replace (profile_info_cache,
+                        g_strdup (cd_profile_get_object_path (profile)),
+                        info);
+  return info;
+}
+
 static void
 gcm_prefs_combobox_add_profile (CcColorPanel *prefs,
                                 CdProfile *profile,
+                                GcmPrefsProfileInfo *info,
                                 GtkTreeIter *iter)
 {
   const gchar *id;
@@ -120,20 +230,16 @@ gcm_prefs_combobox_add_profile (CcColorPanel *prefs,
   gchar *escaped = NULL;
   guint kind = 0;
   const gchar *warning = NULL;
-#if CD_CHECK_VERSION(0,1,25)
-  gchar **warnings;
-#endif
 
   /* iter is optional */
   if (iter == NULL)
     iter = &iter_tmp;
 
   /* use description */
-  string = g_string_new (cd_profile_get_title (profile));
+  string = g_string_new (info->title);
 
   /* any source prefix? */
-  id = cd_profile_get_metadata_item (profile,
-                                     CD_PROFILE_METADATA_DATA_SOURCE);
+  id = info->data_source;
   if (g_strcmp0 (id, CD_PROFILE_METADATA_DATA_SOURCE_EDID) == 0)
     {
       /* TRANSLATORS: this is a profile prefix to signify the
@@ -159,11 +265,8 @@ gcm_prefs_combobox_add_profile (CcColorPanel *prefs,
 #endif
 
   /* is the profile faulty */
-#if CD_CHECK_VERSION(0,1,25)
-  warnings = cd_profile_get_warnings (profile);
-  if (warnings != NULL && warnings[0] != NULL)
+  if (info->has_warnings)
     warning = "dialog-warning-symbolic";
-#endif
 
   escaped = g_markup_escape_text (string->str, -1);
   list_store = GTK_LIST_STORE(gtk_builder_get_object (prefs->priv->builder,
@@ -651,13 +754,10 @@ gcm_prefs_calibrate_cb (GtkWidget *widget, CcColorPanel *prefs)
 }
 
 static gboolean
-gcm_prefs_is_profile_suitable_for_device (CdProfile *profile,
+gcm_prefs_is_profile_suitable_for_device (GcmPrefsProfileInfo *info,
                                           CdDevice *device)
 {
-  const gchar *data_source;
-  CdProfileKind profile_kind_tmp;
   CdProfileKind profile_kind;
-  CdColorspace profile_colorspace;
   CdColorspace device_colorspace = 0;
   gboolean ret = FALSE;
   CdDeviceKind device_kind;
@@ -665,18 +765,15 @@ gcm_prefs_is_profile_suitable_for_device (CdProfile *profile,
 
   /* not the right colorspace */
   device_colorspace = cd_device_get_colorspace (device);
-  profile_colorspace = cd_profile_get_colorspace (profile);
-  if (device_colorspace != profile_colorspace)
+  if (device_colorspace != info->colorspace)
     goto out;
 
   /* if this is a display matching with one of the standard spaces that displays
    * could emulate, also mark it as suitable */
   if (cd_device_get_kind (device) == CD_DEVICE_KIND_DISPLAY &&
-      cd_profile_get_kind (profile) == CD_PROFILE_KIND_DISPLAY_DEVICE)
+      info->kind == CD_PROFILE_KIND_DISPLAY_DEVICE)
       {
-        data_source = cd_profile_get_metadata_item (profile,
-                                                    CD_PROFILE_METADATA_STANDARD_SPACE);
-        standard_space = cd_standard_space_from_string (data_source);
+        standard_space = cd_standard_space_from_string (info->standard_space);
         if (standard_space == CD_STANDARD_SPACE_SRGB ||
             standard_space == CD_STANDARD_SPACE_ADOBE_RGB)
           {
@@ -687,15 +784,12 @@ gcm_prefs_is_profile_suitable_for_device (CdProfile *profile,
 
   /* not the correct kind */
   device_kind = cd_device_get_kind (device);
-  profile_kind_tmp = cd_profile_get_kind (profile);
   profile_kind = cd_device_kind_to_profile_kind (device_kind);
-  if (profile_kind_tmp != profile_kind)
+  if (info->kind != profile_kind)
     goto out;
 
   /* ignore the colorspace profiles */
-  data_source = cd_profile_get_metadata_item (profile,
-                                              CD_PROFILE_METADATA_DATA_SOURCE);
-  if (g_strcmp0 (data_source, CD_PROFILE_METADATA_DATA_SOURCE_STANDARD) == 0)
+  if (g_strcmp0 (info->data_source, CD_PROFILE_METADATA_DATA_SOURCE_STANDARD) == 0)
     goto out;
 
   /* success */
@@ -738,6 +832,7 @@ gcm_prefs_combo_sort_func_cb (GtkTreeModel *model,
   return retval;
 }
 
+/* the profiles are not necessarily connected, so compare the object paths */
 static gboolean
 gcm_prefs_profile_exists_in_array (GPtrArray *array, CdProfile *profile)
 {
@@ -747,96 +842,177 @@ gcm_prefs_profile_exists_in_array (GPtrArray *array, CdProfile *profile)
   for (i = 0; i < array->len; i++)
     {
       profile_tmp = g_ptr_array_index (array, i);
-      if (cd_profile_equal (profile, profile_tmp))
+      if (g_strcmp0 (cd_profile_get_object_path (profile),
+                     cd_profile_get_object_path (profile_tmp)) == 0)
          return TRUE;
     }
   return FALSE;
 }
 
+typedef struct
+{
+  CcColorPanel  *prefs;
+  GCancellable  *cancellable;
+  CdDevice      *device;
+  GPtrArray     *profiles;
+} GcmPrefsAssignData;
+
 static void
-gcm_prefs_add_profiles_suitable_for_devices (CcColorPanel *prefs,
-                                             GPtrArray *profiles)
+gcm_prefs_assign_data_free (GcmPrefsAssignData *data)
 {
-  CdProfile *profile_tmp;
-  gboolean ret;
+  g_object_unref (data->cancellable);
+  g_object_unref (data->device);
+  if (data->profiles != NULL)
+    g_ptr_array_unref (data->profiles);
+  g_free (data);
+}
+
+static void
+gcm_prefs_assign_add_profile (GcmPrefsAssignData *data,
+                              CdProfile *profile,
+                              GcmPrefsProfileInfo *info)
+{
+  /* only add correct types */
+  if (!gcm_prefs_is_profile_suitable_for_device (info, data->device))
+    return;
+
+  /* ignore profiles from other user accounts */
+  if (!info->has_access)
+    return;
+
+  gcm_prefs_combobox_add_profile (data->prefs, profile, info, NULL);
+}
+
+static void
+gcm_prefs_assign_profile_connect_cb (GObject *object,
+                                     GAsyncResult *res,
+                                     gpointer user_data)
+{
+  GcmPrefsAssignData *data = user_data;
+  CdProfile *profile = CD_PROFILE (object);
+  GcmPrefsProfileInfo *info;
   GError *error = NULL;
-  GPtrArray *profile_array = NULL;
-  GtkTreeIter iter;
-  GtkListStore *list_store;
-  GtkWidget *widget;
-  guint i;
-  CcColorPanelPrivate *priv = prefs->priv;
 
-  list_store = GTK_LIST_STORE(gtk_builder_get_object (prefs->priv->builder,
-                                                      "liststore_assign"));
-  gtk_list_store_clear (list_store);
-  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (list_store),
-                                        GCM_PREFS_COMBO_COLUMN_TEXT,
-                                        GTK_SORT_ASCENDING);
-  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (list_store),
-                                   GCM_PREFS_COMBO_COLUMN_TEXT,
-                                   gcm_prefs_combo_sort_func_cb,
-                                   list_store, NULL);
+  if (!cd_profile_connect_finish (profile, res, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("failed to get profile: %s", error->message);
+      g_error_free (error);
+      goto out;
+    }
 
-  widget = GTK_WIDGET (gtk_builder_get_object (prefs->priv->builder,
-                                               "label_assign_warning"));
-  gtk_widget_hide (widget);
+  /* the dialog has been refilled or the panel closed since */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    goto out;
 
-  /* get profiles */
-  profile_array = cd_client_get_profiles_sync (priv->client,
-                                               priv->cancellable,
-                                               &error);
+  info = gcm_prefs_profile_info_update (data->prefs->priv->client, profile);
+  gcm_prefs_assign_add_profile (data, profile, info);
+out:
+  gcm_prefs_assign_data_free (data);
+}
+
+static void
+gcm_prefs_assign_get_profiles_cb (GObject *object,
+                                  GAsyncResult *res,
+                                  gpointer user_data)
+{
+  GcmPrefsAssignData *data = user_data;
+  GcmPrefsAssignData *data_tmp;
+  GcmPrefsProfileInfo *info;
+  CdProfile *profile_tmp;
+  GError *error = NULL;
+  GPtrArray *profile_array;
+  guint i;
+
+  profile_array = cd_client_get_profiles_finish (CD_CLIENT (object), res, &error);
   if (profile_array == NULL)
     {
-      g_warning ("failed to get profiles: %s",
-           error->message);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("failed to get profiles: %s", error->message);
       g_error_free (error);
       goto out;
     }
+  if (g_cancellable_is_cancelled (data->cancellable))
+    goto out;
 
-  /* add profiles of the right kind */
+  /* add profiles of the right kind, connecting to all the ones we know
+   * nothing about at once and adding them as they come in */
   for (i = 0; i < profile_array->len; i++)
     {
       profile_tmp = g_ptr_array_index (profile_array, i);
 
-      /* get properties */
-      ret = cd_profile_connect_sync (profile_tmp,
-                                     priv->cancellable,
-                                     &error);
-      if (!ret)
-        {
-          g_warning ("failed to get profile: %s", error->message);
-          g_error_free (error);
-          goto out;
-        }
-
       /* don't add any of the already added profiles */
-      if (profiles != NULL)
+      if (data->profiles != NULL)
         {
-          if (gcm_prefs_profile_exists_in_array (profiles, profile_tmp))
+          if (gcm_prefs_profile_exists_in_array (data->profiles, profile_tmp))
             continue;
         }
 
-      /* only add correct types */
-      ret = gcm_prefs_is_profile_suitable_for_device (profile_tmp,
-                                                      priv->current_device);
-      if (!ret)
-        continue;
-
-#if CD_CHECK_VERSION(0,1,13)
-      /* ignore profiles from other user accounts */
-      if (!cd_profile_has_access (profile_tmp))
-        continue;
-#endif
+      info = gcm_prefs_profile_info_lookup (data->prefs->priv->client, profile_tmp);
+      if (info != NULL)
+        {
+          gcm_prefs_assign_add_profile (data, profile_tmp, info);
+          continue;
+        }
 
-      /* add */
-      gcm_prefs_combobox_add_profile (prefs,
-                                      profile_tmp,
-                                      &iter);
+      data_tmp = g_new0 (GcmPrefsAssignData, 1);
+      data_tmp->prefs = data->prefs;
+      data_tmp->cancellable = g_object_ref (data->cancellable);
+      data_tmp->device = g_object_ref (data->device);
+      cd_profile_connect (profile_tmp,
+                          data->cancellable,
+                          gcm_prefs_assign_profile_connect_cb,
+                          data_tmp);
     }
 out:
   if (profile_array != NULL)
     g_ptr_array_unref (profile_array);
+  gcm_prefs_assign_data_free (data);
+}
+
+static void
+gcm_prefs_add_profiles_suitable_for_devices (CcColorPanel *prefs,
+                                             GPtrArray *profiles)
+{
+  GcmPrefsAssignData *data;
+  GtkListStore *list_store;
+  GtkWidget *widget;
+  CcColorPanelPrivate *priv = prefs->priv;
+
+  list_store = GTK_LIST_STORE(gtk_builder_get_object (prefs->priv->builder,
+                                                      "liststore_assign"));
+  gtk_list_store_clear (list_store);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (list_store),
+                                        GCM_PREFS_COMBO_COLUMN_TEXT,
+                                        GTK_SORT_ASCENDING);
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (list_store),
+                                   GCM_PREFS_COMBO_COLUMN_TEXT,
+                                   gcm_prefs_combo_sort_func_cb,
+                                   list_store, NULL);
+
+  widget = GTK_WIDGET (gtk_builder_get_object (prefs->priv->builder,
+                                               "label_assign_warning"));
+  gtk_widget_hide (widget);
+
+  /* drop anything still coming in for the previous fill */
+  if (priv->assign_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->assign_cancellable);
+      g_object_unref (priv->assign_cancellable);
+    }
+  priv->assign_cancellable = g_cancellable_new ();
+
+  /* get profiles */
+  data = g_new0 (GcmPrefsAssignData, 1);
+  data->prefs = prefs;
+  data->cancellable = g_object_ref (priv->assign_cancellable);
+  data->device = g_object_ref (priv->current_device);
+  if (profiles != NULL)
+    data->profiles = g_ptr_array_ref (profiles);
+  cd_client_get_profiles (priv->client,
+                          priv->assign_cancellable,
+                          gcm_prefs_assign_get_profiles_cb,
+                          data);
 }
 
 static void
@@ -1433,16 +1609,13 @@ gcm_prefs_profiles_treeview_clicked_cb (GtkTreeSelection *selection,
   GtkWidget *widget;
   GtkTreeModel *model;
   GtkTreeIter iter;
-  CdProfile *profile = NULL;
-#if CD_CHECK_VERSION(0,1,25)
-  gchar **warnings;
-#endif
+  gchar *warning = NULL;
 
   /* get selection */
   if (!gtk_tree_selection_get_selected (selection, &model, &iter))
     return;
   gtk_tree_model_get (model, &iter,
-                      GCM_PREFS_COMBO_COLUMN_PROFILE, &profile,
+                      GCM_PREFS_COMBO_COLUMN_WARNING_FILENAME, &warning,
                       -1);
 
 
@@ -1454,13 +1627,8 @@ gcm_prefs_profiles_treeview_clicked_cb (GtkTreeSelection *selection,
   /* is the profile faulty */
   widget = GTK_WIDGET (gtk_builder_get_object (prefs->priv->builder,
                                                "label_assign_warning"));
-#if CD_CHECK_VERSION(0,1,25)
-  warnings = cd_profile_get_warnings (profile);
-  gtk_widget_set_visible (widget, warnings != NULL && warnings[0] != NULL);
-#else
-  gtk_widget_set_visible (widget, FALSE);
-#endif
-  g_object_unref (profile);
+  gtk_widget_set_visible (widget, warning != NULL);
+  g_free (warning);
 }
 
 static void
@@ -1572,28 +1740,90 @@ gcm_prefs_client_sensor_changed_cb (CdClient *client,
   gcm_prefs_set_calibrate_button_sensitivity (prefs);
 }
 
+typedef struct
+{
+  CcColorPanel  *prefs;
+  GCancellable  *cancellable;
+  CdDevice      *device;
+  gboolean       is_default;
+} GcmPrefsConnectData;
+
+static GcmPrefsConnectData *
+gcm_prefs_connect_data_new (CcColorPanel *prefs,
+                            CdDevice *device,
+                            gboolean is_default)
+{
+  GcmPrefsConnectData *data;
+
+  data = g_new0 (GcmPrefsConnectData, 1);
+  data->prefs = prefs;
+  data->cancellable = g_object_ref (prefs->priv->cancellable);
+  data->device = g_object_ref (device);
+  data->is_default = is_default;
+  return data;
+}
+
 static void
-gcm_prefs_add_device_profile (CcColorPanel *prefs,
-                              CdDevice *device,
-                              CdProfile *profile,
-                              gboolean is_default)
+gcm_prefs_connect_data_free (GcmPrefsConnectData *data)
 {
-  CcColorPanelPrivate *priv = prefs->priv;
-  gboolean ret;
+  g_object_unref (data->cancellable);
+  g_object_unref (data->device);
+  g_free (data);
+}
+
+static CdDevice *
+gcm_prefs_find_device_by_object_path (GPtrArray *devices,
+                                      const gchar *object_path)
+{
+  CdDevice *device_tmp;
+  guint i;
+
+  for (i = 0; i < devices->len; i++)
+    {
+      device_tmp = g_ptr_array_index (devices, i);
+      if (g_strcmp0 (cd_device_get_object_path (device_tmp), object_path) == 0)
+        return device_tmp;
+    }
+  return NULL;
+}
+
+static gboolean gcm_prefs_find_widget_by_object_path (GList *list,
+                                                      const gchar *object_path_device,
+                                                      const gchar *object_path_profile);
+
+static void
+gcm_prefs_device_profile_connect_cb (GObject *object,
+                                     GAsyncResult *res,
+                                     gpointer user_data)
+{
+  GcmPrefsConnectData *data = user_data;
+  CdProfile *profile = CD_PROFILE (object);
+  CcColorPanelPrivate *priv;
   GError *error = NULL;
+  GList *list;
   GtkWidget *widget;
+  gboolean ret;
 
-  /* get properties */
-  ret = cd_profile_connect_sync (profile,
-                                 priv->cancellable,
-                                 &error);
-  if (!ret)
+  if (!cd_profile_connect_finish (profile, res, &error))
     {
-      g_warning ("failed to get profile: %s", error->message);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("failed to get profile: %s", error->message);
       g_error_free (error);
       goto out;
     }
 
+  /* an already connected profile completes even if the panel has gone */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    goto out;
+  priv = data->prefs->priv;
+
+  gcm_prefs_profile_info_update (priv->client, profile);
+
+  /* the device was removed in the meantime */
+  if (gcm_prefs_find_device_by_object_path (priv->devices,
+                                            cd_device_get_object_path (data->device)) != data->device)
+    goto out;
+
   /* ignore profiles from other user accounts */
   if (!cd_profile_has_access (profile))
     {
@@ -1611,13 +1841,35 @@ gcm_prefs_add_device_profile (CcColorPanel *prefs,
       goto out;
     }
 
-  /* add to listbox */
-  widget = cc_color_profile_new (device, profile, is_default);
+  /* Device.Profiles might have changed twice before we got here */
+  list = gtk_container_get_children (GTK_CONTAINER (priv->list_box));
+  ret = gcm_prefs_find_widget_by_object_path (list,
+                                              cd_device_get_object_path (data->device),
+                                              cd_profile_get_object_path (profile));
+  g_list_free (list);
+  if (ret)
+    goto out;
+
+  /* add to listbox, the sort function puts it in place */
+  widget = cc_color_profile_new (data->device, profile, data->is_default);
   gtk_widget_show (widget);
   gtk_container_add (GTK_CONTAINER (priv->list_box), widget);
   gtk_size_group_add_widget (priv->list_box_size, widget);
 out:
-  return;
+  gcm_prefs_connect_data_free (data);
+}
+
+static void
+gcm_prefs_add_device_profile (CcColorPanel *prefs,
+                              CdDevice *device,
+                              CdProfile *profile,
+                              gboolean is_default)
+{
+  /* get properties, the row gets added when they arrive */
+  cd_profile_connect (profile,
+                      prefs->priv->cancellable,
+                      gcm_prefs_device_profile_connect_cb,
+                      gcm_prefs_connect_data_new (prefs, device, is_default));
 }
 
 static void
@@ -1783,21 +2035,48 @@ gcm_prefs_device_expanded_changed_cb (CcColorDevice *widget,
   gtk_list_box_invalidate_filter (priv->list_box);
 }
 
+static void gcm_prefs_update_device_list_extra_entry (CcColorPanel *prefs);
+
 static void
-gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
+gcm_prefs_device_connect_cb (GObject *object,
+                             GAsyncResult *res,
+                             gpointer user_data)
 {
-  CcColorPanelPrivate *priv = prefs->priv;
-  gboolean ret;
+  GcmPrefsConnectData *data = user_data;
+  CdDevice *device = CD_DEVICE (object);
+  CcColorPanel *prefs;
+  CcColorPanelPrivate *priv;
   GError *error = NULL;
   GtkWidget *widget;
+  gboolean ret;
+
+  ret = cd_device_connect_finish (device, res, &error);
+  if (g_cancellable_is_cancelled (data->cancellable))
+    {
+      g_clear_error (&error);
+      goto out;
+    }
+  prefs = data->prefs;
+  priv = prefs->priv;
+  priv->devices_connecting--;
+
+  /* the device was removed in the meantime */
+  if (gcm_prefs_find_device_by_object_path (priv->devices,
+                                            cd_device_get_object_path (device)) != device)
+    {
+      g_clear_error (&error);
+      goto update;
+    }
 
-  /* get device properties */
-  ret = cd_device_connect_sync (device, priv->cancellable, &error);
   if (!ret)
     {
       g_warning ("failed to connect to the device: %s", error->message);
       g_error_free (error);
-      goto out;
+      g_signal_handlers_disconnect_by_func (device,
+                                            G_CALLBACK (gcm_prefs_device_changed_cb),
+                                            prefs);
+      g_ptr_array_remove (priv->devices, device);
+      goto update;
     }
 
   /* add device */
@@ -1810,14 +2089,33 @@ gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
 
   /* add profiles */
   gcm_prefs_add_device_profiles (prefs, device);
+  gtk_list_box_invalidate_sort (priv->list_box);
+update:
+  /* only decide on the 'No devices detected' entry and on expanding a
+   * lone device once everything we know about is there */
+  if (priv->devices_connecting == 0)
+    gcm_prefs_update_device_list_extra_entry (prefs);
+out:
+  gcm_prefs_connect_data_free (data);
+}
+
+static void
+gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
 
   /* watch for changes */
   g_ptr_array_add (priv->devices, g_object_ref (device));
   g_signal_connect (device, "changed",
                     G_CALLBACK (gcm_prefs_device_changed_cb), prefs);
-  gtk_list_box_invalidate_sort (priv->list_box);
-out:
-  return;
+
+  /* get device properties, all the devices are connected at once and
+   * get a row as soon as they answer */
+  priv->devices_connecting++;
+  cd_device_connect (device,
+                     priv->cancellable,
+                     gcm_prefs_device_connect_cb,
+                     gcm_prefs_connect_data_new (prefs, device, FALSE));
 }
 
 static void
@@ -1842,22 +2140,36 @@ gcm_prefs_remove_device (CcColorPanel *prefs, CdDevice *device)
         }
     }
   g_list_free (list);
-  g_signal_handlers_disconnect_by_func (device,
+
+  /* the client hands us a new object for the same device */
+  device_tmp = gcm_prefs_find_device_by_object_path (priv->devices,
+                                                     cd_device_get_object_path (device));
+  if (device_tmp == NULL)
+    return;
+  g_signal_handlers_disconnect_by_func (device_tmp,
                                         G_CALLBACK (gcm_prefs_device_changed_cb),
                                         prefs);
-  g_ptr_array_remove (priv->devices, device);
+  g_ptr_array_remove (priv->devices, device_tmp);
 }
 
 static void
 gcm_prefs_update_device_list_extra_entry (CcColorPanel *prefs)
 {
   CcColorPanelPrivate *priv = prefs->priv;
-  GList *device_widgets;
+  GList *device_widgets = NULL;
+  GList *l;
+  GList *list;
   GtkWidget *widget;
   guint number_of_devices;
 
   /* any devices to show? */
-  device_widgets = gtk_container_get_children (GTK_CONTAINER (priv->list_box));
+  list = gtk_container_get_children (GTK_CONTAINER (priv->list_box));
+  for (l = list; l != NULL; l = l->next)
+    {
+      if (CC_IS_COLOR_DEVICE (l->data))
+        device_widgets = g_list_prepend (device_widgets, l->data);
+    }
+  g_list_free (list);
   number_of_devices = g_list_length (device_widgets);
   widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
                                                "label_no_devices"));
@@ -1877,11 +2189,9 @@ gcm_prefs_device_added_cb (CdClient *client,
                            CdDevice *device,
                            CcColorPanel *prefs)
 {
-  /* add the device */
+  /* add the device, this updates the 'No devices detected' entry once
+   * it is connected */
   gcm_prefs_add_device (prefs, device);
-
-  /* ensure we're not showing the 'No devices detected' entry */
-  gcm_prefs_update_device_list_extra_entry (prefs);
 }
 
 static void
@@ -1924,7 +2234,8 @@ gcm_prefs_get_devices_cb (GObject *object,
     }
 
   /* ensure we show the 'No devices detected' entry if empty */
-  gcm_prefs_update_device_list_extra_entry (prefs);
+  if (prefs->priv->devices_connecting == 0)
+    gcm_prefs_update_device_list_extra_entry (prefs);
 out:
   if (devices != NULL)
     g_ptr_array_unref (devices);
@@ -2150,6 +2461,9 @@ cc_color_panel_dispose (GObject *object)
 
   if (priv->cancellable != NULL)
     g_cancellable_cancel (priv->cancellable);
+  if (priv->assign_cancellable != NULL)
+    g_cancellable_cancel (priv->assign_cancellable);
+  g_clear_object (&priv->assign_cancellable);
   g_clear_object (&priv->settings);
   g_clear_object (&priv->settings_colord);
   g_clear_object (&priv->cancellable);
@@ -0,0 +1,160 @@
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+#include <colord.h>
+
+#include "cc-color-gamma-ramp.h"
+
+/* How cc_color_calibrate_calib_set_output_gamma() used to build the ramp */
+static void
+build_reference_ramp (GPtrArray *array,
+                      guint gamma_size,
+                      guint16 *red,
+                      guint16 *green,
+                      guint16 *blue)
+{
+  CdColorRGB *p1;
+  CdColorRGB *p2;
+  CdColorRGB result;
+  gdouble mix;
+  guint i;
+
+  cd_color_rgb_set (&result, 1.0, 1.0, 1.0);
+  for (i = 0; i < gamma_size; i++)
+    {
+      mix = (gdouble) (array->len - 1) /
+            (gdouble) (gamma_size - 1) *
+            (gdouble) i;
+      p1 = g_ptr_array_index (array, (guint) floor (mix));
+      p2 = g_ptr_array_index (array, (guint) ceil (mix));
+      cd_color_rgb_interpolate (p1,
+                                p2,
+                                mix - (gint) mix,
+                                &result);
+      red[i] = result.R * 0xffff;
+      green[i] = result.G * 0xffff;
+      blue[i] = result.B * 0xffff;
+    }
+}
+
+static GArray *
+random_clut (guint len)
+{
+  GArray *clut;
+  CdColorRGB color;
+  guint i;
+
+  clut = g_array_sized_new (FALSE, FALSE, sizeof (CdColorRGB), len);
+  for (i = 0; i < len; i++)
+    {
+      cd_color_rgb_set (&color,
+                        g_test_rand_double_range (0.0, 1.0),
+                        g_test_rand_double_range (0.0, 1.0),
+                        g_test_rand_double_range (0.0, 1.0));
+      g_array_append_val (clut, color);
+    }
+
+  return clut;
+}
+
+static void
+check_ramp (CcColorGammaRamp *ramp,
+            GArray *clut)
+{
+  GPtrArray *array;
+  guint16 *red;
+  guint16 *green;
+  guint16 *blue;
+  guint size;
+  guint i;
+
+  size = cc_color_gamma_ramp_get_size (ramp);
+  array = g_ptr_array_new ();
+  for (i = 0; i < clut->len; i++)
+    g_ptr_array_add (array, &g_array_index (clut, CdColorRGB, i));
+
+  red = g_new (guint16, size);
+  green = g_new (guint16, size);
+  blue = g_new (guint16, size);
+  build_reference_ramp (array, size, red, green, blue);
+
+  g_assert (memcmp (cc_color_gamma_ramp_get_red (ramp), red, size * sizeof (guint16)) == 0);
+  g_assert (memcmp (cc_color_gamma_ramp_get_green (ramp), green, size * sizeof (guint16)) == 0);
+  g_assert (memcmp (cc_color_gamma_ramp_get_blue (ramp), blue, size * sizeof (guint16)) == 0);
+
+  g_free (red);
+  g_free (green);
+  g_free (blue);
+  g_ptr_array_unref (array);
+}
+
+static void
+test_matches_interpolation (void)
+{
+  const guint gamma_sizes[] = { 2, 3, 256, 1024, 4096 };
+  const guint clut_lens[] = { 1, 2, 3, 17, 256, 1000, 5000 };
+  CcColorGammaRamp *ramp;
+  GArray *clut;
+  guint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (gamma_sizes); i++)
+    {
+      ramp = cc_color_gamma_ramp_new (gamma_sizes[i]);
+
+      /* going back and forth between lengths recomputes the weights */
+      for (k = 0; k < 2; k++)
+        {
+          for (j = 0; j < G_N_ELEMENTS (clut_lens); j++)
+            {
+              clut = random_clut (clut_lens[j]);
+              cc_color_gamma_ramp_update (ramp,
+                                          (CdColorRGB *) clut->data,
+                                          clut->len);
+              check_ramp (ramp, clut);
+              g_array_unref (clut);
+            }
+        }
+
+      cc_color_gamma_ramp_free (ramp);
+    }
+}
+
+static void
+test_unchanged (void)
+{
+  CcColorGammaRamp *ramp;
+  GArray *clut;
+  GArray *other;
+
+  ramp = cc_color_gamma_ramp_new (256);
+  clut = random_clut (64);
+  other = random_clut (64);
+
+  g_assert (cc_color_gamma_ramp_update (ramp, (CdColorRGB *) clut->data, clut->len));
+  g_assert (!cc_color_gamma_ramp_update (ramp, (CdColorRGB *) clut->data, clut->len));
+  check_ramp (ramp, clut);
+
+  g_assert (cc_color_gamma_ramp_update (ramp, (CdColorRGB *) other->data, other->len));
+  check_ramp (ramp, other);
+
+  cc_color_gamma_ramp_reset (ramp);
+  g_assert (cc_color_gamma_ramp_update (ramp, (CdColorRGB *) other->data, other->len));
+  check_ramp (ramp, other);
+
+  g_array_unref (clut);
+  g_array_unref (other);
+  cc_color_gamma_ramp_free (ramp);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/color/gamma-ramp/matches-interpolation", test_matches_interpolation);
+  g_test_add_func ("/color/gamma-ramp/unchanged", test_unchanged);
+
+  return g_test_run ();
+}
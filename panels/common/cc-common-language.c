@@ -20,10 +20,12 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <locale.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
 
@@ -87,14 +89,13 @@ cc_common_language_get_iter_for_language (GtkTreeModel *model,
   return iter_for_language (model, lang, iter, FALSE);
 }
 
-gboolean
-cc_common_language_has_font (const gchar *locale)
+static gboolean
+language_code_has_font (const gchar *language_code)
 {
         const FcCharSet *charset;
         FcPattern       *pattern;
         FcObjectSet     *object_set;
         FcFontSet       *font_set;
-        gchar           *language_code;
         gboolean         is_displayable;
 
         is_displayable = FALSE;
@@ -102,9 +103,6 @@ cc_common_language_has_font (const gchar *locale)
         object_set = NULL;
         font_set = NULL;
 
-        if (!gnome_parse_locale (locale, &language_code, NULL, NULL, NULL))
-                return FALSE;
-
         charset = FcLangGetCharSet ((FcChar8 *) language_code);
         if (!charset) {
                 /* fontconfig does not know about this language */
@@ -140,7 +138,163 @@ cc_common_language_has_font (const gchar *locale)
         if (pattern != NULL)
                 FcPatternDestroy (pattern);
 
-        g_free (language_code);
+        return is_displayable;
+}
+
+/* Font coverage only depends on the language code, so it is checked once
+ * per language, and the results are kept on disk until fontconfig's
+ * caches get updated, which happens whenever fonts are added or removed.
+ * This can be used from any thread. */
+#define FONT_CACHE_GROUP "Languages"
+
+static GMutex      font_cache_lock;
+static GHashTable *font_cache;  /* language code -> GINT_TO_POINTER (has font + 1) */
+static gchar      *font_cache_stamp;
+static gboolean    font_cache_dirty;
+
+static gchar *
+get_font_cache_path (void)
+{
+        return g_build_filename (g_get_user_cache_dir (),
+                                 "gnome-control-center",
+                                 "language-fonts.ini",
+                                 NULL);
+}
+
+static gchar *
+get_fontconfig_stamp (void)
+{
+        FcStrList *dirs;
+        FcChar8 *dir;
+        gint64 newest = 0;
+
+        dirs = FcConfigGetCacheDirs (NULL);
+        if (dirs != NULL) {
+                while ((dir = FcStrListNext (dirs)) != NULL) {
+                        GStatBuf buf;
+
+                        if (g_stat ((const gchar *) dir, &buf) == 0)
+                                newest = MAX (newest, (gint64) buf.st_mtime);
+                }
+                FcStrListDone (dirs);
+        }
+
+        return g_strdup_printf ("%d-%" G_GINT64_FORMAT, FcGetVersion (), newest);
+}
+
+static void
+load_font_cache (void)
+{
+        GKeyFile *keyfile;
+        gchar *path, *stamp;
+        gchar **languages;
+        gsize i, n_languages;
+
+        font_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        font_cache_stamp = get_fontconfig_stamp ();
+
+        keyfile = g_key_file_new ();
+        path = get_font_cache_path ();
+
+        if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, NULL))
+                goto out;
+
+        stamp = g_key_file_get_string (keyfile, FONT_CACHE_GROUP, "Stamp", NULL);
+        if (g_strcmp0 (stamp, font_cache_stamp) != 0) {
+                g_free (stamp);
+                goto out;
+        }
+        g_free (stamp);
+
+        languages = g_key_file_get_keys (keyfile, FONT_CACHE_GROUP, &n_languages, NULL);
+        for (i = 0; i < n_languages; i++) {
+                gboolean has_font;
+
+                if (g_str_equal (languages[i], "Stamp"))
+                        continue;
+
+                has_font = g_key_file_get_boolean (keyfile, FONT_CACHE_GROUP, languages[i], NULL);
+                g_hash_table_insert (font_cache, g_strdup (languages[i]), GINT_TO_POINTER (has_font + 1));
+        }
+        g_strfreev (languages);
+
+ out:
+        g_free (path);
+        g_key_file_free (keyfile);
+}
+
+void
+cc_common_language_save_font_cache (void)
+{
+        GKeyFile *keyfile;
+        GHashTableIter iter;
+        gpointer key, value;
+        gchar *path, *dirname, *data;
+        gsize length;
+        GError *error = NULL;
+
+        g_mutex_lock (&font_cache_lock);
+
+        if (font_cache == NULL || !font_cache_dirty) {
+                g_mutex_unlock (&font_cache_lock);
+                return;
+        }
+
+        keyfile = g_key_file_new ();
+        g_key_file_set_string (keyfile, FONT_CACHE_GROUP, "Stamp", font_cache_stamp);
+
+        g_hash_table_iter_init (&iter, font_cache);
+        while (g_hash_table_iter_next (&iter, &key, &value))
+                g_key_file_set_boolean (keyfile, FONT_CACHE_GROUP, key, GPOINTER_TO_INT (value) - 1);
+
+        font_cache_dirty = FALSE;
+
+        g_mutex_unlock (&font_cache_lock);
+
+        data = g_key_file_to_data (keyfile, &length, NULL);
+        path = get_font_cache_path ();
+        dirname = g_path_get_dirname (path);
+
+        if (g_mkdir_with_parents (dirname, 0755) != 0 ||
+            !g_file_set_contents (path, data, length, &error)) {
+                g_debug ("Failed to save %s: %s", path,
+                         error ? error->message : g_strerror (errno));
+                g_clear_error (&error);
+        }
+
+        g_free (dirname);
+        g_free (path);
+        g_free (data);
+        g_key_file_free (keyfile);
+}
+
+gboolean
+cc_common_language_has_font (const gchar *locale)
+{
+        gchar           *language_code;
+        gpointer         cached;
+        gboolean         is_displayable;
+
+        if (!gnome_parse_locale (locale, &language_code, NULL, NULL, NULL))
+                return FALSE;
+
+        g_mutex_lock (&font_cache_lock);
+        if (font_cache == NULL)
+                load_font_cache ();
+        cached = g_hash_table_lookup (font_cache, language_code);
+        g_mutex_unlock (&font_cache_lock);
+
+        if (cached != NULL) {
+                g_free (language_code);
+                return GPOINTER_TO_INT (cached) - 1;
+        }
+
+        is_displayable = language_code_has_font (language_code);
+
+        g_mutex_lock (&font_cache_lock);
+        g_hash_table_insert (font_cache, language_code, GINT_TO_POINTER (is_displayable + 1));
+        font_cache_dirty = TRUE;
+        g_mutex_unlock (&font_cache_lock);
 
         return is_displayable;
 }
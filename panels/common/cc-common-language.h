@@ -43,6 +43,7 @@ guint    cc_common_language_add_available_languages (GtkListStore     *store,
                                                      gboolean          regions,
                                                      GHashTable       *user_langs);
 gboolean cc_common_language_has_font                (const gchar  *locale);
+void     cc_common_language_save_font_cache         (void);
 gchar   *cc_common_language_get_current_language    (void);
 
 GHashTable *cc_common_language_get_initial_languages   (void);
@@ -46,6 +46,8 @@ typedef struct {
         gboolean showing_extra;
         gchar *language;
         gchar **filter_words;
+        GHashTable *initial_languages;
+        GCancellable *cancellable;
 } CcLanguageChooserPrivate;
 
 #define GET_PRIVATE(chooser) ((CcLanguageChooserPrivate *) g_object_get_data (G_OBJECT (chooser), "private"))
@@ -109,6 +111,14 @@ language_widget_new (const gchar *locale_id,
         g_object_set_data_full (G_OBJECT (row), "locale-untranslated-name", locale_untranslated_name, g_free);
         g_object_set_data (G_OBJECT (row), "is-extra", GUINT_TO_POINTER (is_extra));
 
+        /* Normalized once here, so that filtering only has to match them */
+        g_object_set_data_full (G_OBJECT (row), "locale-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_name), g_free);
+        g_object_set_data_full (G_OBJECT (row), "locale-current-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_current_name), g_free);
+        g_object_set_data_full (G_OBJECT (row), "locale-untranslated-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_untranslated_name), g_free);
+
         return row;
 }
 
@@ -142,45 +152,121 @@ no_results_widget_new (void)
         return widget;
 }
 
+/* Checking font coverage is slow, so it happens in a thread, and the
+ * rows for the languages that can be displayed are added in batches as
+ * they get verified. */
+#define LANGUAGE_BATCH_SIZE 16
+
+typedef struct {
+        GtkDialog *chooser;
+        GPtrArray *locale_ids;
+} LanguageBatch;
+
 static void
-add_languages (GtkDialog   *chooser,
-               gchar      **locale_ids,
-               GHashTable  *initial)
+add_language (GtkDialog   *chooser,
+              const gchar *locale_id)
 {
         CcLanguageChooserPrivate *priv = GET_PRIVATE (chooser);
+        gboolean is_extra;
+        GtkWidget *widget;
+
+        /* make sure the selected language is shown, as in set_locale_id() */
+        is_extra = g_hash_table_lookup (priv->initial_languages, locale_id) == NULL &&
+                   g_strcmp0 (locale_id, priv->language) != 0;
+
+        widget = language_widget_new (locale_id, priv->language, is_extra);
+        gtk_container_add (GTK_CONTAINER (priv->language_list), widget);
+        gtk_widget_show_all (widget);
+}
+
+static gboolean
+add_language_batch (gpointer user_data)
+{
+        LanguageBatch *batch = user_data;
+        CcLanguageChooserPrivate *priv = GET_PRIVATE (batch->chooser);
+        guint i;
+
+        if (!g_cancellable_is_cancelled (priv->cancellable)) {
+                for (i = 0; i < batch->locale_ids->len; i++)
+                        add_language (batch->chooser, g_ptr_array_index (batch->locale_ids, i));
+        }
+
+        g_ptr_array_unref (batch->locale_ids);
+        g_object_unref (batch->chooser);
+        g_free (batch);
 
-        while (*locale_ids) {
-                gchar *locale_id;
-                gboolean is_initial;
-                GtkWidget *widget;
+        return G_SOURCE_REMOVE;
+}
 
-                locale_id = *locale_ids;
-                locale_ids ++;
+static void
+queue_language_batch (GtkDialog *chooser,
+                      GPtrArray *locale_ids)
+{
+        LanguageBatch *batch;
 
-                if (!cc_common_language_has_font (locale_id))
+        batch = g_new0 (LanguageBatch, 1);
+        batch->chooser = g_object_ref (chooser);
+        batch->locale_ids = locale_ids;
+
+        g_idle_add (add_language_batch, batch);
+}
+
+static void
+check_fonts_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+        gchar **locale_ids = task_data;
+        GPtrArray *batch;
+
+        batch = g_ptr_array_new_with_free_func (g_free);
+
+        for (; *locale_ids; locale_ids++) {
+                if (g_cancellable_is_cancelled (cancellable))
+                        break;
+
+                if (!cc_common_language_has_font (*locale_ids))
                         continue;
 
-                is_initial = (g_hash_table_lookup (initial, locale_id) != NULL);
-                widget = language_widget_new (locale_id, priv->language, !is_initial);
-                gtk_container_add (GTK_CONTAINER (priv->language_list), widget);
+                g_ptr_array_add (batch, g_strdup (*locale_ids));
+                if (batch->len == LANGUAGE_BATCH_SIZE) {
+                        queue_language_batch (source_object, batch);
+                        batch = g_ptr_array_new_with_free_func (g_free);
+                }
         }
 
-        gtk_container_add (GTK_CONTAINER (priv->language_list), GTK_WIDGET (priv->more_item));
+        if (batch->len > 0)
+                queue_language_batch (source_object, batch);
+        else
+                g_ptr_array_unref (batch);
 
-        gtk_widget_show_all (priv->language_list);
+        g_task_return_boolean (task, TRUE);
+}
+
+static void
+check_fonts_done (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+        cc_common_language_save_font_cache ();
 }
 
 static void
 add_all_languages (GtkDialog *chooser)
 {
-        gchar **locale_ids;
-        GHashTable *initial;
-
-        locale_ids = gnome_get_all_locales ();
-        initial = cc_common_language_get_initial_languages ();
-        add_languages (chooser, locale_ids, initial);
-        g_hash_table_destroy (initial);
-        g_strfreev (locale_ids);
+        CcLanguageChooserPrivate *priv = GET_PRIVATE (chooser);
+        GTask *task;
+
+        priv->initial_languages = cc_common_language_get_initial_languages ();
+
+        gtk_container_add (GTK_CONTAINER (priv->language_list), GTK_WIDGET (priv->more_item));
+        gtk_widget_show_all (priv->language_list);
+
+        task = g_task_new (chooser, priv->cancellable, check_fonts_done, NULL);
+        g_task_set_task_data (task, gnome_get_all_locales (), (GDestroyNotify) g_strfreev);
+        g_task_run_in_thread (task, check_fonts_thread);
+        g_object_unref (task);
 }
 
 static gboolean
@@ -202,11 +288,7 @@ language_visible (GtkListBoxRow *row,
 {
         GtkDialog *chooser = user_data;
         CcLanguageChooserPrivate *priv = GET_PRIVATE (chooser);
-        gchar *locale_name = NULL;
-        gchar *locale_current_name = NULL;
-        gchar *locale_untranslated_name = NULL;
         gboolean is_extra;
-        gboolean visible;
 
         if (row == priv->more_item)
                 return !priv->showing_extra;
@@ -219,29 +301,9 @@ language_visible (GtkListBoxRow *row,
         if (!priv->filter_words)
                 return TRUE;
 
-        visible = FALSE;
-
-        locale_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-name"));
-        visible = match_all (priv->filter_words, locale_name);
-        if (visible)
-                goto out;
-
-        locale_current_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-current-name"));
-        visible = match_all (priv->filter_words, locale_current_name);
-        if (visible)
-                goto out;
-
-        locale_untranslated_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-untranslated-name"));
-        visible = match_all (priv->filter_words, locale_untranslated_name);
-
-out:
-        g_free (locale_untranslated_name);
-        g_free (locale_current_name);
-        g_free (locale_name);
-        return visible;
+        return match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-name-key")) ||
+               match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-current-name-key")) ||
+               match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-untranslated-name-key"));
 }
 
 static gint
@@ -393,6 +455,9 @@ cc_language_chooser_private_free (gpointer data)
 {
         CcLanguageChooserPrivate *priv = data;
 
+        g_cancellable_cancel (priv->cancellable);
+        g_clear_object (&priv->cancellable);
+        g_clear_pointer (&priv->initial_languages, g_hash_table_destroy);
         g_clear_object (&priv->no_results);
         g_strfreev (priv->filter_words);
         g_free (priv->language);
@@ -429,6 +494,7 @@ cc_language_chooser_new (GtkWidget *parent)
         priv->language_list = WID ("language-list");
         priv->scrolledwindow = WID ("language-scrolledwindow");
         priv->more_item = more_widget_new ();
+        priv->cancellable = g_cancellable_new ();
         /* We ref-sink here so we can reuse this widget multiple times */
         priv->no_results = g_object_ref_sink (no_results_widget_new ());
         gtk_widget_show_all (priv->no_results);
@@ -455,6 +521,8 @@ cc_language_chooser_new (GtkWidget *parent)
 
         g_signal_connect (chooser, "activate-default",
                           G_CALLBACK (activate_default), chooser);
+        g_signal_connect_swapped (chooser, "destroy",
+                                  G_CALLBACK (g_cancellable_cancel), priv->cancellable);
 
         return chooser;
 }
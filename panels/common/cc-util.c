@@ -43,15 +43,12 @@
  *
  * Originally written by Aleksander Morgado <aleksander@gnu.org>
  */
-char *
-cc_util_normalize_casefold_and_unaccent (const char *str)
+static char *
+normalize_casefold_and_unaccent_slow (const char *str)
 {
   char *normalized, *tmp;
   int i = 0, j = 0, ilen;
 
-  if (str == NULL)
-    return NULL;
-
   normalized = g_utf8_normalize (str, -1, G_NORMALIZE_NFKD);
   tmp = g_utf8_casefold (normalized, -1);
   g_free (normalized);
@@ -107,6 +104,211 @@ cc_util_normalize_casefold_and_unaccent (const char *str)
   return tmp;
 }
 
+/* The fast path handles ASCII, and the two-byte UTF-8 sequences for
+ * Latin, Greek and Cyrillic through a table holding the result of the
+ * slow path for each of these characters. */
+#define FOLD_TABLE_SIZE     0x0500
+#define FOLD_ENTRY_MAX_LEN  7
+#define FOLD_ENTRY_UNHANDLED 0xff
+
+typedef struct
+{
+  guint8 len;
+  gchar  str[FOLD_ENTRY_MAX_LEN];
+} FoldEntry;
+
+static const FoldEntry *fold_table;
+
+static char *
+normalize_unichar_slow (gunichar c)
+{
+  gchar utf8[7];
+
+  utf8[g_unichar_to_utf8 (c, utf8)] = '\0';
+
+  return normalize_casefold_and_unaccent_slow (utf8);
+}
+
+/* Normalization reorders combining characters, so a character can only
+ * be folded on its own if all the combining characters it decomposes to
+ * are dropped from the output. */
+static gboolean
+folds_independently (gunichar c)
+{
+  gunichar decomposition[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+  gsize i, n;
+
+  n = g_unichar_fully_decompose (c, TRUE, decomposition, G_N_ELEMENTS (decomposition));
+
+  for (i = 0; i < n; i++)
+    {
+      gboolean dropped;
+      char *folded;
+
+      if (g_unichar_combining_class (decomposition[i]) == 0)
+        continue;
+
+      folded = normalize_unichar_slow (decomposition[i]);
+      dropped = (*folded == '\0');
+      g_free (folded);
+
+      if (!dropped)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gpointer
+build_fold_table (gpointer data)
+{
+  FoldEntry *table;
+  gunichar c;
+
+  table = g_new0 (FoldEntry, FOLD_TABLE_SIZE);
+
+  for (c = 1; c < FOLD_TABLE_SIZE; c++)
+    {
+      char *folded;
+      gsize len;
+
+      folded = normalize_unichar_slow (c);
+      len = strlen (folded);
+
+      if (len <= FOLD_ENTRY_MAX_LEN && folds_independently (c))
+        {
+          table[c].len = len;
+          memcpy (table[c].str, folded, len);
+        }
+      else
+        {
+          table[c].len = FOLD_ENTRY_UNHANDLED;
+        }
+
+      g_free (folded);
+    }
+
+  return table;
+}
+
+static void
+ensure_fold_table (void)
+{
+  static GOnce fold_table_once = G_ONCE_INIT;
+
+  fold_table = g_once (&fold_table_once, build_fold_table, NULL);
+}
+
+/* Returns the length of the result, writing as much of it as fits in
+ * @buffer, or -1 if @str needs to go through the slow path. */
+static gssize
+normalize_casefold_and_unaccent_fast (const char *str,
+                                      char       *buffer,
+                                      gsize       buffer_size)
+{
+  const guchar *p = (const guchar *) str;
+  gsize len = 0;
+
+  while (*p)
+    {
+      const FoldEntry *entry;
+      gunichar c;
+
+      if (*p < 0x80)
+        {
+          if (len < buffer_size)
+            buffer[len] = g_ascii_tolower (*p);
+          len++;
+          p++;
+          continue;
+        }
+
+      if ((p[0] & 0xe0) != 0xc0 || (p[1] & 0xc0) != 0x80)
+        return -1;
+
+      c = ((p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+      if (c < 0x80 || c >= FOLD_TABLE_SIZE)
+        return -1;
+
+      entry = &fold_table[c];
+      if (entry->len == FOLD_ENTRY_UNHANDLED)
+        return -1;
+
+      if (len + entry->len <= buffer_size)
+        memcpy (buffer + len, entry->str, entry->len);
+      len += entry->len;
+      p += 2;
+    }
+
+  if (len < buffer_size)
+    buffer[len] = '\0';
+
+  return len;
+}
+
+char *
+cc_util_normalize_casefold_and_unaccent (const char *str)
+{
+  char buffer[256];
+  char *result;
+  gssize len;
+
+  if (str == NULL)
+    return NULL;
+
+  ensure_fold_table ();
+
+  len = normalize_casefold_and_unaccent_fast (str, buffer, sizeof (buffer));
+  if (len < 0)
+    return normalize_casefold_and_unaccent_slow (str);
+
+  if ((gsize) len < sizeof (buffer))
+    return g_strndup (buffer, len);
+
+  result = g_malloc (len + 1);
+  normalize_casefold_and_unaccent_fast (str, result, len + 1);
+
+  return result;
+}
+
+/**
+ * cc_util_normalize_casefold_and_unaccent_buf:
+ * @str: a UTF-8 string
+ * @buffer: the buffer to write the result to
+ * @buffer_size: the size of @buffer
+ *
+ * Like cc_util_normalize_casefold_and_unaccent(), but writes the result
+ * to @buffer instead of allocating it. Like snprintf(), the length of
+ * the whole result is returned, and if it isn't smaller than
+ * @buffer_size, the contents of @buffer are undefined.
+ *
+ * Returns: the length of the result, not including the trailing nul
+ */
+gsize
+cc_util_normalize_casefold_and_unaccent_buf (const char *str,
+                                             char       *buffer,
+                                             gsize       buffer_size)
+{
+  char *result;
+  gssize len;
+
+  g_return_val_if_fail (str != NULL, 0);
+
+  ensure_fold_table ();
+
+  len = normalize_casefold_and_unaccent_fast (str, buffer, buffer_size);
+  if (len >= 0)
+    return len;
+
+  result = normalize_casefold_and_unaccent_slow (str);
+  len = strlen (result);
+  if ((gsize) len < buffer_size)
+    memcpy (buffer, result, len + 1);
+  g_free (result);
+
+  return len;
+}
+
 char *
 cc_util_get_smart_date (GDateTime *date)
 {
@@ -23,7 +23,10 @@
 
 #include <glib.h>
 
-char * cc_util_normalize_casefold_and_unaccent (const char *str);
-char * cc_util_get_smart_date                  (GDateTime *date);
+char * cc_util_normalize_casefold_and_unaccent     (const char *str);
+gsize  cc_util_normalize_casefold_and_unaccent_buf (const char *str,
+                                                    char       *buffer,
+                                                    gsize       buffer_size);
+char * cc_util_get_smart_date                      (GDateTime *date);
 
 #endif
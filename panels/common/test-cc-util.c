@@ -0,0 +1,188 @@
+#include "config.h"
+
+#include <locale.h>
+#include <string.h>
+#include <glib.h>
+
+#include "cc-util.h"
+
+#define IS_CDM_UCS4(c) (((c) >= 0x0300 && (c) <= 0x036F)  || \
+                        ((c) >= 0x1DC0 && (c) <= 0x1DFF)  || \
+                        ((c) >= 0x20D0 && (c) <= 0x20FF)  || \
+                        ((c) >= 0xFE20 && (c) <= 0xFE2F))
+
+#define IS_SOFT_HYPHEN(c) ((c) == 0x00AD)
+
+/* The original implementation, which the table driven one must match */
+static char *
+reference_normalize_casefold_and_unaccent (const char *str)
+{
+	char *normalized, *tmp;
+	int i = 0, j = 0, ilen;
+
+	normalized = g_utf8_normalize (str, -1, G_NORMALIZE_NFKD);
+	tmp = g_utf8_casefold (normalized, -1);
+	g_free (normalized);
+
+	ilen = strlen (tmp);
+
+	while (i < ilen) {
+		gunichar unichar;
+		gint utf8_len;
+
+		unichar = g_utf8_get_char_validated (&tmp[i], -1);
+		if (unichar == (gunichar) -1 || unichar == (gunichar) -2)
+			break;
+
+		utf8_len = g_utf8_next_char (&tmp[i]) - &tmp[i];
+
+		if (IS_CDM_UCS4 (unichar) || IS_SOFT_HYPHEN (unichar)) {
+			i += utf8_len;
+			continue;
+		}
+
+		if (i != j)
+			memmove (&tmp[j], &tmp[i], utf8_len);
+
+		i += utf8_len;
+		j += utf8_len;
+	}
+
+	tmp[j] = '\0';
+
+	return tmp;
+}
+
+static void
+check_string (const char *str)
+{
+	char *expected, *result;
+	char buffer[64];
+	gsize len;
+
+	expected = reference_normalize_casefold_and_unaccent (str);
+
+	result = cc_util_normalize_casefold_and_unaccent (str);
+	if (g_strcmp0 (result, expected) != 0)
+		g_error ("Normalizing '%s' gave '%s', expected '%s'", str, result, expected);
+
+	len = cc_util_normalize_casefold_and_unaccent_buf (str, buffer, sizeof (buffer));
+	g_assert_cmpuint (len, ==, strlen (expected));
+	if (len < sizeof (buffer))
+		g_assert_cmpstr (buffer, ==, expected);
+
+	g_free (result);
+	g_free (expected);
+}
+
+static void
+test_normalize_bmp (void)
+{
+	/* Combining characters which get dropped, or not, by the
+	 * normalization, to check reordering */
+	const char *suffixes[] = { "", "\xcc\x81", "\xcd\x85", "\xd2\x83", "\xd2\x83\xcd\x85", "a" };
+	gunichar c;
+	guint i;
+
+	for (c = 1; c <= 0xFFFF; c++) {
+		char utf8[7];
+		char *str;
+
+		if (c >= 0xD800 && c <= 0xDFFF)
+			continue;
+
+		utf8[g_unichar_to_utf8 (c, utf8)] = '\0';
+
+		for (i = 0; i < G_N_ELEMENTS (suffixes); i++) {
+			str = g_strconcat (utf8, suffixes[i], NULL);
+			check_string (str);
+			g_free (str);
+
+			str = g_strconcat ("Ab", suffixes[i], utf8, "Z", utf8, NULL);
+			check_string (str);
+			g_free (str);
+		}
+	}
+}
+
+static void
+test_normalize_buffer (void)
+{
+	char buffer[8];
+	char *long_str;
+	gsize len;
+
+	g_assert_cmpuint (cc_util_normalize_casefold_and_unaccent_buf ("Éte", buffer, sizeof (buffer)), ==, 3);
+	g_assert_cmpstr (buffer, ==, "ete");
+
+	/* Too small, the whole length is still reported */
+	len = cc_util_normalize_casefold_and_unaccent_buf ("Ελληνικά", buffer, 4);
+	g_assert_cmpuint (len, ==, strlen ("ελληνικα"));
+
+	/* Long enough to not fit in the internal buffer */
+	long_str = g_strnfill (1000, 'A');
+	check_string (long_str);
+	g_free (long_str);
+}
+
+static const char *perf_strings[] = {
+	"English (United States)",
+	"Deutsch (Österreich)",
+	"Français (Canada)",
+	"Português (Brasil)",
+	"Русский (Россия)",
+	"Ελληνικά (Ελλάδα)",
+	"Tiếng Việt (Việt Nam)",
+	"日本語 (日本)",
+	NULL
+};
+
+#define PERF_ROUNDS 100000
+
+static void
+test_normalize_perf (void)
+{
+	GTimer *timer;
+	gdouble reference, fast;
+	char buffer[128];
+	guint i, j;
+
+	if (!g_test_perf ())
+		return;
+
+	timer = g_timer_new ();
+
+	for (i = 0; perf_strings[i] != NULL; i++) {
+		g_timer_start (timer);
+		for (j = 0; j < PERF_ROUNDS; j++)
+			g_free (reference_normalize_casefold_and_unaccent (perf_strings[i]));
+		reference = g_timer_elapsed (timer, NULL);
+
+		g_timer_start (timer);
+		for (j = 0; j < PERF_ROUNDS; j++)
+			cc_util_normalize_casefold_and_unaccent_buf (perf_strings[i], buffer, sizeof (buffer));
+		fast = g_timer_elapsed (timer, NULL);
+
+		g_test_message ("%s: %.1f ns, was %.1f ns",
+				perf_strings[i],
+				fast * 1e9 / PERF_ROUNDS,
+				reference * 1e9 / PERF_ROUNDS);
+		g_test_minimized_result (fast * 1e9 / PERF_ROUNDS,
+					 "%s: %.1f ns per call", perf_strings[i],
+					 fast * 1e9 / PERF_ROUNDS);
+	}
+
+	g_timer_destroy (timer);
+}
+
+int main (int argc, char **argv)
+{
+	setlocale (LC_ALL, "");
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/common/normalize/bmp", test_normalize_bmp);
+	g_test_add_func ("/common/normalize/buffer", test_normalize_buffer);
+	g_test_add_func ("/common/normalize/perf", test_normalize_perf);
+
+	return g_test_run ();
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2010 Intel, Inc
+ *
+ * Portions from Ubiquity, Copyright (C) 2009 Canonical Ltd.
+ * Written by Evan Dandrea <evand@ubuntu.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cc-timezone-index.h"
+#include <math.h>
+
+/* Side of a grid cell, in pixels. With the usual map sizes this puts a
+ * handful of locations in each populated cell. */
+#define CELL_SIZE 16.0
+
+typedef struct
+{
+  gdouble x;
+  gdouble y;
+} CcTimezoneIndexPoint;
+
+struct _CcTimezoneIndex
+{
+  gint width;
+  gint height;
+
+  guint n_locations;
+  TzLocation **locations;
+  CcTimezoneIndexPoint *points;
+
+  /* The grid covers the bounding box of the projected locations, the
+   * locations in cell c are items[cell_start[c]] .. items[cell_start[c + 1] - 1],
+   * in increasing order. */
+  gdouble min_x;
+  gdouble min_y;
+  gint cols;
+  gint rows;
+  guint *cell_start;
+  guint *items;
+};
+
+gdouble
+cc_timezone_index_longitude_to_x (gdouble longitude,
+                                  gint    map_width)
+{
+  const gdouble xdeg_offset = -6;
+  gdouble x;
+
+  x = (map_width * (180.0 + longitude) / 360.0)
+    + (map_width * xdeg_offset / 180.0);
+
+  return x;
+}
+
+static gdouble
+radians (gdouble degrees)
+{
+  return (degrees / 360.0) * G_PI * 2;
+}
+
+gdouble
+cc_timezone_index_latitude_to_y (gdouble latitude,
+                                 gint    map_height)
+{
+  gdouble bottom_lat = -59;
+  gdouble top_lat = 81;
+  gdouble top_per, y, full_range, top_offset, map_range;
+
+  top_per = top_lat / 180.0;
+  y = 1.25 * log (tan (G_PI_4 + 0.4 * radians (latitude)));
+  full_range = 4.6068250867599998;
+  top_offset = full_range * top_per;
+  map_range = fabs (1.25 * log (tan (G_PI_4 + 0.4 * radians (bottom_lat))) - top_offset);
+  y = fabs (y - top_offset);
+  y = y / map_range;
+  y = y * map_height;
+  return y;
+}
+
+static gint
+cell_coordinate (gdouble value,
+                 gdouble origin)
+{
+  gdouble c;
+
+  c = floor ((value - origin) / CELL_SIZE);
+
+  /* Keep far away points from overflowing, they end up in the last
+   * ring searched anyway */
+  return (gint) CLAMP (c, -(G_MAXINT / 4), G_MAXINT / 4);
+}
+
+CcTimezoneIndex *
+cc_timezone_index_new (GPtrArray *locations,
+                       gint       map_width,
+                       gint       map_height)
+{
+  CcTimezoneIndex *index;
+  gdouble max_x, max_y;
+  guint *cursor;
+  guint *cells;
+  guint n_cells;
+  guint i;
+
+  index = g_new0 (CcTimezoneIndex, 1);
+  index->width = map_width;
+  index->height = map_height;
+  index->n_locations = locations->len;
+
+  if (index->n_locations == 0)
+    return index;
+
+  index->locations = g_new (TzLocation *, index->n_locations);
+  index->points = g_new (CcTimezoneIndexPoint, index->n_locations);
+
+  max_x = max_y = -G_MAXDOUBLE;
+  index->min_x = index->min_y = G_MAXDOUBLE;
+
+  for (i = 0; i < index->n_locations; i++)
+    {
+      TzLocation *loc = locations->pdata[i];
+      CcTimezoneIndexPoint *p = &index->points[i];
+
+      index->locations[i] = loc;
+      p->x = cc_timezone_index_longitude_to_x (loc->longitude, map_width);
+      p->y = cc_timezone_index_latitude_to_y (loc->latitude, map_height);
+
+      index->min_x = MIN (index->min_x, p->x);
+      index->min_y = MIN (index->min_y, p->y);
+      max_x = MAX (max_x, p->x);
+      max_y = MAX (max_y, p->y);
+    }
+
+  index->cols = cell_coordinate (max_x, index->min_x) + 1;
+  index->rows = cell_coordinate (max_y, index->min_y) + 1;
+  n_cells = index->cols * index->rows;
+
+  /* Bucket the locations with a counting sort */
+  cells = g_new (guint, index->n_locations);
+  index->cell_start = g_new0 (guint, n_cells + 1);
+  index->items = g_new (guint, index->n_locations);
+
+  for (i = 0; i < index->n_locations; i++)
+    {
+      gint cx, cy;
+
+      cx = MIN (cell_coordinate (index->points[i].x, index->min_x), index->cols - 1);
+      cy = MIN (cell_coordinate (index->points[i].y, index->min_y), index->rows - 1);
+      cells[i] = cy * index->cols + cx;
+      index->cell_start[cells[i] + 1]++;
+    }
+
+  for (i = 0; i < n_cells; i++)
+    index->cell_start[i + 1] += index->cell_start[i];
+
+  cursor = g_memdup (index->cell_start, n_cells * sizeof (guint));
+  for (i = 0; i < index->n_locations; i++)
+    index->items[cursor[cells[i]]++] = i;
+
+  g_free (cursor);
+  g_free (cells);
+
+  return index;
+}
+
+void
+cc_timezone_index_free (CcTimezoneIndex *index)
+{
+  if (index == NULL)
+    return;
+
+  g_free (index->locations);
+  g_free (index->points);
+  g_free (index->cell_start);
+  g_free (index->items);
+  g_free (index);
+}
+
+gboolean
+cc_timezone_index_has_size (CcTimezoneIndex *index,
+                            gint             map_width,
+                            gint             map_height)
+{
+  return index->width == map_width && index->height == map_height;
+}
+
+static void
+search_cell (CcTimezoneIndex *index,
+             gint             cx,
+             gint             cy,
+             gdouble          x,
+             gdouble          y,
+             gdouble         *best_dist,
+             gint            *best)
+{
+  guint cell, j;
+
+  cell = cy * index->cols + cx;
+
+  for (j = index->cell_start[cell]; j < index->cell_start[cell + 1]; j++)
+    {
+      guint i = index->items[j];
+      gdouble dx, dy, dist;
+
+      dx = index->points[i].x - x;
+      dy = index->points[i].y - y;
+      dist = dx * dx + dy * dy;
+
+      /* On ties, the last location in the database wins, as it always
+       * did with the sorted list of distances */
+      if (dist < *best_dist || (dist == *best_dist && (gint) i > *best))
+        {
+          *best_dist = dist;
+          *best = i;
+        }
+    }
+}
+
+/* Returns the location closest to (x, y), in the coordinates of the
+ * map size the index was built for. */
+TzLocation *
+cc_timezone_index_lookup (CcTimezoneIndex *index,
+                          gdouble          x,
+                          gdouble          y)
+{
+  gdouble best_dist = G_MAXDOUBLE;
+  gint best = -1;
+  gint qx, qy, r, r_min, r_max;
+
+  if (index->n_locations == 0)
+    return NULL;
+
+  qx = cell_coordinate (x, index->min_x);
+  qy = cell_coordinate (y, index->min_y);
+
+  /* Rings closer than r_min lie entirely outside the grid, and r_max
+   * covers all of it */
+  r_min = MAX (MAX (-qx, qx - (index->cols - 1)), MAX (-qy, qy - (index->rows - 1)));
+  r_min = MAX (r_min, 0);
+  r_max = MAX (MAX (ABS (qx), ABS (qx - (index->cols - 1))),
+               MAX (ABS (qy), ABS (qy - (index->rows - 1))));
+
+  for (r = r_min; r <= r_max; r++)
+    {
+      gint cx, cy, x0, x1, y0, y1;
+      gdouble bound;
+
+      x0 = MAX (qx - r, 0);
+      x1 = MIN (qx + r, index->cols - 1);
+      y0 = MAX (qy - r, 0);
+      y1 = MIN (qy + r, index->rows - 1);
+
+      for (cy = y0; cy <= y1; cy++)
+        {
+          if (cy == qy - r || cy == qy + r)
+            {
+              for (cx = x0; cx <= x1; cx++)
+                search_cell (index, cx, cy, x, y, &best_dist, &best);
+            }
+          else
+            {
+              if (qx - r >= 0)
+                search_cell (index, qx - r, cy, x, y, &best_dist, &best);
+              if (r > 0 && qx + r < index->cols)
+                search_cell (index, qx + r, cy, x, y, &best_dist, &best);
+            }
+        }
+
+      /* Every cell in the next rings is at least r cells away from the
+       * one containing the point. Leave some slack for rounding, and keep
+       * going on exact ties so that they are resolved like above. */
+      bound = r * CELL_SIZE - 1e-6;
+      if (bound > 0 && best_dist < bound * bound)
+        break;
+    }
+
+  return index->locations[best];
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2010 Intel, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef _CC_TIMEZONE_INDEX_H
+#define _CC_TIMEZONE_INDEX_H
+
+#include <glib.h>
+#include "tz.h"
+
+G_BEGIN_DECLS
+
+typedef struct _CcTimezoneIndex CcTimezoneIndex;
+
+gdouble          cc_timezone_index_longitude_to_x (gdouble          longitude,
+                                                   gint             map_width);
+gdouble          cc_timezone_index_latitude_to_y  (gdouble          latitude,
+                                                   gint             map_height);
+
+CcTimezoneIndex *cc_timezone_index_new            (GPtrArray       *locations,
+                                                   gint             map_width,
+                                                   gint             map_height);
+void             cc_timezone_index_free           (CcTimezoneIndex *index);
+
+gboolean         cc_timezone_index_has_size       (CcTimezoneIndex *index,
+                                                   gint             map_width,
+                                                   gint             map_height);
+TzLocation      *cc_timezone_index_lookup         (CcTimezoneIndex *index,
+                                                   gdouble          x,
+                                                   gdouble          y);
+
+G_END_DECLS
+
+#endif /* _CC_TIMEZONE_INDEX_H */
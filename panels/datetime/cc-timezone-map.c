@@ -24,6 +24,7 @@
 #include "cc-timezone-map.h"
 #include <math.h>
 #include <string.h>
+#include "cc-timezone-index.h"
 #include "tz.h"
 
 G_DEFINE_TYPE (CcTimezoneMap, cc_timezone_map, GTK_TYPE_WIDGET)
@@ -51,7 +52,6 @@ struct _CcTimezoneMapPrivate
   GdkPixbuf *orig_background_dim;
   GdkPixbuf *orig_color_map;
 
-  GdkPixbuf *background;
   GdkPixbuf *color_map;
   GdkPixbuf *pin;
 
@@ -60,9 +60,23 @@ struct _CcTimezoneMapPrivate
 
   gdouble selected_offset;
 
+  /* Surfaces scaled for the current allocation, scale factor and
+   * sensitivity. The highlights are keyed by resource path, a NULL
+   * value means the highlight is being loaded in the background. */
+  cairo_surface_t *background;
+  GHashTable *hilights;
+  gint surface_width;
+  gint surface_height;
+  gint surface_scale;
+  guint surface_serial;
+  GCancellable *cancellable;
+
   TzDB *tzdb;
   TzLocation *location;
 
+  /* Locations projected for the current allocation */
+  CcTimezoneIndex *index;
+
   gchar *bubble_text;
 };
 
@@ -127,8 +141,15 @@ cc_timezone_map_dispose (GObject *object)
   g_clear_object (&priv->orig_background);
   g_clear_object (&priv->orig_background_dim);
   g_clear_object (&priv->orig_color_map);
-  g_clear_object (&priv->background);
   g_clear_object (&priv->pin);
+  g_clear_pointer (&priv->background, cairo_surface_destroy);
+  g_clear_pointer (&priv->hilights, g_hash_table_destroy);
+
+  if (priv->cancellable)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_clear_object (&priv->cancellable);
+    }
   g_clear_pointer (&priv->bubble_text, g_free);
 
   if (priv->color_map)
@@ -147,6 +168,8 @@ cc_timezone_map_finalize (GObject *object)
 {
   CcTimezoneMapPrivate *priv = CC_TIMEZONE_MAP (object)->priv;
 
+  g_clear_pointer (&priv->index, cc_timezone_index_free);
+
   if (priv->tzdb)
     {
       tz_db_free (priv->tzdb);
@@ -190,25 +213,32 @@ cc_timezone_map_get_preferred_height (GtkWidget *widget,
     *natural = size;
 }
 
+static void
+clear_surfaces (CcTimezoneMap *map)
+{
+  CcTimezoneMapPrivate *priv = map->priv;
+
+  g_clear_pointer (&priv->background, cairo_surface_destroy);
+  if (priv->hilights)
+    g_hash_table_remove_all (priv->hilights);
+
+  /* Drops the highlights still being loaded for the old size */
+  priv->surface_serial++;
+}
+
 static void
 cc_timezone_map_size_allocate (GtkWidget     *widget,
                                GtkAllocation *allocation)
 {
   CcTimezoneMapPrivate *priv = CC_TIMEZONE_MAP (widget)->priv;
-  GdkPixbuf *pixbuf;
-
-  if (priv->background)
-    g_object_unref (priv->background);
-
-  if (!gtk_widget_is_sensitive (widget))
-    pixbuf = priv->orig_background_dim;
-  else
-    pixbuf = priv->orig_background;
 
-  priv->background = gdk_pixbuf_scale_simple (pixbuf,
-                                              allocation->width,
-                                              allocation->height,
-                                              GDK_INTERP_BILINEAR);
+  if (allocation->width != priv->surface_width ||
+      allocation->height != priv->surface_height)
+    {
+      clear_surfaces (CC_TIMEZONE_MAP (widget));
+      priv->surface_width = allocation->width;
+      priv->surface_height = allocation->height;
+    }
 
   if (priv->color_map)
     g_object_unref (priv->color_map);
@@ -221,6 +251,15 @@ cc_timezone_map_size_allocate (GtkWidget     *widget,
   priv->visible_map_pixels = gdk_pixbuf_get_pixels (priv->color_map);
   priv->visible_map_rowstride = gdk_pixbuf_get_rowstride (priv->color_map);
 
+  if (priv->index == NULL ||
+      !cc_timezone_index_has_size (priv->index, allocation->width, allocation->height))
+    {
+      cc_timezone_index_free (priv->index);
+      priv->index = cc_timezone_index_new (tz_get_locations (priv->tzdb),
+                                           allocation->width,
+                                           allocation->height);
+    }
+
   GTK_WIDGET_CLASS (cc_timezone_map_parent_class)->size_allocate (widget,
                                                                   allocation);
 }
@@ -253,42 +292,12 @@ cc_timezone_map_realize (GtkWidget *widget)
 }
 
 
-static gdouble
-convert_longitude_to_x (gdouble longitude, gint map_width)
-{
-  const gdouble xdeg_offset = -6;
-  gdouble x;
-
-  x = (map_width * (180.0 + longitude) / 360.0)
-    + (map_width * xdeg_offset / 180.0);
-
-  return x;
-}
-
 static gdouble
 radians (gdouble degrees)
 {
   return (degrees / 360.0) * G_PI * 2;
 }
 
-static gdouble
-convert_latitude_to_y (gdouble latitude, gdouble map_height)
-{
-  gdouble bottom_lat = -59;
-  gdouble top_lat = 81;
-  gdouble top_per, y, full_range, top_offset, map_range;
-
-  top_per = top_lat / 180.0;
-  y = 1.25 * log (tan (G_PI_4 + 0.4 * radians (latitude)));
-  full_range = 4.6068250867599998;
-  top_offset = full_range * top_per;
-  map_range = fabs (1.25 * log (tan (G_PI_4 + 0.4 * radians (bottom_lat))) - top_offset);
-  y = fabs (y - top_offset);
-  y = y / map_range;
-  y = y * map_height;
-  return y;
-}
-
 static void
 draw_text_bubble (cairo_t *cr,
                   GtkWidget *widget,
@@ -361,66 +370,271 @@ draw_text_bubble (cairo_t *cr,
   cairo_restore (cr);
 }
 
-static gboolean
-cc_timezone_map_draw (GtkWidget *widget,
-                      cairo_t   *cr)
+static gchar *
+get_hilight_path (gdouble  offset,
+                  gboolean sensitive)
 {
-  CcTimezoneMapPrivate *priv = CC_TIMEZONE_MAP (widget)->priv;
-  GdkPixbuf *hilight, *orig_hilight;
-  GtkAllocation alloc;
-  gchar *file;
-  GError *err = NULL;
-  gdouble pointx, pointy;
   char buf[16];
 
-  gtk_widget_get_allocation (widget, &alloc);
+  return g_strdup_printf (DATETIME_RESOURCE_PATH "/timezone_%s%s.png",
+                          g_ascii_formatd (buf, sizeof (buf), "%g", offset),
+                          sensitive ? "" : "_dim");
+}
 
-  /* paint background */
-  gdk_cairo_set_source_pixbuf (cr, priv->background, 0, 0);
-  cairo_paint (cr);
+static GdkPixbuf *
+load_scaled_pixbuf (const gchar  *path,
+                    gint          width,
+                    gint          height,
+                    GError      **error)
+{
+  GdkPixbuf *orig, *scaled;
 
-  /* paint hilight */
-  if (gtk_widget_is_sensitive (widget))
+  orig = gdk_pixbuf_new_from_resource (path, error);
+  if (!orig)
+    return NULL;
+
+  scaled = gdk_pixbuf_scale_simple (orig, width, height, GDK_INTERP_BILINEAR);
+  g_object_unref (orig);
+
+  return scaled;
+}
+
+static cairo_surface_t *
+get_background (CcTimezoneMap *map)
+{
+  CcTimezoneMapPrivate *priv = map->priv;
+  GdkPixbuf *pixbuf, *scaled;
+
+  if (priv->background)
+    return priv->background;
+
+  if (!gtk_widget_is_sensitive (GTK_WIDGET (map)))
+    pixbuf = priv->orig_background_dim;
+  else
+    pixbuf = priv->orig_background;
+
+  scaled = gdk_pixbuf_scale_simple (pixbuf,
+                                    priv->surface_width * priv->surface_scale,
+                                    priv->surface_height * priv->surface_scale,
+                                    GDK_INTERP_BILINEAR);
+  priv->background = gdk_cairo_surface_create_from_pixbuf (scaled,
+                                                           priv->surface_scale,
+                                                           NULL);
+  g_object_unref (scaled);
+
+  return priv->background;
+}
+
+static cairo_surface_t *
+get_hilight (CcTimezoneMap *map,
+             gdouble        offset)
+{
+  CcTimezoneMapPrivate *priv = map->priv;
+  cairo_surface_t *surface;
+  GdkPixbuf *hilight;
+  GError *err = NULL;
+  gchar *path;
+
+  path = get_hilight_path (offset, gtk_widget_is_sensitive (GTK_WIDGET (map)));
+
+  surface = g_hash_table_lookup (priv->hilights, path);
+  if (surface)
     {
-      file = g_strdup_printf (DATETIME_RESOURCE_PATH "/timezone_%s.png",
-                              g_ascii_formatd (buf, sizeof (buf),
-                                               "%g", priv->selected_offset));
+      g_free (path);
+      return surface;
+    }
+
+  /* Not loaded yet, or still loading in the background; either way
+   * this draw needs it now */
+  hilight = load_scaled_pixbuf (path,
+                                priv->surface_width * priv->surface_scale,
+                                priv->surface_height * priv->surface_scale,
+                                &err);
+  if (!hilight)
+    {
+      g_warning ("Could not load hilight: %s",
+                 (err) ? err->message : "Unknown Error");
+      g_clear_error (&err);
+      g_free (path);
+      return NULL;
     }
+
+  surface = gdk_cairo_surface_create_from_pixbuf (hilight, priv->surface_scale, NULL);
+  g_object_unref (hilight);
+
+  g_hash_table_insert (priv->hilights, path, surface);
+
+  return surface;
+}
+
+typedef struct
+{
+  gchar *path;
+  gint width;
+  gint height;
+  gint scale;
+  guint serial;
+} HilightLoad;
+
+static void
+hilight_load_free (HilightLoad *load)
+{
+  g_free (load->path);
+  g_free (load);
+}
+
+static void
+load_hilight_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  HilightLoad *load = task_data;
+  GdkPixbuf *hilight;
+  GError *err = NULL;
+
+  hilight = load_scaled_pixbuf (load->path,
+                                load->width * load->scale,
+                                load->height * load->scale,
+                                &err);
+  if (!hilight)
+    g_task_return_error (task, err);
   else
+    g_task_return_pointer (task, hilight, g_object_unref);
+}
+
+static void
+hilight_loaded (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+  CcTimezoneMap *map = CC_TIMEZONE_MAP (source_object);
+  CcTimezoneMapPrivate *priv = map->priv;
+  HilightLoad *load;
+  GdkPixbuf *hilight;
+  GError *err = NULL;
+
+  load = g_task_get_task_data (G_TASK (res));
+  hilight = g_task_propagate_pointer (G_TASK (res), &err);
+
+  if (!hilight)
     {
-      file = g_strdup_printf (DATETIME_RESOURCE_PATH "/timezone_%s_dim.png",
-                              g_ascii_formatd (buf, sizeof (buf),
-                                               "%g", priv->selected_offset));
+      if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED) &&
+          load->serial == priv->surface_serial)
+        {
+          /* get_hilight() will complain if it is ever drawn */
+          g_hash_table_remove (priv->hilights, load->path);
+        }
+      g_clear_error (&err);
+      return;
+    }
 
+  /* Only keep it if nothing got loaded meanwhile, and it is still the
+   * right size */
+  if (load->serial == priv->surface_serial &&
+      g_hash_table_contains (priv->hilights, load->path) &&
+      g_hash_table_lookup (priv->hilights, load->path) == NULL)
+    {
+      g_hash_table_insert (priv->hilights,
+                           g_strdup (load->path),
+                           gdk_cairo_surface_create_from_pixbuf (hilight, load->scale, NULL));
     }
 
-  orig_hilight = gdk_pixbuf_new_from_resource (file, &err);
-  g_free (file);
-  file = NULL;
+  g_object_unref (hilight);
+}
+
+static void
+warm_hilight (CcTimezoneMap *map,
+              gdouble        offset)
+{
+  CcTimezoneMapPrivate *priv = map->priv;
+  HilightLoad *load;
+  GTask *task;
+  gchar *path;
 
-  if (!orig_hilight)
+  path = get_hilight_path (offset, gtk_widget_is_sensitive (GTK_WIDGET (map)));
+  if (g_hash_table_contains (priv->hilights, path))
     {
-      g_warning ("Could not load hilight: %s",
-                 (err) ? err->message : "Unknown Error");
-      if (err)
-        g_clear_error (&err);
+      g_free (path);
+      return;
     }
-  else
+
+  g_hash_table_insert (priv->hilights, g_strdup (path), NULL);
+
+  load = g_new0 (HilightLoad, 1);
+  load->path = path;
+  load->width = priv->surface_width;
+  load->height = priv->surface_height;
+  load->scale = priv->surface_scale;
+  load->serial = priv->surface_serial;
+
+  task = g_task_new (map, priv->cancellable, hilight_loaded, NULL);
+  g_task_set_task_data (task, load, (GDestroyNotify) hilight_load_free);
+  g_task_run_in_thread (task, load_hilight_thread);
+  g_object_unref (task);
+}
+
+/* Clicks usually land next to the current zone, so prepare the
+ * highlights on either side of it */
+static void
+warm_neighbouring_hilights (CcTimezoneMap *map)
+{
+  CcTimezoneMapPrivate *priv = map->priv;
+  gdouble previous = -100, next = -100;
+  gint i;
+
+  for (i = 0; color_codes[i].offset != -100; i++)
     {
+      if (color_codes[i].offset < priv->selected_offset)
+        previous = color_codes[i].offset;
+      else if (color_codes[i].offset > priv->selected_offset && next == -100)
+        next = color_codes[i].offset;
+    }
 
-      hilight = gdk_pixbuf_scale_simple (orig_hilight, alloc.width,
-                                         alloc.height, GDK_INTERP_BILINEAR);
-      gdk_cairo_set_source_pixbuf (cr, hilight, 0, 0);
+  if (previous != -100)
+    warm_hilight (map, previous);
+  if (next != -100)
+    warm_hilight (map, next);
+}
 
+static gboolean
+cc_timezone_map_draw (GtkWidget *widget,
+                      cairo_t   *cr)
+{
+  CcTimezoneMap *map = CC_TIMEZONE_MAP (widget);
+  CcTimezoneMapPrivate *priv = map->priv;
+  cairo_surface_t *hilight;
+  GtkAllocation alloc;
+  gdouble pointx, pointy;
+  gint scale;
+
+  gtk_widget_get_allocation (widget, &alloc);
+
+  scale = gtk_widget_get_scale_factor (widget);
+  if (scale != priv->surface_scale)
+    {
+      clear_surfaces (map);
+      priv->surface_scale = scale;
+    }
+
+  /* paint background */
+  cairo_set_source_surface (cr, get_background (map), 0, 0);
+  cairo_paint (cr);
+
+  /* paint hilight */
+  hilight = get_hilight (map, priv->selected_offset);
+  if (hilight)
+    {
+      cairo_set_source_surface (cr, hilight, 0, 0);
       cairo_paint (cr);
-      g_object_unref (hilight);
-      g_object_unref (orig_hilight);
     }
 
+  warm_neighbouring_hilights (map);
+
   if (priv->location)
     {
-      pointx = convert_longitude_to_x (priv->location->longitude, alloc.width);
-      pointy = convert_latitude_to_y (priv->location->latitude, alloc.height);
+      pointx = cc_timezone_index_longitude_to_x (priv->location->longitude, alloc.width);
+      pointy = cc_timezone_index_latitude_to_y (priv->location->latitude, alloc.height);
 
       pointx = CLAMP (floor (pointx), 0, alloc.width);
       pointy = CLAMP (floor (pointy), 0, alloc.height);
@@ -468,6 +682,13 @@ cc_timezone_map_state_flags_changed (GtkWidget     *widget,
 {
   update_cursor (widget);
 
+  /* Both the background and the highlights have a dimmed variant */
+  if (((prev_state ^ gtk_widget_get_state_flags (widget)) & GTK_STATE_FLAG_INSENSITIVE) != 0)
+    {
+      clear_surfaces (CC_TIMEZONE_MAP (widget));
+      gtk_widget_queue_draw (widget);
+    }
+
   if (GTK_WIDGET_CLASS (cc_timezone_map_parent_class)->state_flags_changed)
     GTK_WIDGET_CLASS (cc_timezone_map_parent_class)->state_flags_changed (widget, prev_state);
 }
@@ -503,19 +724,6 @@ cc_timezone_map_class_init (CcTimezoneMapClass *klass)
 }
 
 
-static gint
-sort_locations (TzLocation *a,
-                TzLocation *b)
-{
-  if (a->dist > b->dist)
-    return 1;
-
-  if (a->dist < b->dist)
-    return -1;
-
-  return 0;
-}
-
 static void
 set_location (CcTimezoneMap *map,
               TzLocation    *location)
@@ -545,11 +753,7 @@ button_press_event (GtkWidget      *widget,
   guchar *pixels;
   gint rowstride;
   gint i;
-
-  const GPtrArray *array;
-  gint width, height;
-  GList *distances = NULL;
-  GtkAllocation alloc;
+  TzLocation *location;
 
   x = event->x;
   y = event->y;
@@ -577,33 +781,12 @@ button_press_event (GtkWidget      *widget,
 
   /* work out the co-ordinates */
 
-  array = tz_get_locations (priv->tzdb);
-
-  gtk_widget_get_allocation (widget, &alloc);
-  width = alloc.width;
-  height = alloc.height;
-
-  for (i = 0; i < array->len; i++)
-    {
-      gdouble pointx, pointy, dx, dy;
-      TzLocation *loc = array->pdata[i];
-
-      pointx = convert_longitude_to_x (loc->longitude, width);
-      pointy = convert_latitude_to_y (loc->latitude, height);
-
-      dx = pointx - x;
-      dy = pointy - y;
-
-      loc->dist = dx * dx + dy * dy;
-      distances = g_list_prepend (distances, loc);
+  if (priv->index == NULL)
+    return TRUE;
 
-    }
-  distances = g_list_sort (distances, (GCompareFunc) sort_locations);
-
-
-  set_location (CC_TIMEZONE_MAP (widget), (TzLocation*) distances->data);
-
-  g_list_free (distances);
+  location = cc_timezone_index_lookup (priv->index, x, y);
+  if (location)
+    set_location (CC_TIMEZONE_MAP (widget), location);
 
   return TRUE;
 }
@@ -656,6 +839,10 @@ cc_timezone_map_init (CcTimezoneMap *self)
 
   priv->tzdb = tz_load_db ();
 
+  priv->hilights = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          (GDestroyNotify) cairo_surface_destroy);
+  priv->cancellable = g_cancellable_new ();
+
   g_signal_connect (self, "button-press-event", G_CALLBACK (button_press_event),
                     NULL);
 }
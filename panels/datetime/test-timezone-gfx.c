@@ -1,7 +1,9 @@
 #include <config.h>
 #include <locale.h>
+#include <math.h>
 
 #include "tz.h"
+#include "cc-timezone-index.h"
 
 static void
 test_timezone_gfx (gconstpointer data)
@@ -40,6 +42,94 @@ test_timezone_gfx (gconstpointer data)
 	tz_db_free (db);
 }
 
+static TzLocation *
+nearest_location (GPtrArray *locs,
+		  gint       width,
+		  gint       height,
+		  gdouble    x,
+		  gdouble    y)
+{
+	TzLocation *nearest = NULL;
+	gdouble best = G_MAXDOUBLE;
+	guint i;
+
+	for (i = 0; i < locs->len; i++) {
+		TzLocation *loc = locs->pdata[i];
+		gdouble dx, dy, dist;
+
+		dx = cc_timezone_index_longitude_to_x (loc->longitude, width) - x;
+		dy = cc_timezone_index_latitude_to_y (loc->latitude, height) - y;
+		dist = dx * dx + dy * dy;
+
+		if (dist <= best) {
+			best = dist;
+			nearest = loc;
+		}
+	}
+
+	return nearest;
+}
+
+static void
+test_timezone_index (void)
+{
+	static const gint sizes[][2] = {
+		{ 800, 400 },
+		{ 623, 311 },
+		{ 1920, 960 },
+		{ 40, 20 },
+	};
+	TzDB *db;
+	GPtrArray *locs;
+	guint i, j;
+
+	db = tz_load_db ();
+	locs = tz_get_locations (db);
+
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		CcTimezoneIndex *index;
+		gint width = sizes[i][0];
+		gint height = sizes[i][1];
+
+		index = cc_timezone_index_new (locs, width, height);
+		g_assert (cc_timezone_index_has_size (index, width, height));
+
+		/* Points on the locations themselves */
+		for (j = 0; j < locs->len; j++) {
+			TzLocation *loc = locs->pdata[j];
+			gdouble x, y;
+
+			x = cc_timezone_index_longitude_to_x (loc->longitude, width);
+			y = cc_timezone_index_latitude_to_y (loc->latitude, height);
+			g_assert (cc_timezone_index_lookup (index, x, y) ==
+				  nearest_location (locs, width, height, x, y));
+		}
+
+		/* Random points, including some outside of the map */
+		for (j = 0; j < 2000; j++) {
+			gdouble x, y;
+
+			x = g_test_rand_double_range (-width / 4, width * 5 / 4);
+			y = g_test_rand_double_range (-height / 4, height * 5 / 4);
+			if (j % 2 == 0) {
+				x = floor (x);
+				y = floor (y);
+			}
+
+			if (cc_timezone_index_lookup (index, x, y) !=
+			    nearest_location (locs, width, height, x, y)) {
+				g_message ("Wrong location for (%g, %g) on a %dx%d map",
+					   x, y, width, height);
+				g_test_fail ();
+			}
+		}
+
+		cc_timezone_index_free (index);
+	}
+
+	tz_db_free (db);
+}
+
 int main (int argc, char **argv)
 {
 	char *pixmap_dir;
@@ -59,6 +149,7 @@ int main (int argc, char **argv)
 	}
 
 	g_test_add_data_func ("/datetime/timezone-gfx", pixmap_dir, test_timezone_gfx);
+	g_test_add_func ("/datetime/timezone-index", test_timezone_index);
 
 	return g_test_run ();
 }
@@ -1,4 +1,6 @@
 #include <locale.h>
+#include <stdlib.h>
+#include <time.h>
 #include <gtk/gtk.h>
 #include "cc-timezone-map.h"
 
@@ -98,6 +100,85 @@ test_timezone (void)
 	g_hash_table_destroy (ht);
 }
 
+/* The TZ environment variable based version tz_info_from_location()
+ * used to have, without its bug of skipping over the first tm_isdst
+ * characters of the daylight abbreviation */
+static TzInfo *
+reference_info_from_location (TzLocation *loc)
+{
+	TzInfo *tzinfo;
+	time_t curtime;
+	struct tm *curzone;
+	gchar *tz_env_value;
+
+	tz_env_value = g_strdup (getenv ("TZ"));
+	setenv ("TZ", loc->zone, 1);
+
+	tzinfo = g_new0 (TzInfo, 1);
+
+	curtime = time (NULL);
+	curzone = localtime (&curtime);
+
+	tzinfo->tzname_normal = g_strdup (curzone->tm_zone);
+	if (curzone->tm_isdst)
+		tzinfo->tzname_daylight = g_strdup (curzone->tm_zone);
+	else
+		tzinfo->tzname_daylight = NULL;
+
+	tzinfo->utc_offset = curzone->tm_gmtoff;
+	tzinfo->daylight = curzone->tm_isdst;
+
+	if (tz_env_value)
+		setenv ("TZ", tz_env_value, 1);
+	else
+		unsetenv ("TZ");
+
+	g_free (tz_env_value);
+
+	return tzinfo;
+}
+
+static void
+test_timezone_info (void)
+{
+	TzDB *tz_db;
+	GPtrArray *locs;
+	glong *offsets;
+	guint i;
+
+	tz_db = tz_load_db ();
+	locs = tz_get_locations (tz_db);
+	offsets = tz_get_utc_offsets (tz_db);
+
+	for (i = 0; i < locs->len; i++) {
+		TzLocation *loc = locs->pdata[i];
+		TzInfo *info, *reference;
+
+		info = tz_info_from_location (loc);
+		reference = reference_info_from_location (loc);
+
+		if (info->utc_offset != reference->utc_offset ||
+		    offsets[i] != reference->utc_offset ||
+		    !info->daylight != !reference->daylight ||
+		    g_strcmp0 (info->tzname_normal, reference->tzname_normal) != 0 ||
+		    g_strcmp0 (info->tzname_daylight, reference->tzname_daylight) != 0) {
+			g_print ("Mismatch for timezone '%s': %ld/%ld (%s, %s, %d) instead of %ld (%s, %s, %d)\n",
+				 loc->zone,
+				 info->utc_offset, offsets[i],
+				 info->tzname_normal, info->tzname_daylight, info->daylight,
+				 reference->utc_offset,
+				 reference->tzname_normal, reference->tzname_daylight, reference->daylight);
+			g_test_fail ();
+		}
+
+		tz_info_free (info);
+		tz_info_free (reference);
+	}
+
+	g_free (offsets);
+	tz_db_free (tz_db);
+}
+
 int main (int argc, char **argv)
 {
 	setlocale (LC_ALL, "");
@@ -107,6 +188,7 @@ int main (int argc, char **argv)
 	g_setenv ("G_DEBUG", "fatal_warnings", FALSE);
 
 	g_test_add_func ("/datetime/timezone", test_timezone);
+	g_test_add_func ("/datetime/timezone-info", test_timezone_info);
 
 	return g_test_run ();
 }
@@ -197,57 +197,105 @@ tz_location_get_utc_offset (TzLocation *loc)
 	return offset;
 }
 
+/* GTimeZone parses the tzfile once, and lets us look up any zone
+ * without going through the process-wide TZ variable, so this can be
+ * used from any thread. */
+static GTimeZone *
+tz_get_time_zone (const gchar *zone)
+{
+	static GMutex mutex;
+	static GHashTable *zones = NULL;
+	GTimeZone *tz;
+
+	g_mutex_lock (&mutex);
+
+	if (zones == NULL)
+		zones = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free, (GDestroyNotify) g_time_zone_unref);
+
+	tz = g_hash_table_lookup (zones, zone);
+	if (tz == NULL) {
+		tz = g_time_zone_new (zone);
+		g_hash_table_insert (zones, g_strdup (zone), tz);
+	}
+	g_time_zone_ref (tz);
+
+	g_mutex_unlock (&mutex);
+
+	return tz;
+}
+
+static gint
+tz_find_interval (GTimeZone *tz,
+		  gint64     time_)
+{
+	return g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, time_);
+}
+
 TzInfo *
 tz_info_from_location (TzLocation *loc)
 {
 	TzInfo *tzinfo;
-	time_t curtime;
-	struct tm *curzone;
-	gchar *tz_env_value;
+	GTimeZone *tz;
+	gint interval;
 	
 	g_return_val_if_fail (loc != NULL, NULL);
 	g_return_val_if_fail (loc->zone != NULL, NULL);
 	
-	tz_env_value = g_strdup (getenv ("TZ"));
-	setenv ("TZ", loc->zone, 1);
-	
-#if 0
-	tzset ();
-#endif
-	tzinfo = g_new0 (TzInfo, 1);
+	tz = tz_get_time_zone (loc->zone);
+	interval = tz_find_interval (tz, g_get_real_time () / G_USEC_PER_SEC);
 
-	curtime = time (NULL);
-	curzone = localtime (&curtime);
+	tzinfo = g_new0 (TzInfo, 1);
 
 #ifndef __sun
-	/* Currently this solution doesnt seem to work - I get that */
-	/* America/Phoenix uses daylight savings, which is wrong    */
-	tzinfo->tzname_normal = g_strdup (curzone->tm_zone);
-	if (curzone->tm_isdst) 
-		tzinfo->tzname_daylight =
-			g_strdup (&curzone->tm_zone[curzone->tm_isdst]);
+	tzinfo->tzname_normal = g_strdup (g_time_zone_get_abbreviation (tz, interval));
+	/* The interval we are in is a daylight saving one, so its
+	 * abbreviation is the daylight one, e.g. CEST */
+	if (g_time_zone_is_dst (tz, interval))
+		tzinfo->tzname_daylight = g_strdup (g_time_zone_get_abbreviation (tz, interval));
 	else
 		tzinfo->tzname_daylight = NULL;
 
-	tzinfo->utc_offset = curzone->tm_gmtoff;
+	tzinfo->utc_offset = g_time_zone_get_offset (tz, interval);
 #else
 	tzinfo->tzname_normal = NULL;
 	tzinfo->tzname_daylight = NULL;
 	tzinfo->utc_offset = 0;
 #endif
 
-	tzinfo->daylight = curzone->tm_isdst;
-
-	if (tz_env_value)
-		setenv ("TZ", tz_env_value, 1);
-	else
-		unsetenv ("TZ");
+	tzinfo->daylight = g_time_zone_is_dst (tz, interval);
 
-	g_free (tz_env_value);
+	g_time_zone_unref (tz);
 	
 	return tzinfo;
 }
 
+/* Returns a newly allocated array holding the current UTC offset,
+ * in seconds, of each location returned by tz_get_locations() */
+glong *
+tz_get_utc_offsets (TzDB *db)
+{
+	glong *offsets;
+	gint64 now;
+	guint i;
+
+	g_return_val_if_fail (db != NULL, NULL);
+
+	offsets = g_new0 (glong, db->locations->len);
+	now = g_get_real_time () / G_USEC_PER_SEC;
+
+	for (i = 0; i < db->locations->len; i++) {
+		TzLocation *loc = db->locations->pdata[i];
+		GTimeZone *tz;
+
+		tz = tz_get_time_zone (loc->zone);
+		offsets[i] = g_time_zone_get_offset (tz, tz_find_interval (tz, now));
+		g_time_zone_unref (tz);
+	}
+
+	return offsets;
+}
+
 
 void
 tz_info_free (TzInfo *tzinfo)
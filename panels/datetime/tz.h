@@ -75,6 +75,7 @@ void       tz_db_free                 (TzDB *db);
 char *     tz_info_get_clean_name     (TzDB *tz_db,
 				       const char *tz);
 GPtrArray *tz_get_locations           (TzDB *db);
+glong     *tz_get_utc_offsets         (TzDB *db);
 void       tz_location_get_position   (TzLocation *loc,
 				       double *longitude, double *latitude);
 char      *tz_location_get_country    (TzLocation *loc);
@@ -39,6 +39,9 @@
 
 #define NET_DEVICE_WIFI_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE_WIFI, NetDeviceWifiPrivate))
 
+/* access point changes arriving within this many ms update the list once */
+#define AP_LIST_UPDATE_DELAY 250
+
 typedef enum {
   NM_AP_SEC_UNKNOWN,
   NM_AP_SEC_NONE,
@@ -61,6 +64,12 @@ struct _NetDeviceWifiPrivate
         gchar                   *selected_ssid_title;
         gchar                   *selected_connection_id;
         gchar                   *selected_ap_id;
+
+        /* the rows of the AP list, and the saved connections,
+         * by SSID as returned by ssid_key_new() */
+        GHashTable              *ap_rows;
+        GHashTable              *connections_by_ssid;
+        guint                    update_aps_id;
 };
 
 G_DEFINE_TYPE (NetDeviceWifi, net_device_wifi, NET_TYPE_DEVICE)
@@ -130,68 +139,62 @@ get_access_point_security (NMAccessPoint *ap)
         return type;
 }
 
-static GPtrArray *
+/* nm_utils_same_ssid() ignores a trailing nul, so do the keys of the
+ * SSID tables */
+static GBytes *
+ssid_key_new (GBytes *ssid)
+{
+        const guint8 *data;
+        gsize len;
+
+        data = g_bytes_get_data (ssid, &len);
+        if (len > 0 && data[len - 1] == '\0')
+                return g_bytes_new_from_bytes (ssid, 0, len - 1);
+
+        return g_bytes_ref (ssid);
+}
+
+static GHashTable *
+ssid_table_new (GDestroyNotify value_destroy_func)
+{
+        return g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+                                      (GDestroyNotify) g_bytes_unref,
+                                      value_destroy_func);
+}
+
+static GHashTable *
 panel_get_strongest_unique_aps (const GPtrArray *aps)
 {
-        GBytes *ssid, *ssid_tmp;
-        GPtrArray *aps_unique = NULL;
-        gboolean add_ap;
-        guint i;
-        guint j;
+        GHashTable *aps_unique;
+        GBytes *ssid, *key;
         NMAccessPoint *ap;
         NMAccessPoint *ap_tmp;
+        guint i;
 
         /* we will have multiple entries for typical hotspots, just
          * filter to the one with the strongest signal */
-        aps_unique = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-        if (aps != NULL)
-                for (i = 0; i < aps->len; i++) {
-                        ap = NM_ACCESS_POINT (g_ptr_array_index (aps, i));
+        aps_unique = ssid_table_new (g_object_unref);
+        if (aps == NULL)
+                return aps_unique;
 
-                        /* Hidden SSIDs don't get shown in the list */
-                        ssid = nm_access_point_get_ssid (ap);
-                        if (!ssid)
-                                continue;
+        for (i = 0; i < aps->len; i++) {
+                ap = NM_ACCESS_POINT (g_ptr_array_index (aps, i));
 
-                        add_ap = TRUE;
-
-                        /* get already added list */
-                        for (j=0; j<aps_unique->len; j++) {
-                                ap_tmp = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, j));
-                                ssid_tmp = nm_access_point_get_ssid (ap_tmp);
-                                g_assert (ssid_tmp);
-
-                                /* is this the same type and data? */
-                                if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                        g_bytes_get_data (ssid_tmp, NULL), g_bytes_get_size (ssid_tmp),
-                                                        TRUE)) {
-
-                                        g_debug ("found duplicate: %s",
-                                                 nm_utils_escape_ssid (g_bytes_get_data (ssid_tmp, NULL),
-                                                                       g_bytes_get_size (ssid_tmp)));
-
-                                        /* the new access point is stronger */
-                                        if (nm_access_point_get_strength (ap) >
-                                            nm_access_point_get_strength (ap_tmp)) {
-                                                g_debug ("removing %s",
-                                                         nm_utils_escape_ssid (g_bytes_get_data (ssid_tmp, NULL),
-                                                                               g_bytes_get_size (ssid_tmp)));
-                                                g_ptr_array_remove (aps_unique, ap_tmp);
-                                                add_ap = TRUE;
-                                        } else {
-                                                add_ap = FALSE;
-                                        }
-
-                                        break;
-                                }
-                        }
-                        if (add_ap) {
-                                g_debug ("adding %s",
-                                         nm_utils_escape_ssid (g_bytes_get_data (ssid, NULL),
-                                                               g_bytes_get_size (ssid)));
-                                g_ptr_array_add (aps_unique, g_object_ref (ap));
-                        }
+                /* Hidden SSIDs don't get shown in the list */
+                ssid = nm_access_point_get_ssid (ap);
+                if (!ssid)
+                        continue;
+
+                key = ssid_key_new (ssid);
+                ap_tmp = g_hash_table_lookup (aps_unique, key);
+                if (ap_tmp == NULL ||
+                    nm_access_point_get_strength (ap) > nm_access_point_get_strength (ap_tmp)) {
+                        g_hash_table_replace (aps_unique, key, g_object_ref (ap));
+                } else {
+                        g_bytes_unref (key);
                 }
+        }
+
         return aps_unique;
 }
 
@@ -234,16 +237,66 @@ get_ap_security_string (NMAccessPoint *ap)
         return g_string_free (str, FALSE);
 }
 
+static gboolean
+update_ap_list_cb (gpointer user_data)
+{
+        NetDeviceWifi *device_wifi = NET_DEVICE_WIFI (user_data);
+
+        device_wifi->priv->update_aps_id = 0;
+        populate_ap_list (device_wifi);
+
+        return G_SOURCE_REMOVE;
+}
+
+/* scans add, remove and update access points in bursts, only update
+ * the list once per burst */
 static void
-net_device_wifi_access_point_changed (NMDeviceWifi *nm_device_wifi,
-                                      NMAccessPoint *ap,
-                                      gpointer user_data)
+queue_ap_list_update (NetDeviceWifi *device_wifi)
+{
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
+
+        if (priv->update_aps_id == 0)
+                priv->update_aps_id = g_timeout_add (AP_LIST_UPDATE_DELAY,
+                                                     update_ap_list_cb,
+                                                     device_wifi);
+}
+
+static void
+net_device_wifi_access_point_strength_changed (NMAccessPoint *ap,
+                                               GParamSpec    *pspec,
+                                               NetDeviceWifi *device_wifi)
+{
+        queue_ap_list_update (device_wifi);
+}
+
+static void
+watch_access_point (NetDeviceWifi *device_wifi,
+                    NMAccessPoint *ap)
+{
+        g_signal_connect_object (ap, "notify::" NM_ACCESS_POINT_STRENGTH,
+                                 G_CALLBACK (net_device_wifi_access_point_strength_changed),
+                                 device_wifi, 0);
+}
+
+static void
+net_device_wifi_access_point_added (NMDeviceWifi *nm_device_wifi,
+                                    NMAccessPoint *ap,
+                                    gpointer user_data)
 {
         NetDeviceWifi *device_wifi;
 
         device_wifi = NET_DEVICE_WIFI (user_data);
 
-        populate_ap_list (device_wifi);
+        watch_access_point (device_wifi, ap);
+        queue_ap_list_update (device_wifi);
+}
+
+static void
+net_device_wifi_access_point_removed (NMDeviceWifi *nm_device_wifi,
+                                      NMAccessPoint *ap,
+                                      gpointer user_data)
+{
+        queue_ap_list_update (NET_DEVICE_WIFI (user_data));
 }
 
 static void
@@ -300,6 +353,49 @@ connection_is_shared (NMConnection *c)
         return TRUE;
 }
 
+/* the first valid connection for each SSID, as the list used to pick */
+static GHashTable *
+get_connections_by_ssid (NetDeviceWifi *device_wifi)
+{
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
+        GSList *connections, *l;
+
+        if (priv->connections_by_ssid != NULL)
+                return priv->connections_by_ssid;
+
+        priv->connections_by_ssid = ssid_table_new (NULL);
+
+        connections = net_device_get_valid_connections (NET_DEVICE (device_wifi));
+        for (l = connections; l; l = l->next) {
+                NMConnection *connection = l->data;
+                NMSettingWireless *sw;
+                GBytes *ssid, *key;
+
+                if (connection_is_shared (connection))
+                        continue;
+
+                sw = nm_connection_get_setting_wireless (connection);
+                ssid = sw ? nm_setting_wireless_get_ssid (sw) : NULL;
+                if (ssid == NULL)
+                        continue;
+
+                key = ssid_key_new (ssid);
+                if (g_hash_table_contains (priv->connections_by_ssid, key))
+                        g_bytes_unref (key);
+                else
+                        g_hash_table_insert (priv->connections_by_ssid, key, connection);
+        }
+        g_slist_free (connections);
+
+        return priv->connections_by_ssid;
+}
+
+static void
+invalidate_connections (NetDeviceWifi *device_wifi)
+{
+        g_clear_pointer (&device_wifi->priv->connections_by_ssid, g_hash_table_unref);
+}
+
 static gboolean
 device_is_hotspot (NetDeviceWifi *device_wifi)
 {
@@ -602,6 +698,7 @@ nm_device_wifi_refresh_ui (NetDeviceWifi *device_wifi)
         panel_set_device_status (priv->builder, "heading_status", nm_device, NULL);
 
         /* update list of APs */
+        invalidate_connections (device_wifi);
         populate_ap_list (device_wifi);
 }
 
@@ -1318,6 +1415,7 @@ client_connection_added_cb (NMClient           *client,
 {
         gboolean is_hotspot;
 
+        invalidate_connections (device_wifi);
         populate_ap_list (device_wifi);
 
         /* go straight to the hotspot UI */
@@ -1333,33 +1431,9 @@ client_connection_removed_cb (NMClient           *client,
                               NMRemoteConnection *connection,
                               NetDeviceWifi      *device_wifi)
 {
-        GtkWidget *swin;
-        GtkWidget *list;
-        GList *rows, *l;
-        const char *uuid;
-
-        uuid = nm_connection_get_uuid (NM_CONNECTION (connection));
-
-        swin = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
-                                                   "scrolledwindow_list"));
-        list = gtk_bin_get_child (GTK_BIN (gtk_bin_get_child (GTK_BIN (swin))));
-        rows = gtk_container_get_children (GTK_CONTAINER (list));
-        for (l = rows; l != NULL; l = l->next) {
-                GtkWidget *row = l->data;
-                NMConnection *connection;
-                const char *uuid_r;
-
-                connection = g_object_get_data (G_OBJECT (row), "connection");
-                if (!connection)
-                        continue;
-
-                uuid_r = nm_connection_get_uuid (connection);
-                if (g_strcmp0 (uuid_r, uuid) == 0) {
-                        gtk_widget_destroy (row);
-                        break;
-                }
-        }
-        g_list_free (rows);
+        /* the row of the connection is dropped or left with the AP only */
+        invalidate_connections (device_wifi);
+        populate_ap_list (device_wifi);
 }
 
 static void
@@ -1370,7 +1444,9 @@ net_device_wifi_constructed (GObject *object)
         NMClientPermissionResult perm;
         NMDevice *nm_device;
         NMDeviceWifiCapabilities caps;
+        const GPtrArray *aps;
         GtkWidget *widget;
+        guint i;
 
         G_OBJECT_CLASS (net_device_wifi_parent_class)->constructed (object);
 
@@ -1381,12 +1457,16 @@ net_device_wifi_constructed (GObject *object)
         nm_device = net_device_get_nm_device (NET_DEVICE (device_wifi));
 
         g_signal_connect_object (nm_device, "access-point-added",
-                                 G_CALLBACK (net_device_wifi_access_point_changed),
+                                 G_CALLBACK (net_device_wifi_access_point_added),
                                  device_wifi, 0);
         g_signal_connect_object (nm_device, "access-point-removed",
-                                 G_CALLBACK (net_device_wifi_access_point_changed),
+                                 G_CALLBACK (net_device_wifi_access_point_removed),
                                  device_wifi, 0);
 
+        aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (nm_device));
+        for (i = 0; aps != NULL && i < aps->len; i++)
+                watch_access_point (device_wifi, g_ptr_array_index (aps, i));
+
         /* only enable the button if the user can create a hotspot */
         widget = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
                                                      "start_hotspot_button"));
@@ -1425,6 +1505,10 @@ net_device_wifi_finalize (GObject *object)
         g_free (priv->selected_ssid_title);
         g_free (priv->selected_connection_id);
         g_free (priv->selected_ap_id);
+        g_hash_table_unref (priv->ap_rows);
+        invalidate_connections (device_wifi);
+        if (priv->update_aps_id != 0)
+                g_source_remove (priv->update_aps_id);
 
         G_OBJECT_CLASS (net_device_wifi_parent_class)->finalize (object);
 }
@@ -1486,6 +1570,7 @@ really_forgotten (GObject            *source_object,
         }
 
         /* remove the entry from the list */
+        invalidate_connections (user_data);
         populate_ap_list (user_data);
 }
 
@@ -1573,6 +1658,41 @@ update_forget (GtkWidget *forget,
         gtk_widget_set_sensitive (forget, rows != NULL);
 }
 
+static void
+get_ap_state (NMDevice      *device,
+              NMAccessPoint *ap,
+              NMAccessPoint *active_ap,
+              gboolean      *active,
+              gboolean      *connecting)
+{
+        NMDeviceState state;
+
+        state = nm_device_get_state (device);
+
+        *active = (ap == active_ap) && (state == NM_DEVICE_STATE_ACTIVATED);
+        *connecting = (ap == active_ap) &&
+                      (state == NM_DEVICE_STATE_PREPARE ||
+                       state == NM_DEVICE_STATE_CONFIG ||
+                       state == NM_DEVICE_STATE_IP_CONFIG ||
+                       state == NM_DEVICE_STATE_IP_CHECK ||
+                       state == NM_DEVICE_STATE_NEED_AUTH);
+}
+
+static const gchar *
+get_strength_icon_name (guint strength)
+{
+        if (strength < 20)
+                return "network-wireless-signal-none-symbolic";
+        else if (strength < 40)
+                return "network-wireless-signal-weak-symbolic";
+        else if (strength < 50)
+                return "network-wireless-signal-ok-symbolic";
+        else if (strength < 80)
+                return "network-wireless-signal-good-symbolic";
+        else
+                return "network-wireless-signal-excellent-symbolic";
+}
+
 static void
 make_row (GtkSizeGroup   *rows,
           GtkSizeGroup   *icons,
@@ -1597,14 +1717,10 @@ make_row (GtkSizeGroup   *rows,
         guint security;
         guint strength;
         GBytes *ssid;
-        const gchar *icon_name;
         guint64 timestamp;
-        NMDeviceState state;
 
         g_assert (connection || ap);
 
-        state = nm_device_get_state (device);
-
         if (connection != NULL) {
                 NMSettingWireless *sw;
                 NMSettingConnection *sc;
@@ -1619,13 +1735,7 @@ make_row (GtkSizeGroup   *rows,
 
         if (ap != NULL) {
                 in_range = TRUE;
-                active = (ap == active_ap) && (state == NM_DEVICE_STATE_ACTIVATED);
-                connecting = (ap == active_ap) &&
-                             (state == NM_DEVICE_STATE_PREPARE ||
-                              state == NM_DEVICE_STATE_CONFIG ||
-                              state == NM_DEVICE_STATE_IP_CONFIG ||
-                              state == NM_DEVICE_STATE_IP_CHECK ||
-                              state == NM_DEVICE_STATE_NEED_AUTH);
+                get_ap_state (device, ap, active_ap, &active, &connecting);
                 security = get_access_point_security (ap);
                 strength = nm_access_point_get_strength (ap);
         } else {
@@ -1729,27 +1839,21 @@ make_row (GtkSizeGroup   *rows,
                 }
                 gtk_box_pack_start (GTK_BOX (box), widget, FALSE, FALSE, 0);
 
-                if (strength < 20)
-                        icon_name = "network-wireless-signal-none-symbolic";
-                else if (strength < 40)
-                        icon_name = "network-wireless-signal-weak-symbolic";
-                else if (strength < 50)
-                        icon_name = "network-wireless-signal-ok-symbolic";
-                else if (strength < 80)
-                        icon_name = "network-wireless-signal-good-symbolic";
-                else
-                        icon_name = "network-wireless-signal-excellent-symbolic";
-                widget = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_MENU);
+                widget = gtk_image_new_from_icon_name (get_strength_icon_name (strength), GTK_ICON_SIZE_MENU);
                 gtk_box_pack_start (GTK_BOX (box), widget, FALSE, FALSE, 0);
+                g_object_set_data (G_OBJECT (row), "strength_icon", widget);
         }
 
         gtk_widget_show_all (row);
 
-        g_object_set_data (G_OBJECT (row), "ap", ap);
+        /* the list is only updated some time after APs go away */
+        if (ap)
+                g_object_set_data_full (G_OBJECT (row), "ap", g_object_ref (ap), g_object_unref);
         if (connection)
                 g_object_set_data (G_OBJECT (row), "connection", connection);
         g_object_set_data (G_OBJECT (row), "timestamp", GUINT_TO_POINTER (timestamp));
         g_object_set_data (G_OBJECT (row), "active", GUINT_TO_POINTER (active));
+        g_object_set_data (G_OBJECT (row), "connecting", GUINT_TO_POINTER (connecting));
         g_object_set_data (G_OBJECT (row), "strength", GUINT_TO_POINTER (strength));
 
         *row_out = row;
@@ -1788,6 +1892,10 @@ editor_done (NetConnectionEditor *editor,
              NetDeviceWifi       *device_wifi)
 {
         g_object_unref (editor);
+
+        /* the SSID of the connection may have changed */
+        invalidate_connections (device_wifi);
+        queue_ap_list_update (device_wifi);
 }
 
 static void
@@ -1826,9 +1934,8 @@ open_history (NetDeviceWifi *device_wifi)
         GSList *connections;
         GSList *l;
         const GPtrArray *aps;
-        GPtrArray *aps_unique = NULL;
+        GHashTable *aps_unique;
         NMAccessPoint *active_ap;
-        guint i;
         NMDevice *nm_device;
         GtkWidget *list;
         GtkWidget *row;
@@ -1894,21 +2001,16 @@ open_history (NetDeviceWifi *device_wifi)
                 NMConnection *connection = l->data;
                 NMAccessPoint *ap = NULL;
                 NMSetting *setting;
-                GBytes *ssid;
+                GBytes *ssid, *key;
                 if (connection_is_shared (connection))
                         continue;
 
                 setting = nm_connection_get_setting_by_name (connection, NM_SETTING_WIRELESS_SETTING_NAME);
                 ssid = nm_setting_wireless_get_ssid (NM_SETTING_WIRELESS (setting));
-                for (i = 0; i < aps_unique->len; i++) {
-                        GBytes *ssid_ap;
-                        ap = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, i));
-                        ssid_ap = nm_access_point_get_ssid (ap);
-                        if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                g_bytes_get_data (ssid_ap, NULL), g_bytes_get_size (ssid_ap),
-                                                TRUE))
-                                break;
-                        ap = NULL;
+                if (ssid != NULL) {
+                        key = ssid_key_new (ssid);
+                        ap = g_hash_table_lookup (aps_unique, key);
+                        g_bytes_unref (key);
                 }
 
                 make_row (rows, icons, forget, nm_device, connection, ap, active_ap, &row, NULL, &button);
@@ -1920,73 +2022,112 @@ open_history (NetDeviceWifi *device_wifi)
                 }
         }
         g_slist_free (connections);
-        g_ptr_array_free (aps_unique, TRUE);
+        g_hash_table_unref (aps_unique);
 
         gtk_window_present (GTK_WINDOW (dialog));
 }
 
+/* whether the row has to be made again, rather than only having its
+ * strength updated */
+static gboolean
+row_is_stale (GtkWidget     *row,
+              NMDevice      *nm_device,
+              NMAccessPoint *ap,
+              NMConnection  *connection,
+              NMAccessPoint *active_ap)
+{
+        gboolean active, connecting;
+
+        if (g_object_get_data (G_OBJECT (row), "ap") != ap ||
+            g_object_get_data (G_OBJECT (row), "connection") != connection)
+                return TRUE;
+
+        get_ap_state (nm_device, ap, active_ap, &active, &connecting);
+
+        return GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row), "active")) != active ||
+               GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row), "connecting")) != connecting;
+}
+
+static void
+update_row_strength (GtkWidget     *row,
+                     NMAccessPoint *ap)
+{
+        GtkWidget *icon;
+        guint strength;
+
+        strength = nm_access_point_get_strength (ap);
+        if (GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (row), "strength")) == strength)
+                return;
+
+        g_object_set_data (G_OBJECT (row), "strength", GUINT_TO_POINTER (strength));
+        icon = g_object_get_data (G_OBJECT (row), "strength_icon");
+        gtk_image_set_from_icon_name (GTK_IMAGE (icon), get_strength_icon_name (strength), GTK_ICON_SIZE_MENU);
+
+        /* only this row moves */
+        gtk_list_box_row_changed (GTK_LIST_BOX_ROW (row));
+}
+
 static void
 populate_ap_list (NetDeviceWifi *device_wifi)
 {
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
         GtkWidget *swin;
         GtkWidget *list;
         GtkSizeGroup *rows;
         GtkSizeGroup *icons;
         NMDevice *nm_device;
-        GSList *connections;
-        GSList *l;
+        GHashTable *connections;
         const GPtrArray *aps;
-        GPtrArray *aps_unique = NULL;
+        GHashTable *aps_unique;
         NMAccessPoint *active_ap;
-        guint i;
+        GHashTableIter iter;
+        gpointer key, value;
         GtkWidget *row;
         GtkWidget *button;
-        GList *children, *child;
 
-        swin = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
+        if (priv->update_aps_id != 0) {
+                g_source_remove (priv->update_aps_id);
+                priv->update_aps_id = 0;
+        }
+
+        swin = GTK_WIDGET (gtk_builder_get_object (priv->builder,
                                                    "scrolledwindow_list"));
         list = gtk_bin_get_child (GTK_BIN (gtk_bin_get_child (GTK_BIN (swin))));
 
-        children = gtk_container_get_children (GTK_CONTAINER (list));
-        for (child = children; child; child = child->next) {
-                gtk_container_remove (GTK_CONTAINER (list), GTK_WIDGET (child->data));
-        }
-        g_list_free (children);
-
         rows = GTK_SIZE_GROUP (g_object_get_data (G_OBJECT (list), "rows"));
         icons = GTK_SIZE_GROUP (g_object_get_data (G_OBJECT (list), "icons"));
 
         nm_device = net_device_get_nm_device (NET_DEVICE (device_wifi));
 
-        connections = net_device_get_valid_connections (NET_DEVICE (device_wifi));
+        connections = get_connections_by_ssid (device_wifi);
 
         aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (nm_device));
         aps_unique = panel_get_strongest_unique_aps (aps);
         active_ap = nm_device_wifi_get_active_access_point (NM_DEVICE_WIFI (nm_device));
 
-        for (i = 0; i < aps_unique->len; i++) {
-                GBytes *ssid_ap;
-                NMAccessPoint *ap;
-                NMConnection *connection = NULL;
-                ap = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, i));
-                ssid_ap = nm_access_point_get_ssid (ap);
-                for (l = connections; l; l = l->next) {
-                        connection = l->data;
-                        NMSetting *setting;
-                        GBytes *ssid;
+        /* remove the networks that went out of range */
+        g_hash_table_iter_init (&iter, priv->ap_rows);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+                if (!g_hash_table_contains (aps_unique, key)) {
+                        gtk_widget_destroy (GTK_WIDGET (value));
+                        g_hash_table_iter_remove (&iter);
+                }
+        }
+
+        g_hash_table_iter_init (&iter, aps_unique);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+                NMAccessPoint *ap = value;
+                NMConnection *connection;
 
-                        if (connection_is_shared (connection)) {
-                                connection = NULL;
+                connection = g_hash_table_lookup (connections, key);
+
+                row = g_hash_table_lookup (priv->ap_rows, key);
+                if (row != NULL) {
+                        if (!row_is_stale (row, nm_device, ap, connection, active_ap)) {
+                                update_row_strength (row, ap);
                                 continue;
                         }
-
-                        setting = nm_connection_get_setting_by_name (connection, NM_SETTING_WIRELESS_SETTING_NAME);
-                        ssid = nm_setting_wireless_get_ssid (NM_SETTING_WIRELESS (setting));
-                        if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                g_bytes_get_data (ssid_ap, NULL), g_bytes_get_size (ssid_ap),
-                                                TRUE))
-                                break;
-                        connection = NULL;
+                        gtk_widget_destroy (row);
                 }
 
                 make_row (rows, icons, NULL, nm_device, connection, ap, active_ap, &row, NULL, &button);
@@ -1996,10 +2137,10 @@ populate_ap_list (NetDeviceWifi *device_wifi)
                                           G_CALLBACK (show_details_for_row), device_wifi);
                         g_object_set_data (G_OBJECT (button), "row", row);
                 }
+                g_hash_table_replace (priv->ap_rows, g_bytes_ref (key), row);
         }
 
-        g_slist_free (connections);
-        g_ptr_array_free (aps_unique, TRUE);
+        g_hash_table_unref (aps_unique);
 }
 
 static void
@@ -2051,6 +2192,7 @@ net_device_wifi_init (NetDeviceWifi *device_wifi)
         GtkSizeGroup *icons;
 
         device_wifi->priv = NET_DEVICE_WIFI_GET_PRIVATE (device_wifi);
+        device_wifi->priv->ap_rows = ssid_table_new (NULL);
 
         device_wifi->priv->builder = gtk_builder_new ();
         gtk_builder_add_from_resource (device_wifi->priv->builder,
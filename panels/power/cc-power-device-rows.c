@@ -0,0 +1,915 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2010 Red Hat, Inc
+ * Copyright (C) 2008 William Jon McCann <jmccann@redhat.com>
+ * Copyright (C) 2010,2015 Richard Hughes <richard@hughsie.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <glib/gi18n.h>
+
+#include "cc-power-device-rows.h"
+
+/* The battery and device rows of the power panel, kept in sync with
+ * the UPower devices without rebuilding the lists */
+struct _CcPowerDeviceRows
+{
+  GPtrArray     *devices;
+  UpDevice      *composite;
+  GtkWidget     *composite_row;
+  GHashTable    *device_rows;
+  GHashTable    *dirty_devices;
+  guint          update_rows_id;
+
+  GtkWidget     *battery_heading;
+  GtkWidget     *battery_section;
+  GtkWidget     *battery_list;
+  GtkWidget     *device_section;
+  GtkWidget     *device_list;
+
+  GtkSizeGroup  *row_sizegroup;
+  GtkSizeGroup  *battery_sizegroup;
+  GtkSizeGroup  *charge_sizegroup;
+  GtkSizeGroup  *level_sizegroup;
+
+  CcPowerDeviceRowsStats stats;
+};
+
+static GtkWidget *
+no_prelight_row_new (void)
+{
+  return (GtkWidget *) g_object_new (GTK_TYPE_LIST_BOX_ROW,
+                                     "selectable", FALSE,
+                                     "activatable", FALSE,
+                                     NULL);
+}
+
+static gchar *
+get_timestring (guint64 time_secs)
+{
+  gchar* timestring = NULL;
+  gint  hours;
+  gint  minutes;
+
+  /* Add 0.5 to do rounding */
+  minutes = (int) ( ( time_secs / 60.0 ) + 0.5 );
+
+  if (minutes == 0)
+    {
+      timestring = g_strdup (_("Unknown time"));
+      return timestring;
+    }
+
+  if (minutes < 60)
+    {
+      timestring = g_strdup_printf (ngettext ("%i minute",
+                                    "%i minutes",
+                                    minutes), minutes);
+      return timestring;
+    }
+
+  hours = minutes / 60;
+  minutes = minutes % 60;
+
+  if (minutes == 0)
+    {
+      timestring = g_strdup_printf (ngettext (
+                                    "%i hour",
+                                    "%i hours",
+                                    hours), hours);
+      return timestring;
+    }
+
+  /* TRANSLATOR: "%i %s %i %s" are "%i hours %i minutes"
+   * Swap order with "%2$s %2$i %1$s %1$i if needed */
+  timestring = g_strdup_printf (_("%i %s %i %s"),
+                                hours, ngettext ("hour", "hours", hours),
+                                minutes, ngettext ("minute", "minutes", minutes));
+  return timestring;
+}
+
+static gchar *
+get_details_string (gdouble percentage, UpDeviceState state, guint64 time)
+{
+  gchar *details;
+
+  if (time > 0)
+    {
+      gchar *time_string;
+
+      time_string = get_timestring (time);
+      switch (state)
+        {
+          case UP_DEVICE_STATE_CHARGING:
+          case UP_DEVICE_STATE_PENDING_CHARGE:
+            /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
+            details = g_strdup_printf (_("%s until fully charged"), time_string);
+            break;
+          case UP_DEVICE_STATE_DISCHARGING:
+          case UP_DEVICE_STATE_PENDING_DISCHARGE:
+            if (percentage < 20)
+              {
+                /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
+                details = g_strdup_printf (_("Caution: %s remaining"), time_string);
+              }
+            else
+              {
+                /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
+                details = g_strdup_printf (_("%s remaining"), time_string);
+              }
+            break;
+          case UP_DEVICE_STATE_FULLY_CHARGED:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Fully charged"));
+            break;
+          case UP_DEVICE_STATE_EMPTY:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Empty"));
+            break;
+          default:
+            details = g_strdup_printf ("error: %s", up_device_state_to_string (state));
+            break;
+        }
+      g_free (time_string);
+    }
+  else
+    {
+      switch (state)
+        {
+          case UP_DEVICE_STATE_CHARGING:
+          case UP_DEVICE_STATE_PENDING_CHARGE:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Charging"));
+            break;
+          case UP_DEVICE_STATE_DISCHARGING:
+          case UP_DEVICE_STATE_PENDING_DISCHARGE:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Discharging"));
+            break;
+          case UP_DEVICE_STATE_FULLY_CHARGED:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Fully charged"));
+            break;
+          case UP_DEVICE_STATE_EMPTY:
+            /* TRANSLATORS: primary battery */
+            details = g_strdup (_("Empty"));
+            break;
+          default:
+            details = g_strdup_printf ("error: %s",
+                                       up_device_state_to_string (state));
+            break;
+        }
+    }
+
+  return details;
+}
+
+/* How a device shows up in the lists, a row is only rebuilt when this
+ * changes, otherwise its labels are updated in place */
+typedef enum
+{
+  DEVICE_ROLE_NONE,
+  DEVICE_ROLE_PRIMARY,
+  DEVICE_ROLE_MAIN_BATTERY,
+  DEVICE_ROLE_EXTRA_BATTERY,
+  DEVICE_ROLE_DEVICE
+} DeviceRole;
+
+static GtkWidget *
+create_primary_row (void)
+{
+  GtkWidget *box, *box2, *label;
+  GtkWidget *levelbar, *row;
+
+  row = no_prelight_row_new ();
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_container_add (GTK_CONTAINER (row), box);
+
+  gtk_widget_set_margin_start (box, 20);
+  gtk_widget_set_margin_end (box, 20);
+  gtk_widget_set_margin_top (box, 6);
+  gtk_widget_set_margin_bottom (box, 6);
+
+  levelbar = gtk_level_bar_new ();
+  gtk_widget_set_hexpand (levelbar, TRUE);
+  gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
+  gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box), levelbar, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", levelbar);
+
+  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 50);
+  gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
+
+  label = gtk_label_new (NULL);
+  gtk_widget_set_halign (label, GTK_ALIGN_START);
+  gtk_box_pack_start (GTK_BOX (box2), label, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "details", label);
+
+  label = gtk_label_new (NULL);
+  gtk_widget_set_halign (label, GTK_ALIGN_END);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "level", label);
+
+  atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
+                               ATK_RELATION_LABELLED_BY,
+                               gtk_widget_get_accessible (label));
+
+  g_object_set_data (G_OBJECT (row), "primary", GINT_TO_POINTER (TRUE));
+
+  return row;
+}
+
+static void
+update_primary_row (GtkWidget *row, UpDevice *device)
+{
+  gchar *details = NULL;
+  gdouble percentage;
+  guint64 time_empty, time_full, time;
+  UpDeviceState state;
+  gchar *s;
+
+  g_object_get (device,
+                "state", &state,
+                "percentage", &percentage,
+                "time-to-empty", &time_empty,
+                "time-to-full", &time_full,
+                NULL);
+  if (state == UP_DEVICE_STATE_DISCHARGING)
+    time = time_empty;
+  else
+    time = time_full;
+
+  /* Sometimes the reported state is fully charged but battery is at 99%,
+     refusing to reach 100%. In these cases, just assume 100%. */
+  if (state == UP_DEVICE_STATE_FULLY_CHARGED && (100.0 - percentage <= 1.0))
+    percentage = 100.0;
+
+  details = get_details_string (percentage, state, time);
+  gtk_label_set_label (GTK_LABEL (g_object_get_data (G_OBJECT (row), "details")), details);
+  g_free (details);
+
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (g_object_get_data (G_OBJECT (row), "levelbar")),
+                           percentage / 100.0);
+
+  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
+  gtk_label_set_label (GTK_LABEL (g_object_get_data (G_OBJECT (row), "level")), s);
+  g_free (s);
+}
+
+static GtkWidget *
+create_battery_row (CcPowerDeviceRows *rows, DeviceRole role)
+{
+  GtkWidget *row;
+  GtkWidget *box;
+  GtkWidget *box2;
+  GtkWidget *label;
+  GtkWidget *levelbar;
+  GtkWidget *widget;
+  const gchar *name;
+
+  if (role == DEVICE_ROLE_MAIN_BATTERY)
+    name = C_("Battery name", "Main");
+  else
+    name = C_("Battery name", "Extra");
+
+  row = no_prelight_row_new ();
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  gtk_container_add (GTK_CONTAINER (row), box);
+
+  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  label = gtk_label_new (name);
+  gtk_widget_set_halign (label, GTK_ALIGN_START);
+  gtk_size_group_add_widget (rows->battery_sizegroup, box2);
+  gtk_widget_set_margin_start (label, 20);
+  gtk_widget_set_margin_end (label, 20);
+  gtk_widget_set_margin_top (label, 6);
+  gtk_widget_set_margin_bottom (label, 6);
+  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
+
+  /* only shown when the device has an icon */
+  widget = gtk_image_new ();
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_widget_set_halign (widget, GTK_ALIGN_END);
+  gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "icon", widget);
+
+  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+  gtk_widget_set_margin_start (box2, 20);
+  gtk_widget_set_margin_end (box2, 20);
+
+  label = gtk_label_new (NULL);
+  gtk_widget_set_halign (label, GTK_ALIGN_END);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
+  gtk_size_group_add_widget (rows->charge_sizegroup, label);
+  g_object_set_data (G_OBJECT (row), "level", label);
+
+  levelbar = gtk_level_bar_new ();
+  gtk_widget_set_hexpand (levelbar, TRUE);
+  gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
+  gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box2), levelbar, TRUE, TRUE, 0);
+  gtk_size_group_add_widget (rows->level_sizegroup, levelbar);
+  gtk_box_pack_start (GTK_BOX (box), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", levelbar);
+
+  atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
+                               ATK_RELATION_LABELLED_BY,
+                               gtk_widget_get_accessible (label));
+
+  return row;
+}
+
+static void
+update_battery_row (GtkWidget *row, UpDevice *device)
+{
+  gdouble percentage;
+  GtkWidget *widget;
+  gchar *s;
+  gchar *icon_name;
+
+  g_object_get (device,
+                "percentage", &percentage,
+                "icon-name", &icon_name,
+                NULL);
+
+  widget = g_object_get_data (G_OBJECT (row), "icon");
+  if (icon_name != NULL && *icon_name != '\0')
+    {
+      gtk_image_set_from_icon_name (GTK_IMAGE (widget), icon_name, GTK_ICON_SIZE_BUTTON);
+      gtk_widget_show (widget);
+    }
+  else
+    {
+      gtk_widget_hide (widget);
+    }
+  g_free (icon_name);
+
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  gtk_label_set_label (GTK_LABEL (g_object_get_data (G_OBJECT (row), "level")), s);
+  g_free (s);
+
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (g_object_get_data (G_OBJECT (row), "levelbar")),
+                           percentage / 100.0);
+}
+
+static const char *
+kind_to_description (UpDeviceKind kind)
+{
+  switch (kind)
+    {
+      case UP_DEVICE_KIND_MOUSE:
+        /* TRANSLATORS: secondary battery */
+        return N_("Wireless mouse");
+      case UP_DEVICE_KIND_KEYBOARD:
+        /* TRANSLATORS: secondary battery */
+        return N_("Wireless keyboard");
+      case UP_DEVICE_KIND_UPS:
+        /* TRANSLATORS: secondary battery */
+        return N_("Uninterruptible power supply");
+      case UP_DEVICE_KIND_PDA:
+        /* TRANSLATORS: secondary battery */
+        return N_("Personal digital assistant");
+      case UP_DEVICE_KIND_PHONE:
+        /* TRANSLATORS: secondary battery */
+        return N_("Cellphone");
+      case UP_DEVICE_KIND_MEDIA_PLAYER:
+        /* TRANSLATORS: secondary battery */
+        return N_("Media player");
+      case UP_DEVICE_KIND_TABLET:
+        /* TRANSLATORS: secondary battery */
+        return N_("Tablet");
+      case UP_DEVICE_KIND_COMPUTER:
+        /* TRANSLATORS: secondary battery */
+        return N_("Computer");
+      default:
+        /* TRANSLATORS: secondary battery, misc */
+        return N_("Battery");
+    }
+
+  g_assert_not_reached ();
+}
+
+static GtkWidget *
+create_device_row (CcPowerDeviceRows *rows)
+{
+  GtkWidget *row;
+  GtkWidget *hbox;
+  GtkWidget *box2;
+  GtkWidget *widget;
+
+  row = no_prelight_row_new ();
+  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  gtk_container_add (GTK_CONTAINER (row), hbox);
+  widget = gtk_label_new ("");
+  gtk_widget_set_halign (widget, GTK_ALIGN_START);
+  gtk_widget_set_margin_start (widget, 20);
+  gtk_widget_set_margin_end (widget, 20);
+  gtk_widget_set_margin_top (widget, 6);
+  gtk_widget_set_margin_bottom (widget, 6);
+  gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, TRUE, 0);
+  gtk_size_group_add_widget (rows->battery_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "description", widget);
+
+  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+  gtk_widget_set_margin_start (box2, 20);
+  gtk_widget_set_margin_end (box2, 20);
+  widget = gtk_label_new (NULL);
+  gtk_widget_set_halign (widget, GTK_ALIGN_END);
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_box_pack_start (GTK_BOX (box2), widget, FALSE, TRUE, 0);
+  gtk_size_group_add_widget (rows->charge_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "level", widget);
+
+  widget = gtk_level_bar_new ();
+  gtk_widget_set_halign (widget, TRUE);
+  gtk_widget_set_halign (widget, GTK_ALIGN_FILL);
+  gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
+  gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
+  gtk_size_group_add_widget (rows->level_sizegroup, widget);
+  gtk_box_pack_start (GTK_BOX (hbox), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", widget);
+
+  return row;
+}
+
+static void
+update_device_row (GtkWidget *row, UpDevice *device)
+{
+  UpDeviceKind kind;
+  gdouble percentage;
+  gchar *name;
+  gchar *s;
+
+  name = NULL;
+  g_object_get (device,
+                "kind", &kind,
+                "percentage", &percentage,
+                "model", &name,
+                NULL);
+
+  if (name == NULL || *name == '\0')
+    gtk_label_set_markup (GTK_LABEL (g_object_get_data (G_OBJECT (row), "description")),
+                          _(kind_to_description (kind)));
+  else
+    gtk_label_set_markup (GTK_LABEL (g_object_get_data (G_OBJECT (row), "description")),
+                          name);
+  g_free (name);
+
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  gtk_label_set_label (GTK_LABEL (g_object_get_data (G_OBJECT (row), "level")), s);
+  g_free (s);
+
+  gtk_level_bar_set_value (GTK_LEVEL_BAR (g_object_get_data (G_OBJECT (row), "levelbar")),
+                           percentage / 100.0f);
+}
+
+static DeviceRole
+get_device_role (UpDevice *device,
+                 gboolean  on_ups,
+                 guint     n_batteries)
+{
+  UpDeviceKind kind;
+  gboolean is_present;
+
+  g_object_get (device,
+                "kind", &kind,
+                "is-present", &is_present,
+                NULL);
+
+  if (kind == UP_DEVICE_KIND_LINE_POWER)
+    return DEVICE_ROLE_NONE;
+  else if (kind == UP_DEVICE_KIND_UPS && on_ups)
+    return DEVICE_ROLE_PRIMARY;
+  else if (kind == UP_DEVICE_KIND_BATTERY && !on_ups && n_batteries == 1)
+    return DEVICE_ROLE_PRIMARY;
+  else if (kind == UP_DEVICE_KIND_BATTERY)
+    {
+      if (g_object_get_data (G_OBJECT (device), "is-main-battery") != NULL)
+        return DEVICE_ROLE_MAIN_BATTERY;
+      return DEVICE_ROLE_EXTRA_BATTERY;
+    }
+  else if (is_present)
+    return DEVICE_ROLE_DEVICE;
+
+  return DEVICE_ROLE_NONE;
+}
+
+/* Returns the row showing @device in @role, reusing @row when it
+ * already does, and only refreshing its contents when @update is set */
+static GtkWidget *
+sync_device_row (CcPowerDeviceRows *rows,
+                 GtkWidget         *row,
+                 UpDevice          *device,
+                 DeviceRole         role,
+                 gboolean           update)
+{
+  UpDeviceKind kind;
+
+  g_object_get (device, "kind", &kind, NULL);
+
+  if (row != NULL &&
+      (GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "role")) != role ||
+       GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "kind")) != (gint) kind))
+    {
+      gtk_widget_destroy (row);
+      row = NULL;
+    }
+
+  if (role == DEVICE_ROLE_NONE)
+    return NULL;
+
+  if (row == NULL)
+    {
+      GtkWidget *list;
+
+      switch (role)
+        {
+          case DEVICE_ROLE_PRIMARY:
+            row = create_primary_row ();
+            list = rows->battery_list;
+            break;
+          case DEVICE_ROLE_MAIN_BATTERY:
+          case DEVICE_ROLE_EXTRA_BATTERY:
+            row = create_battery_row (rows, role);
+            list = rows->battery_list;
+            break;
+          default:
+            row = create_device_row (rows);
+            list = rows->device_list;
+            break;
+        }
+
+      /* the list sorts the row when it is added, so everything the sort
+       * function looks at has to be there by then */
+      g_object_set_data (G_OBJECT (row), "role", GINT_TO_POINTER (role));
+      g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
+      gtk_container_add (GTK_CONTAINER (list), row);
+      gtk_size_group_add_widget (rows->row_sizegroup, row);
+      gtk_widget_show_all (row);
+      rows->stats.n_created++;
+      update = TRUE;
+    }
+
+  if (!update)
+    return row;
+
+  rows->stats.n_updated++;
+
+  switch (role)
+    {
+      case DEVICE_ROLE_PRIMARY:
+        update_primary_row (row, device);
+        break;
+      case DEVICE_ROLE_MAIN_BATTERY:
+      case DEVICE_ROLE_EXTRA_BATTERY:
+        update_battery_row (row, device);
+        break;
+      default:
+        update_device_row (row, device);
+        break;
+    }
+
+  return row;
+}
+
+static gchar *
+get_device_key (UpDevice *device)
+{
+  gchar *native_path = NULL;
+
+  g_object_get (device, "native-path", &native_path, NULL);
+  if (native_path == NULL || *native_path == '\0')
+    {
+      g_free (native_path);
+      native_path = g_strdup (up_device_get_object_path (device));
+    }
+
+  return native_path;
+}
+
+static void
+update_device_rows (CcPowerDeviceRows *rows)
+{
+  GHashTable *new_rows;
+  GHashTableIter iter;
+  gpointer value;
+  GtkWidget *row;
+  gint i;
+  UpDeviceKind kind;
+  DeviceRole role;
+  guint n_batteries;
+  guint n_battery_rows;
+  guint n_device_rows;
+  guint n_updated;
+  gboolean on_ups;
+  gchar *key;
+  gchar *s;
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+
+  rows->stats.n_syncs++;
+  n_updated = rows->stats.n_updated;
+
+  on_ups = FALSE;
+  n_batteries = 0;
+  n_battery_rows = 0;
+  n_device_rows = 0;
+  if (rows->composite != NULL)
+    g_object_get (rows->composite, "kind", &kind, NULL);
+  else
+    kind = UP_DEVICE_KIND_UNKNOWN;
+  if (kind == UP_DEVICE_KIND_UPS)
+    {
+      on_ups = TRUE;
+    }
+  else
+    {
+      gboolean is_extra_battery = FALSE;
+
+      /* Count the batteries */
+      for (i = 0; i < rows->devices->len; i++)
+        {
+          UpDevice *device = (UpDevice*) g_ptr_array_index (rows->devices, i);
+          g_object_get (device, "kind", &kind, NULL);
+          if (kind == UP_DEVICE_KIND_BATTERY)
+            {
+              n_batteries++;
+              if (is_extra_battery == FALSE)
+                {
+                  is_extra_battery = TRUE;
+                  g_object_set_data (G_OBJECT (device), "is-main-battery", GINT_TO_POINTER(TRUE));
+                }
+            }
+        }
+    }
+
+  if (n_batteries > 1)
+    s = g_strdup_printf ("<b>%s</b>", _("Batteries"));
+  else
+    s = g_strdup_printf ("<b>%s</b>", _("Battery"));
+  gtk_label_set_label (GTK_LABEL (rows->battery_heading), s);
+  g_free (s);
+
+  /* the overall level when there are several batteries */
+  if (rows->composite != NULL)
+    rows->composite_row = sync_device_row (rows, rows->composite_row, rows->composite,
+                                           !on_ups && n_batteries > 1 ? DEVICE_ROLE_PRIMARY : DEVICE_ROLE_NONE,
+                                           g_hash_table_contains (rows->dirty_devices, rows->composite));
+  if (rows->composite_row != NULL)
+    n_battery_rows++;
+
+  /* move the rows that are still needed over to a new table, anything
+   * left in the old one belongs to a device that went away */
+  new_rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (i = 0; i < rows->devices->len; i++)
+    {
+      UpDevice *device = (UpDevice*) g_ptr_array_index (rows->devices, i);
+
+      key = get_device_key (device);
+      if (g_hash_table_contains (new_rows, key))
+        {
+          g_free (key);
+          continue;
+        }
+
+      row = g_hash_table_lookup (rows->device_rows, key);
+      if (row != NULL)
+        g_hash_table_remove (rows->device_rows, key);
+
+      role = get_device_role (device, on_ups, n_batteries);
+      row = sync_device_row (rows, row, device, role,
+                             g_hash_table_contains (rows->dirty_devices, device));
+      if (row == NULL)
+        {
+          g_free (key);
+          continue;
+        }
+
+      if (role == DEVICE_ROLE_DEVICE)
+        n_device_rows++;
+      else
+        n_battery_rows++;
+      g_hash_table_insert (new_rows, key, row);
+    }
+
+  g_hash_table_iter_init (&iter, rows->device_rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    gtk_widget_destroy (GTK_WIDGET (value));
+  g_hash_table_unref (rows->device_rows);
+  rows->device_rows = new_rows;
+  g_hash_table_remove_all (rows->dirty_devices);
+
+  gtk_widget_set_visible (rows->battery_section, n_battery_rows > 0);
+  gtk_widget_set_visible (rows->device_section, n_device_rows > 0);
+
+  g_debug ("Updated %u of %u devices in %" G_GINT64_FORMAT " µs",
+           rows->stats.n_updated - n_updated, rows->devices->len,
+           g_get_monotonic_time () - start);
+}
+
+static gboolean
+update_device_rows_tick_cb (GtkWidget     *widget,
+                            GdkFrameClock *frame_clock,
+                            gpointer       user_data)
+{
+  CcPowerDeviceRows *rows = user_data;
+
+  rows->update_rows_id = 0;
+  update_device_rows (rows);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* UPower sends a notify per property, and devices tend to change
+ * together, so only look at them once per frame */
+static void
+queue_device_rows_update (CcPowerDeviceRows *rows)
+{
+  if (rows->update_rows_id != 0)
+    return;
+
+  rows->update_rows_id = gtk_widget_add_tick_callback (rows->battery_list,
+                                                       update_device_rows_tick_cb,
+                                                       rows, NULL);
+}
+
+static void
+device_notify_cb (UpDevice          *device,
+                  GParamSpec        *pspec,
+                  CcPowerDeviceRows *rows)
+{
+  g_hash_table_add (rows->dirty_devices, device);
+  queue_device_rows_update (rows);
+}
+
+static void
+watch_device (CcPowerDeviceRows *rows,
+              UpDevice          *device)
+{
+  g_signal_connect (G_OBJECT (device), "notify",
+                    G_CALLBACK (device_notify_cb), rows);
+}
+
+static void
+unwatch_device (CcPowerDeviceRows *rows,
+                UpDevice          *device)
+{
+  g_signal_handlers_disconnect_by_func (G_OBJECT (device),
+                                        G_CALLBACK (device_notify_cb), rows);
+  g_hash_table_remove (rows->dirty_devices, device);
+}
+
+/* The lists and size groups belong to the caller and have to outlive
+ * the returned object */
+CcPowerDeviceRows *
+cc_power_device_rows_new (GtkWidget    *battery_heading,
+                          GtkWidget    *battery_section,
+                          GtkWidget    *battery_list,
+                          GtkWidget    *device_section,
+                          GtkWidget    *device_list,
+                          GtkSizeGroup *row_sizegroup,
+                          GtkSizeGroup *battery_sizegroup,
+                          GtkSizeGroup *charge_sizegroup,
+                          GtkSizeGroup *level_sizegroup)
+{
+  CcPowerDeviceRows *rows;
+
+  rows = g_new0 (CcPowerDeviceRows, 1);
+  rows->devices = g_ptr_array_new_with_free_func (g_object_unref);
+  rows->device_rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  rows->dirty_devices = g_hash_table_new (NULL, NULL);
+  rows->battery_heading = battery_heading;
+  rows->battery_section = battery_section;
+  rows->battery_list = battery_list;
+  rows->device_section = device_section;
+  rows->device_list = device_list;
+  rows->row_sizegroup = row_sizegroup;
+  rows->battery_sizegroup = battery_sizegroup;
+  rows->charge_sizegroup = charge_sizegroup;
+  rows->level_sizegroup = level_sizegroup;
+
+  return rows;
+}
+
+void
+cc_power_device_rows_free (CcPowerDeviceRows *rows)
+{
+  guint i;
+
+  if (rows->update_rows_id != 0)
+    gtk_widget_remove_tick_callback (rows->battery_list, rows->update_rows_id);
+  for (i = 0; i < rows->devices->len; i++)
+    unwatch_device (rows, g_ptr_array_index (rows->devices, i));
+  g_ptr_array_unref (rows->devices);
+  if (rows->composite != NULL)
+    {
+      unwatch_device (rows, rows->composite);
+      g_object_unref (rows->composite);
+    }
+  g_hash_table_unref (rows->device_rows);
+  g_hash_table_unref (rows->dirty_devices);
+  g_free (rows);
+}
+
+void
+cc_power_device_rows_set_composite (CcPowerDeviceRows *rows,
+                                    UpDevice          *composite)
+{
+  if (rows->composite != NULL)
+    {
+      unwatch_device (rows, rows->composite);
+      g_object_unref (rows->composite);
+    }
+  rows->composite = composite != NULL ? g_object_ref (composite) : NULL;
+  if (rows->composite != NULL)
+    {
+      watch_device (rows, rows->composite);
+      g_hash_table_add (rows->dirty_devices, rows->composite);
+    }
+  queue_device_rows_update (rows);
+}
+
+void
+cc_power_device_rows_add_device (CcPowerDeviceRows *rows,
+                                 UpDevice          *device)
+{
+  g_ptr_array_add (rows->devices, g_object_ref (device));
+  watch_device (rows, device);
+  queue_device_rows_update (rows);
+}
+
+void
+cc_power_device_rows_remove_device (CcPowerDeviceRows *rows,
+                                    const gchar       *object_path)
+{
+  guint i;
+
+  for (i = 0; i < rows->devices->len; i++)
+    {
+      UpDevice *device = g_ptr_array_index (rows->devices, i);
+
+      if (g_strcmp0 (object_path, up_device_get_object_path (device)) == 0)
+        {
+          unwatch_device (rows, device);
+          g_ptr_array_remove_index (rows->devices, i);
+          break;
+        }
+    }
+
+  queue_device_rows_update (rows);
+}
+
+/* Brings the rows up to date right away instead of at the next frame */
+void
+cc_power_device_rows_update (CcPowerDeviceRows *rows)
+{
+  if (rows->update_rows_id != 0)
+    {
+      gtk_widget_remove_tick_callback (rows->battery_list, rows->update_rows_id);
+      rows->update_rows_id = 0;
+    }
+  update_device_rows (rows);
+}
+
+GtkWidget *
+cc_power_device_rows_get_row (CcPowerDeviceRows *rows,
+                              UpDevice          *device)
+{
+  GtkWidget *row;
+  gchar *key;
+
+  if (device == rows->composite)
+    return rows->composite_row;
+
+  key = get_device_key (device);
+  row = g_hash_table_lookup (rows->device_rows, key);
+  g_free (key);
+
+  return row;
+}
+
+const CcPowerDeviceRowsStats *
+cc_power_device_rows_get_stats (CcPowerDeviceRows *rows)
+{
+  return &rows->stats;
+}
@@ -0,0 +1,64 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2010 Red Hat, Inc
+ * Copyright (C) 2010,2015 Richard Hughes <richard@hughsie.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __CC_POWER_DEVICE_ROWS_H__
+#define __CC_POWER_DEVICE_ROWS_H__
+
+#include <gtk/gtk.h>
+#include <libupower-glib/upower.h>
+
+G_BEGIN_DECLS
+
+typedef struct _CcPowerDeviceRows CcPowerDeviceRows;
+
+typedef struct
+{
+  guint n_syncs;   /* passes over the devices */
+  guint n_created; /* rows built */
+  guint n_updated; /* rows refreshed with new device values */
+} CcPowerDeviceRowsStats;
+
+CcPowerDeviceRows *cc_power_device_rows_new           (GtkWidget         *battery_heading,
+                                                       GtkWidget         *battery_section,
+                                                       GtkWidget         *battery_list,
+                                                       GtkWidget         *device_section,
+                                                       GtkWidget         *device_list,
+                                                       GtkSizeGroup      *row_sizegroup,
+                                                       GtkSizeGroup      *battery_sizegroup,
+                                                       GtkSizeGroup      *charge_sizegroup,
+                                                       GtkSizeGroup      *level_sizegroup);
+void               cc_power_device_rows_free          (CcPowerDeviceRows *rows);
+
+void               cc_power_device_rows_set_composite (CcPowerDeviceRows *rows,
+                                                       UpDevice          *composite);
+void               cc_power_device_rows_add_device    (CcPowerDeviceRows *rows,
+                                                       UpDevice          *device);
+void               cc_power_device_rows_remove_device (CcPowerDeviceRows *rows,
+                                                       const gchar       *object_path);
+void               cc_power_device_rows_update        (CcPowerDeviceRows *rows);
+
+GtkWidget         *cc_power_device_rows_get_row       (CcPowerDeviceRows *rows,
+                                                       UpDevice          *device);
+const CcPowerDeviceRowsStats *
+                   cc_power_device_rows_get_stats     (CcPowerDeviceRows *rows);
+
+G_END_DECLS
+
+#endif /* __CC_POWER_DEVICE_ROWS_H__ */
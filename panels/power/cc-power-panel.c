@@ -30,6 +30,7 @@
 #endif
 
 #include "shell/list-box-helper.h"
+#include "cc-power-device-rows.h"
 #include "cc-power-panel.h"
 #include "cc-power-resources.h"
 
@@ -39,12 +40,6 @@
  * #define TEST_NO_BATTERIES
  */
 
-/* Uncomment this to test the behaviour of the panel with
- * multiple appearing devices
- *
- * #define TEST_FAKE_DEVICES
- */
-
 #define WID(b, w) (GtkWidget *) gtk_builder_get_object (b, w)
 
 CC_PANEL_REGISTER (CcPowerPanel, cc_power_panel)
@@ -52,6 +47,21 @@ CC_PANEL_REGISTER (CcPowerPanel, cc_power_panel)
 #define POWER_PANEL_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), CC_TYPE_POWER_PANEL, CcPowerPanelPrivate))
 
+/* Brightness changes for one of the g-s-d interfaces: only one Set call
+ * is in flight at a time, and the latest slider value is sent at the
+ * next frame after it returns */
+typedef struct
+{
+  const gchar   *interface;
+  GDBusProxy   **proxy;
+  GtkWidget    **scale;
+  gboolean       syncing;
+  gboolean       in_flight;
+  gint           pending;
+  guint          tick_id;
+  gint64         sent_time;
+} BrightnessSetter;
+
 struct _CcPowerPanelPrivate
 {
   GSettings     *gsd_settings;
@@ -60,7 +70,7 @@ struct _CcPowerPanelPrivate
   GtkBuilder    *builder;
   GtkWidget     *automatic_suspend_dialog;
   UpClient      *up_client;
-  GPtrArray     *devices;
+  CcPowerDeviceRows *device_rows;
   GDBusProxy    *screen_proxy;
   GDBusProxy    *kbd_proxy;
   gboolean       has_batteries;
@@ -85,10 +95,10 @@ struct _CcPowerPanelPrivate
   GtkWidget     *dim_screen_row;
   GtkWidget     *brightness_row;
   GtkWidget     *brightness_scale;
-  gboolean       setting_brightness;
+  BrightnessSetter screen_brightness;
   GtkWidget     *kbd_brightness_row;
   GtkWidget     *kbd_brightness_scale;
-  gboolean       kbd_setting_brightness;
+  BrightnessSetter kbd_brightness;
 
   GtkWidget     *automatic_suspend_row;
   GtkWidget     *automatic_suspend_label;
@@ -136,13 +146,19 @@ cc_power_panel_dispose (GObject *object)
     }
   g_clear_pointer (&priv->automatic_suspend_dialog, gtk_widget_destroy);
   g_clear_object (&priv->builder);
-  g_clear_object (&priv->screen_proxy);
-  g_clear_object (&priv->kbd_proxy);
-  if (priv->devices)
+  if (priv->screen_brightness.tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (priv->brightness_scale, priv->screen_brightness.tick_id);
+      priv->screen_brightness.tick_id = 0;
+    }
+  if (priv->kbd_brightness.tick_id != 0)
     {
-      g_ptr_array_foreach (priv->devices, (GFunc) g_object_unref, NULL);
-      g_clear_pointer (&priv->devices, g_ptr_array_unref);
+      gtk_widget_remove_tick_callback (priv->kbd_brightness_scale, priv->kbd_brightness.tick_id);
+      priv->kbd_brightness.tick_id = 0;
     }
+  g_clear_object (&priv->screen_proxy);
+  g_clear_object (&priv->kbd_proxy);
+  g_clear_pointer (&priv->device_rows, cc_power_device_rows_free);
   g_clear_object (&priv->up_client);
   g_clear_object (&priv->bt_rfkill);
   g_clear_object (&priv->bt_properties);
@@ -238,711 +254,151 @@ out:
   return ret;
 }
 
-static gchar *
-get_timestring (guint64 time_secs)
-{
-  gchar* timestring = NULL;
-  gint  hours;
-  gint  minutes;
-
-  /* Add 0.5 to do rounding */
-  minutes = (int) ( ( time_secs / 60.0 ) + 0.5 );
-
-  if (minutes == 0)
-    {
-      timestring = g_strdup (_("Unknown time"));
-      return timestring;
-    }
-
-  if (minutes < 60)
-    {
-      timestring = g_strdup_printf (ngettext ("%i minute",
-                                    "%i minutes",
-                                    minutes), minutes);
-      return timestring;
-    }
-
-  hours = minutes / 60;
-  minutes = minutes % 60;
-
-  if (minutes == 0)
-    {
-      timestring = g_strdup_printf (ngettext (
-                                    "%i hour",
-                                    "%i hours",
-                                    hours), hours);
-      return timestring;
-    }
-
-  /* TRANSLATOR: "%i %s %i %s" are "%i hours %i minutes"
-   * Swap order with "%2$s %2$i %1$s %1$i if needed */
-  timestring = g_strdup_printf (_("%i %s %i %s"),
-                                hours, ngettext ("hour", "hours", hours),
-                                minutes, ngettext ("minute", "minutes", minutes));
-  return timestring;
-}
-
-static gchar *
-get_details_string (gdouble percentage, UpDeviceState state, guint64 time)
-{
-  gchar *details;
-
-  if (time > 0)
-    {
-      gchar *time_string;
-
-      time_string = get_timestring (time);
-      switch (state)
-        {
-          case UP_DEVICE_STATE_CHARGING:
-          case UP_DEVICE_STATE_PENDING_CHARGE:
-            /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
-            details = g_strdup_printf (_("%s until fully charged"), time_string);
-            break;
-          case UP_DEVICE_STATE_DISCHARGING:
-          case UP_DEVICE_STATE_PENDING_DISCHARGE:
-            if (percentage < 20)
-              {
-                /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
-                details = g_strdup_printf (_("Caution: %s remaining"), time_string);
-              }
-            else
-              {
-                /* TRANSLATORS: %1 is a time string, e.g. "1 hour 5 minutes" */
-                details = g_strdup_printf (_("%s remaining"), time_string);
-              }
-            break;
-          case UP_DEVICE_STATE_FULLY_CHARGED:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Fully charged"));
-            break;
-          case UP_DEVICE_STATE_EMPTY:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Empty"));
-            break;
-          default:
-            details = g_strdup_printf ("error: %s", up_device_state_to_string (state));
-            break;
-        }
-      g_free (time_string);
-    }
-  else
-    {
-      switch (state)
-        {
-          case UP_DEVICE_STATE_CHARGING:
-          case UP_DEVICE_STATE_PENDING_CHARGE:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Charging"));
-            break;
-          case UP_DEVICE_STATE_DISCHARGING:
-          case UP_DEVICE_STATE_PENDING_DISCHARGE:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Discharging"));
-            break;
-          case UP_DEVICE_STATE_FULLY_CHARGED:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Fully charged"));
-            break;
-          case UP_DEVICE_STATE_EMPTY:
-            /* TRANSLATORS: primary battery */
-            details = g_strdup (_("Empty"));
-            break;
-          default:
-            details = g_strdup_printf ("error: %s",
-                                       up_device_state_to_string (state));
-            break;
-        }
-    }
-
-  return details;
-}
-
 static void
-set_primary (CcPowerPanel *panel, UpDevice *device)
+up_client_device_removed (UpClient     *client,
+                          const char   *object_path,
+                          CcPowerPanel *self)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
-  gchar *details = NULL;
-  gdouble percentage;
-  guint64 time_empty, time_full, time;
-  UpDeviceState state;
-  GtkWidget *box, *box2, *label;
-  GtkWidget *levelbar, *row;
-  gchar *s;
-  gdouble energy_full, energy_rate;
-
-  g_object_get (device,
-                "state", &state,
-                "percentage", &percentage,
-                "time-to-empty", &time_empty,
-                "time-to-full", &time_full,
-                "energy-full", &energy_full,
-                "energy-rate", &energy_rate,
-                NULL);
-  if (state == UP_DEVICE_STATE_DISCHARGING)
-    time = time_empty;
-  else
-    time = time_full;
-
-  /* Sometimes the reported state is fully charged but battery is at 99%,
-     refusing to reach 100%. In these cases, just assume 100%. */
-  if (state == UP_DEVICE_STATE_FULLY_CHARGED && (100.0 - percentage <= 1.0))
-    percentage = 100.0;
-
-  details = get_details_string (percentage, state, time);
-
-  row = no_prelight_row_new ();
-  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
-  gtk_container_add (GTK_CONTAINER (row), box);
-
-  gtk_widget_set_margin_start (box, 20);
-  gtk_widget_set_margin_end (box, 20);
-  gtk_widget_set_margin_top (box, 6);
-  gtk_widget_set_margin_bottom (box, 6);
-
-  levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
-  gtk_widget_set_hexpand (levelbar, TRUE);
-  gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
-  gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
-  gtk_box_pack_start (GTK_BOX (box), levelbar, TRUE, TRUE, 0);
-
-  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 50);
-  gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
-
-  label = gtk_label_new (details);
-  gtk_widget_set_halign (label, GTK_ALIGN_START);
-  gtk_box_pack_start (GTK_BOX (box2), label, TRUE, TRUE, 0);
-
-  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
-  label = gtk_label_new (s);
-  g_free (s);
-  gtk_widget_set_halign (label, GTK_ALIGN_END);
-  gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
-  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
-
-  atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
-                               ATK_RELATION_LABELLED_BY,
-                               gtk_widget_get_accessible (label));
-
-  gtk_container_add (GTK_CONTAINER (priv->battery_list), row);
-  gtk_size_group_add_widget (priv->row_sizegroup, row);
-  gtk_widget_show_all (row);
-
-  g_object_set_data (G_OBJECT (row), "primary", GINT_TO_POINTER (TRUE));
-
-  g_free (details);
-
-  gtk_widget_set_visible (priv->battery_section, TRUE);
+  cc_power_device_rows_remove_device (self->priv->device_rows, object_path);
 }
 
 static void
-add_battery (CcPowerPanel *panel, UpDevice *device)
+up_client_device_added (UpClient     *client,
+                        UpDevice     *device,
+                        CcPowerPanel *self)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
-  gdouble percentage;
-  UpDeviceKind kind;
-  UpDeviceState state;
-  GtkWidget *row;
-  GtkWidget *box;
-  GtkWidget *box2;
-  GtkWidget *label;
-  GtkWidget *levelbar;
-  GtkWidget *widget;
-  gchar *s;
-  gchar *icon_name;
-  const gchar *name;
-
-  g_object_get (device,
-                "kind", &kind,
-                "state", &state,
-                "percentage", &percentage,
-                "icon-name", &icon_name,
-                NULL);
-
-  if (g_object_get_data (G_OBJECT (device), "is-main-battery") != NULL)
-    name = C_("Battery name", "Main");
-  else
-    name = C_("Battery name", "Extra");
-
-  row = no_prelight_row_new ();
-  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-  gtk_container_add (GTK_CONTAINER (row), box);
-
-  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-  label = gtk_label_new (name);
-  gtk_widget_set_halign (label, GTK_ALIGN_START);
-  gtk_size_group_add_widget (priv->battery_sizegroup, box2);
-  gtk_widget_set_margin_start (label, 20);
-  gtk_widget_set_margin_end (label, 20);
-  gtk_widget_set_margin_top (label, 6);
-  gtk_widget_set_margin_bottom (label, 6);
-  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
-  gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
-
-#if 1
-  if (icon_name != NULL && *icon_name != '\0')
-    {
-      widget = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_BUTTON);
-      gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
-      gtk_widget_set_halign (widget, GTK_ALIGN_END);
-      gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-      gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
-    }
-#endif
-
-  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
-  gtk_widget_set_margin_start (box2, 20);
-  gtk_widget_set_margin_end (box2, 20);
-
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  label = gtk_label_new (s);
-  g_free (s);
-  gtk_widget_set_halign (label, GTK_ALIGN_END);
-  gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
-  gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
-  gtk_size_group_add_widget (priv->charge_sizegroup, label);
-
-  levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
-  gtk_widget_set_hexpand (levelbar, TRUE);
-  gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
-  gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
-  gtk_box_pack_start (GTK_BOX (box2), levelbar, TRUE, TRUE, 0);
-  gtk_size_group_add_widget (priv->level_sizegroup, levelbar);
-  gtk_box_pack_start (GTK_BOX (box), box2, TRUE, TRUE, 0);
-
-  atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
-                               ATK_RELATION_LABELLED_BY,
-                               gtk_widget_get_accessible (label));
-
-
-  g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
-  gtk_container_add (GTK_CONTAINER (priv->battery_list), row);
-  gtk_size_group_add_widget (priv->row_sizegroup, row);
-  gtk_widget_show_all (row);
-
-  g_free (icon_name);
-
-  gtk_widget_set_visible (priv->battery_section, TRUE);
+  cc_power_device_rows_add_device (self->priv->device_rows, device);
 }
 
-static const char *
-kind_to_description (UpDeviceKind kind)
-{
-  switch (kind)
-    {
-      case UP_DEVICE_KIND_MOUSE:
-        /* TRANSLATORS: secondary battery */
-        return N_("Wireless mouse");
-      case UP_DEVICE_KIND_KEYBOARD:
-        /* TRANSLATORS: secondary battery */
-        return N_("Wireless keyboard");
-      case UP_DEVICE_KIND_UPS:
-        /* TRANSLATORS: secondary battery */
-        return N_("Uninterruptible power supply");
-      case UP_DEVICE_KIND_PDA:
-        /* TRANSLATORS: secondary battery */
-        return N_("Personal digital assistant");
-      case UP_DEVICE_KIND_PHONE:
-        /* TRANSLATORS: secondary battery */
-        return N_("Cellphone");
-      case UP_DEVICE_KIND_MEDIA_PLAYER:
-        /* TRANSLATORS: secondary battery */
-        return N_("Media player");
-      case UP_DEVICE_KIND_TABLET:
-        /* TRANSLATORS: secondary battery */
-        return N_("Tablet");
-      case UP_DEVICE_KIND_COMPUTER:
-        /* TRANSLATORS: secondary battery */
-        return N_("Computer");
-      default:
-        /* TRANSLATORS: secondary battery, misc */
-        return N_("Battery");
-    }
-
-  g_assert_not_reached ();
-}
+static void brightness_setter_queue (CcPowerPanel     *self,
+                                     BrightnessSetter *setter);
 
-static void
-add_device (CcPowerPanel *panel, UpDevice *device)
+static BrightnessSetter *
+get_brightness_setter (CcPowerPanel *self,
+                       gpointer      proxy_or_scale)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
-  UpDeviceKind kind;
-  UpDeviceState state;
-  GtkWidget *row;
-  GtkWidget *hbox;
-  GtkWidget *box2;
-  GtkWidget *widget;
-  GString *status;
-  GString *description;
-  gdouble percentage;
-  gchar *name;
-  gchar *s;
-  gboolean show_caution = FALSE;
-  gboolean is_present;
-
-  name = NULL;
-  g_object_get (device,
-                "kind", &kind,
-                "percentage", &percentage,
-                "state", &state,
-                "model", &name,
-                "is-present", &is_present,
-                NULL);
-
-  if (!is_present)
-    {
-      g_free (name);
-      return;
-    }
-
-  if (kind == UP_DEVICE_KIND_UPS)
-    show_caution = TRUE;
-
-  if (name == NULL || *name == '\0')
-    description = g_string_new (_(kind_to_description (kind)));
-  else
-    description = g_string_new (name);
-
-  g_free (name);
-
-  switch (state)
-    {
-      case UP_DEVICE_STATE_CHARGING:
-      case UP_DEVICE_STATE_PENDING_CHARGE:
-        /* TRANSLATORS: secondary battery */
-        status = g_string_new(C_("Battery power", "Charging"));
-        break;
-      case UP_DEVICE_STATE_DISCHARGING:
-      case UP_DEVICE_STATE_PENDING_DISCHARGE:
-        if (percentage < 10 && show_caution)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Caution"));
-          }
-        else if (percentage < 30)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Low"));
-          }
-        else
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Good"));
-          }
-        break;
-      case UP_DEVICE_STATE_FULLY_CHARGED:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Fully charged"));
-        break;
-      case UP_DEVICE_STATE_EMPTY:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Empty"));
-        break;
-      default:
-        status = g_string_new (up_device_state_to_string (state));
-        break;
-    }
-  g_string_prepend (status, "<small>");
-  g_string_append (status, "</small>");
-
-  /* create the new widget */
-  row = no_prelight_row_new ();
-  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-  gtk_container_add (GTK_CONTAINER (row), hbox);
-  widget = gtk_label_new ("");
-  gtk_widget_set_halign (widget, GTK_ALIGN_START);
-  gtk_label_set_markup (GTK_LABEL (widget), description->str);
-  gtk_widget_set_margin_start (widget, 20);
-  gtk_widget_set_margin_end (widget, 20);
-  gtk_widget_set_margin_top (widget, 6);
-  gtk_widget_set_margin_bottom (widget, 6);
-  gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, TRUE, 0);
-  gtk_size_group_add_widget (priv->battery_sizegroup, widget);
-
-  box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
-  gtk_widget_set_margin_start (box2, 20);
-  gtk_widget_set_margin_end (box2, 20);
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  widget = gtk_label_new (s);
-  g_free (s);
-  gtk_widget_set_halign (widget, GTK_ALIGN_END);
-  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
-  gtk_box_pack_start (GTK_BOX (box2), widget, FALSE, TRUE, 0);
-  gtk_size_group_add_widget (priv->charge_sizegroup, widget);
-
-  widget = gtk_level_bar_new ();
-  gtk_widget_set_halign (widget, TRUE);
-  gtk_widget_set_halign (widget, GTK_ALIGN_FILL);
-  gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0f);
-  gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
-  gtk_size_group_add_widget (priv->level_sizegroup, widget);
-  gtk_box_pack_start (GTK_BOX (hbox), box2, TRUE, TRUE, 0);
-  gtk_widget_show_all (row);
-
-  gtk_container_add (GTK_CONTAINER (priv->device_list), row);
-  gtk_size_group_add_widget (priv->row_sizegroup, row);
-  g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
-
-  g_string_free (description, TRUE);
-  g_string_free (status, TRUE);
+  CcPowerPanelPrivate *priv = self->priv;
 
-  gtk_widget_set_visible (priv->device_section, TRUE);
+  if (proxy_or_scale == priv->screen_proxy ||
+      proxy_or_scale == priv->brightness_scale)
+    return &priv->screen_brightness;
+  return &priv->kbd_brightness;
 }
 
 static void
-up_client_changed (UpClient     *client,
-                   UpDevice     *device,
-                   CcPowerPanel *self)
+set_brightness_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
-  CcPowerPanelPrivate *priv = self->priv;
-  GList *children, *l;
-  gint i;
-  UpDeviceKind kind;
-  guint n_batteries;
-  gboolean on_ups;
-  UpDevice *composite;
-  gchar *s;
-
-  children = gtk_container_get_children (GTK_CONTAINER (priv->battery_list));
-  for (l = children; l != NULL; l = l->next)
-    gtk_container_remove (GTK_CONTAINER (priv->battery_list), l->data);
-  g_list_free (children);
-  gtk_widget_hide (priv->battery_section);
-
-  children = gtk_container_get_children (GTK_CONTAINER (priv->device_list));
-  for (l = children; l != NULL; l = l->next)
-    gtk_container_remove (GTK_CONTAINER (priv->device_list), l->data);
-  g_list_free (children);
-  gtk_widget_hide (priv->device_section);
-
-#ifdef TEST_FAKE_DEVICES
-  {
-    static gboolean fake_devices_added = FALSE;
-
-    if (!fake_devices_added)
-      {
-        fake_devices_added = TRUE;
-        g_print ("adding fake devices\n");
-        device = up_device_new ();
-        g_object_set (device,
-                      "kind", UP_DEVICE_KIND_MOUSE,
-                      "native-path", "dummy:native-path1",
-                      "model", "My mouse",
-                      "percentage", 71.0,
-                      "state", UP_DEVICE_STATE_DISCHARGING,
-                      "time-to-empty", 287,
-                      "icon-name", "battery-full-symbolic",
-                      NULL);
-        g_ptr_array_add (priv->devices, device);
-        device = up_device_new ();
-        g_object_set (device,
-                      "kind", UP_DEVICE_KIND_KEYBOARD,
-                      "native-path", "dummy:native-path2",
-                      "model", "My keyboard",
-                      "percentage", 59.0,
-                      "state", UP_DEVICE_STATE_DISCHARGING,
-                      "time-to-empty", 250,
-                      "icon-name", "battery-good-symbolic",
-                      NULL);
-        g_ptr_array_add (priv->devices, device);
-        device = up_device_new ();
-        g_object_set (device,
-                      "kind", UP_DEVICE_KIND_BATTERY,
-                      "native-path", "dummy:native-path3",
-                      "model", "Battery from some factory",
-                      "percentage", 100.0,
-                      "state", UP_DEVICE_STATE_FULLY_CHARGED,
-                      "energy", 55.0,
-                      "energy-full", 55.0,
-                      "energy-rate", 15.0,
-                      "time-to-empty", 400,
-                      "icon-name", "battery-full-charged-symbolic",
-                      NULL);
-        g_ptr_array_add (priv->devices, device);
-      }
-  }
-#endif
+  GError *error = NULL;
+  GVariant *result;
+  CcPowerPanel *self = CC_POWER_PANEL (user_data);
+  GDBusProxy *proxy = G_DBUS_PROXY (source_object);
+  BrightnessSetter *setter;
 
-  on_ups = FALSE;
-  n_batteries = 0;
-  composite = up_client_get_display_device (priv->up_client);
-  g_object_get (composite, "kind", &kind, NULL);
-  if (kind == UP_DEVICE_KIND_UPS)
+  result = g_dbus_proxy_call_finish (proxy, res, &error);
+  if (result == NULL)
     {
-      on_ups = TRUE;
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error setting brightness: %s\n", error->message);
+      g_error_free (error);
     }
   else
     {
-      gboolean is_extra_battery = FALSE;
-
-      /* Count the batteries */
-      for (i = 0; priv->devices != NULL && i < priv->devices->len; i++)
-        {
-          UpDevice *device = (UpDevice*) g_ptr_array_index (priv->devices, i);
-          g_object_get (device, "kind", &kind, NULL);
-          if (kind == UP_DEVICE_KIND_BATTERY)
-            {
-              n_batteries++;
-              if (is_extra_battery == FALSE)
-                {
-                  is_extra_battery = TRUE;
-                  g_object_set_data (G_OBJECT (device), "is-main-battery", GINT_TO_POINTER(TRUE));
-                }
-            }
-        }
+      g_variant_unref (result);
     }
 
-  if (n_batteries > 1)
-    s = g_strdup_printf ("<b>%s</b>", _("Batteries"));
-  else
-    s = g_strdup_printf ("<b>%s</b>", _("Battery"));
-  gtk_label_set_label (GTK_LABEL (priv->battery_heading), s);
-  g_free (s);
-
-  if (!on_ups && n_batteries > 1)
-    set_primary (self, composite);
+  /* the panel has been disposed */
+  if (self->priv->cancellable == NULL)
+    goto out;
 
-  for (i = 0; priv->devices != NULL && i < priv->devices->len; i++)
-    {
-      UpDevice *device = (UpDevice*) g_ptr_array_index (priv->devices, i);
-      g_object_get (device, "kind", &kind, NULL);
-      if (kind == UP_DEVICE_KIND_LINE_POWER)
-        {
-          /* do nothing */
-        }
-      else if (kind == UP_DEVICE_KIND_UPS && on_ups)
-        {
-          set_primary (self, device);
-        }
-      else if (kind == UP_DEVICE_KIND_BATTERY && !on_ups && n_batteries == 1)
-        {
-          set_primary (self, device);
-        }
-      else if (kind == UP_DEVICE_KIND_BATTERY)
-        {
-          add_battery (self, device);
-        }
-      else
-        {
-          add_device (self, device);
-        }
-    }
+  setter = get_brightness_setter (self, proxy);
+  setter->in_flight = FALSE;
+  g_debug ("%s brightness set in %" G_GINT64_FORMAT " ms",
+           setter->interface,
+           (g_get_monotonic_time () - setter->sent_time) / 1000);
 
-  g_object_unref (composite);
+  /* the slider moved in the meantime */
+  if (setter->pending >= 0)
+    brightness_setter_queue (self, setter);
+out:
+  g_object_unref (self);
 }
 
 static void
-up_client_device_removed (UpClient     *client,
-                          const char   *object_path,
-                          CcPowerPanel *self)
+brightness_setter_send (CcPowerPanel     *self,
+                        BrightnessSetter *setter)
 {
-  CcPowerPanelPrivate *priv = self->priv;
-  guint i;
+  GVariant *variant;
 
-  if (priv->devices == NULL)
+  if (setter->in_flight || setter->pending < 0 || *setter->proxy == NULL)
     return;
 
-  for (i = 0; i < priv->devices->len; i++)
-    {
-      UpDevice *device = g_ptr_array_index (priv->devices, i);
-
-      if (g_strcmp0 (object_path, up_device_get_object_path (device)) == 0)
-        {
-          g_object_unref (device);
-          g_ptr_array_remove_index (priv->devices, i);
-          break;
-        }
-    }
+  variant = g_variant_new_parsed ("(%s, 'Brightness', %v)",
+                                  setter->interface,
+                                  g_variant_new_int32 (setter->pending));
+  setter->pending = -1;
+  setter->in_flight = TRUE;
+  setter->sent_time = g_get_monotonic_time ();
 
-  up_client_changed (self->priv->up_client, NULL, self);
+  /* push this to g-s-d */
+  g_dbus_proxy_call (*setter->proxy,
+                     "org.freedesktop.DBus.Properties.Set",
+                     variant,
+                     G_DBUS_CALL_FLAGS_NONE,
+                     -1,
+                     self->priv->cancellable,
+                     set_brightness_cb,
+                     g_object_ref (self));
 }
 
-static void
-up_client_device_added (UpClient     *client,
-                        UpDevice     *device,
-                        CcPowerPanel *self)
+static gboolean
+brightness_setter_tick_cb (GtkWidget     *widget,
+                           GdkFrameClock *frame_clock,
+                           gpointer       user_data)
 {
-  CcPowerPanelPrivate *priv = self->priv;
+  CcPowerPanel *self = CC_POWER_PANEL (user_data);
+  BrightnessSetter *setter;
 
-  g_ptr_array_add (priv->devices, g_object_ref (device));
-  g_signal_connect (G_OBJECT (device), "notify",
-                    G_CALLBACK (up_client_changed), self);
-  up_client_changed (priv->up_client, NULL, self);
+  setter = get_brightness_setter (self, widget);
+  setter->tick_id = 0;
+  brightness_setter_send (self, setter);
+
+  return G_SOURCE_REMOVE;
 }
 
+/* Sends the pending value at the next frame, unless a call is still
+ * in flight, in which case its reply does that */
 static void
-set_brightness_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+brightness_setter_queue (CcPowerPanel     *self,
+                         BrightnessSetter *setter)
 {
-  GError *error = NULL;
-  GVariant *result;
-  CcPowerPanelPrivate *priv = CC_POWER_PANEL (user_data)->priv;
-  GDBusProxy *proxy = G_DBUS_PROXY (source_object);
+  if (setter->in_flight || setter->tick_id != 0)
+    return;
 
-  /* not setting, so pay attention to changed signals */
-  if (proxy == priv->screen_proxy)
-    priv->setting_brightness = FALSE;
-  else if (proxy == priv->kbd_proxy)
-    priv->kbd_setting_brightness = FALSE;
+  setter->tick_id = gtk_widget_add_tick_callback (*setter->scale,
+                                                  brightness_setter_tick_cb,
+                                                  self, NULL);
+}
 
-  result = g_dbus_proxy_call_finish (proxy, res, &error);
-  if (result == NULL)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_printerr ("Error setting brightness: %s\n", error->message);
-      g_error_free (error);
-      return;
-    }
+static gboolean
+brightness_setter_is_busy (BrightnessSetter *setter)
+{
+  return setter->in_flight || setter->pending >= 0;
 }
 
 static void
 brightness_slider_value_changed_cb (GtkRange *range, gpointer user_data)
 {
-  guint percentage;
-  CcPowerPanelPrivate *priv = CC_POWER_PANEL (user_data)->priv;
-  GVariant *variant;
-  GDBusProxy *proxy;
-
-  percentage = (guint) gtk_range_get_value (range);
-
-  if (range == GTK_RANGE (priv->brightness_scale))
-    {
-      /* do not loop */
-      if (priv->setting_brightness)
-        return;
-
-      priv->setting_brightness = TRUE;
-      proxy = priv->screen_proxy;
-
-      variant = g_variant_new_parsed ("('org.gnome.SettingsDaemon.Power.Screen',"
-                                      "'Brightness', %v)",
-                                      g_variant_new_int32 (percentage));
-    }
-  else
-    {
-      /* do not loop */
-      if (priv->kbd_setting_brightness)
-        return;
+  CcPowerPanel *self = CC_POWER_PANEL (user_data);
+  BrightnessSetter *setter;
 
-      priv->kbd_setting_brightness = TRUE;
-      proxy = priv->kbd_proxy;
+  setter = get_brightness_setter (self, range);
 
-      variant = g_variant_new_parsed ("('org.gnome.SettingsDaemon.Power.Keyboard',"
-                                      "'Brightness', %v)",
-                                      g_variant_new_int32 (percentage));
-    }
+  /* do not loop */
+  if (setter->syncing)
+    return;
 
-  /* push this to g-s-d */
-  g_dbus_proxy_call (proxy,
-                     "org.freedesktop.DBus.Properties.Set",
-                     variant,
-                     G_DBUS_CALL_FLAGS_NONE,
-                     -1,
-                     priv->cancellable,
-                     set_brightness_cb,
-                     user_data);
+  setter->pending = (gint) gtk_range_get_value (range);
+  brightness_setter_queue (self, setter);
 }
 
 static void
@@ -972,9 +428,13 @@ sync_kbd_brightness (CcPowerPanel *self)
       range = GTK_RANGE (self->priv->kbd_brightness_scale);
       gtk_range_set_range (range, 0, 100);
       gtk_range_set_increments (range, 1, 10);
-      self->priv->kbd_setting_brightness = TRUE;
-      gtk_range_set_value (range, brightness);
-      self->priv->kbd_setting_brightness = FALSE;
+      /* don't move the slider back to values we are replacing */
+      if (!brightness_setter_is_busy (&self->priv->kbd_brightness))
+        {
+          self->priv->kbd_brightness.syncing = TRUE;
+          gtk_range_set_value (range, brightness);
+          self->priv->kbd_brightness.syncing = FALSE;
+        }
       g_variant_unref (result);
     }
 }
@@ -1008,9 +468,13 @@ sync_screen_brightness (CcPowerPanel *self)
       range = GTK_RANGE (self->priv->brightness_scale);
       gtk_range_set_range (range, 0, 100);
       gtk_range_set_increments (range, 1, 10);
-      self->priv->setting_brightness = TRUE;
-      gtk_range_set_value (range, brightness);
-      self->priv->setting_brightness = FALSE;
+      /* don't move the slider back to values we are replacing */
+      if (!brightness_setter_is_busy (&self->priv->screen_brightness))
+        {
+          self->priv->screen_brightness.syncing = TRUE;
+          gtk_range_set_value (range, brightness);
+          self->priv->screen_brightness.syncing = FALSE;
+        }
       g_variant_unref (result);
     }
 }
@@ -2478,6 +1942,8 @@ cc_power_panel_init (CcPowerPanel *self)
   GError     *error;
   GtkWidget  *widget;
   GtkWidget  *box;
+  GPtrArray  *devices;
+  UpDevice   *composite;
   guint       i;
 
   priv = self->priv = POWER_PANEL_PRIVATE (self);
@@ -2501,6 +1967,15 @@ cc_power_panel_init (CcPowerPanel *self)
 
   priv->cancellable = g_cancellable_new ();
 
+  priv->screen_brightness.interface = "org.gnome.SettingsDaemon.Power.Screen";
+  priv->screen_brightness.proxy = &priv->screen_proxy;
+  priv->screen_brightness.scale = &priv->brightness_scale;
+  priv->screen_brightness.pending = -1;
+  priv->kbd_brightness.interface = "org.gnome.SettingsDaemon.Power.Keyboard";
+  priv->kbd_brightness.proxy = &priv->kbd_proxy;
+  priv->kbd_brightness.scale = &priv->kbd_brightness_scale;
+  priv->kbd_brightness.pending = -1;
+
   g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
                             G_DBUS_PROXY_FLAGS_NONE,
                             NULL,
@@ -2541,16 +2016,26 @@ cc_power_panel_init (CcPowerPanel *self)
   priv->boxes = g_list_reverse (priv->boxes);
 
   /* populate batteries */
+  priv->device_rows = cc_power_device_rows_new (priv->battery_heading,
+                                                priv->battery_section,
+                                                priv->battery_list,
+                                                priv->device_section,
+                                                priv->device_list,
+                                                priv->row_sizegroup,
+                                                priv->battery_sizegroup,
+                                                priv->charge_sizegroup,
+                                                priv->level_sizegroup);
   g_signal_connect (priv->up_client, "device-added", G_CALLBACK (up_client_device_added), self);
   g_signal_connect (priv->up_client, "device-removed", G_CALLBACK (up_client_device_removed), self);
 
-  priv->devices = up_client_get_devices (priv->up_client);
-  for (i = 0; priv->devices != NULL && i < priv->devices->len; i++) {
-    UpDevice *device = g_ptr_array_index (priv->devices, i);
-    g_signal_connect (G_OBJECT (device), "notify",
-                      G_CALLBACK (up_client_changed), self);
-  }
-  up_client_changed (priv->up_client, NULL, self);
+  devices = up_client_get_devices (priv->up_client);
+  for (i = 0; devices != NULL && i < devices->len; i++)
+    cc_power_device_rows_add_device (priv->device_rows, g_ptr_array_index (devices, i));
+  g_clear_pointer (&devices, g_ptr_array_unref);
+  composite = up_client_get_display_device (priv->up_client);
+  cc_power_device_rows_set_composite (priv->device_rows, composite);
+  g_clear_object (&composite);
+  cc_power_device_rows_update (priv->device_rows);
 
   widget = WID (priv->builder, "vbox_power");
   box = gtk_scrolled_window_new (NULL, NULL);
@@ -0,0 +1,286 @@
+#include "config.h"
+
+#include <gtk/gtk.h>
+#include <libupower-glib/upower.h>
+
+#include "cc-power-device-rows.h"
+
+#define N_DEVICES 300
+
+typedef struct
+{
+  GtkWidget         *window;
+  GtkWidget         *battery_list;
+  GtkWidget         *device_list;
+  GtkSizeGroup      *sizegroups[4];
+  CcPowerDeviceRows *rows;
+  UpDevice          *composite;
+  GPtrArray         *devices;
+  GPtrArray         *device_rows;
+} Fixture;
+
+static UpDevice *
+fake_device_new (UpDeviceKind kind,
+                 guint        n)
+{
+  UpDevice *device;
+  gchar *native_path;
+  gchar *model;
+
+  native_path = g_strdup_printf ("dummy:native-path%u", n);
+  model = g_strdup_printf ("Fake device %u", n);
+  device = up_device_new ();
+  g_object_set (device,
+                "kind", kind,
+                "native-path", native_path,
+                "model", model,
+                "is-present", TRUE,
+                "percentage", g_test_rand_double_range (0.0, 100.0),
+                "state", UP_DEVICE_STATE_DISCHARGING,
+                "time-to-empty", (gint64) 287,
+                "icon-name", "battery-good-symbolic",
+                NULL);
+  g_free (native_path);
+  g_free (model);
+
+  return device;
+}
+
+static void
+fixture_setup (Fixture       *f,
+               gconstpointer  data)
+{
+  const UpDeviceKind kinds[] = {
+    UP_DEVICE_KIND_MOUSE,
+    UP_DEVICE_KIND_KEYBOARD,
+    UP_DEVICE_KIND_PHONE,
+    UP_DEVICE_KIND_MEDIA_PLAYER,
+    UP_DEVICE_KIND_TABLET,
+    UP_DEVICE_KIND_BATTERY
+  };
+  GtkWidget *box;
+  GtkWidget *battery_heading;
+  GtkWidget *battery_section;
+  GtkWidget *device_section;
+  guint i;
+
+  f->window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_container_add (GTK_CONTAINER (f->window), box);
+
+  battery_section = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  battery_heading = gtk_label_new (NULL);
+  f->battery_list = gtk_list_box_new ();
+  gtk_container_add (GTK_CONTAINER (battery_section), battery_heading);
+  gtk_container_add (GTK_CONTAINER (battery_section), f->battery_list);
+  gtk_container_add (GTK_CONTAINER (box), battery_section);
+
+  device_section = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  f->device_list = gtk_list_box_new ();
+  gtk_container_add (GTK_CONTAINER (device_section), f->device_list);
+  gtk_container_add (GTK_CONTAINER (box), device_section);
+
+  f->sizegroups[0] = gtk_size_group_new (GTK_SIZE_GROUP_VERTICAL);
+  for (i = 1; i < G_N_ELEMENTS (f->sizegroups); i++)
+    f->sizegroups[i] = gtk_size_group_new (GTK_SIZE_GROUP_HORIZONTAL);
+
+  f->rows = cc_power_device_rows_new (battery_heading,
+                                      battery_section,
+                                      f->battery_list,
+                                      device_section,
+                                      f->device_list,
+                                      f->sizegroups[0],
+                                      f->sizegroups[1],
+                                      f->sizegroups[2],
+                                      f->sizegroups[3]);
+
+  f->composite = fake_device_new (UP_DEVICE_KIND_BATTERY, 0);
+  cc_power_device_rows_set_composite (f->rows, f->composite);
+
+  f->devices = g_ptr_array_new_with_free_func (g_object_unref);
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      UpDevice *device;
+
+      device = fake_device_new (kinds[i % G_N_ELEMENTS (kinds)], i + 1);
+      cc_power_device_rows_add_device (f->rows, device);
+      g_ptr_array_add (f->devices, device);
+    }
+
+  cc_power_device_rows_update (f->rows);
+
+  f->device_rows = g_ptr_array_new ();
+  for (i = 0; i < f->devices->len; i++)
+    g_ptr_array_add (f->device_rows,
+                     cc_power_device_rows_get_row (f->rows, g_ptr_array_index (f->devices, i)));
+
+  gtk_widget_show_all (f->window);
+}
+
+static void
+fixture_teardown (Fixture       *f,
+                  gconstpointer  data)
+{
+  guint i;
+
+  cc_power_device_rows_free (f->rows);
+  gtk_widget_destroy (f->window);
+  for (i = 0; i < G_N_ELEMENTS (f->sizegroups); i++)
+    g_object_unref (f->sizegroups[i]);
+  g_object_unref (f->composite);
+  g_ptr_array_unref (f->devices);
+  g_ptr_array_unref (f->device_rows);
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  gboolean *timed_out = user_data;
+
+  *timed_out = TRUE;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs frames until the rows were synced, or for @ms when @ms is set */
+static void
+run_frames (Fixture *f,
+            guint    ms)
+{
+  const CcPowerDeviceRowsStats *stats;
+  gboolean timed_out = FALSE;
+  guint n_syncs;
+  guint id;
+
+  stats = cc_power_device_rows_get_stats (f->rows);
+  n_syncs = stats->n_syncs;
+  id = g_timeout_add (ms > 0 ? ms : 5000, timeout_cb, &timed_out);
+  while (!timed_out && (ms > 0 || stats->n_syncs == n_syncs))
+    g_main_context_iteration (NULL, TRUE);
+  if (!timed_out)
+    g_source_remove (id);
+
+  g_assert (ms > 0 || !timed_out);
+}
+
+static void
+check_rows_reused (Fixture *f)
+{
+  guint i;
+
+  for (i = 0; i < f->devices->len; i++)
+    g_assert (cc_power_device_rows_get_row (f->rows, g_ptr_array_index (f->devices, i)) ==
+              g_ptr_array_index (f->device_rows, i));
+}
+
+static void
+test_initial (Fixture       *f,
+              gconstpointer  data)
+{
+  const CcPowerDeviceRowsStats *stats;
+  guint i;
+
+  stats = cc_power_device_rows_get_stats (f->rows);
+  g_assert_cmpuint (stats->n_syncs, ==, 1);
+  /* every device, plus the overall level of the batteries */
+  g_assert_cmpuint (stats->n_created, ==, N_DEVICES + 1);
+  g_assert_cmpuint (stats->n_updated, ==, N_DEVICES + 1);
+
+  g_assert (cc_power_device_rows_get_row (f->rows, f->composite) != NULL);
+  for (i = 0; i < f->device_rows->len; i++)
+    g_assert (g_ptr_array_index (f->device_rows, i) != NULL);
+
+  /* nothing changed, so there is nothing to do at the next frames */
+  run_frames (f, 100);
+  g_assert_cmpuint (stats->n_syncs, ==, 1);
+}
+
+static void
+test_once_per_frame (Fixture       *f,
+                     gconstpointer  data)
+{
+  const CcPowerDeviceRowsStats *stats;
+  CcPowerDeviceRowsStats before;
+  guint n_changed;
+  guint i, j;
+
+  stats = cc_power_device_rows_get_stats (f->rows);
+  before = *stats;
+
+  /* several notifies per device, for a good part of the devices */
+  n_changed = 0;
+  for (i = 0; i < f->devices->len; i += 3)
+    {
+      UpDevice *device = g_ptr_array_index (f->devices, i);
+
+      for (j = 0; j < 4; j++)
+        g_object_set (device,
+                      "percentage", g_test_rand_double_range (0.0, 100.0),
+                      "time-to-empty", (gint64) g_test_rand_int_range (60, 36000),
+                      NULL);
+      n_changed++;
+    }
+  g_assert_cmpuint (stats->n_syncs, ==, before.n_syncs);
+
+  run_frames (f, 0);
+  g_assert_cmpuint (stats->n_syncs, ==, before.n_syncs + 1);
+  g_assert_cmpuint (stats->n_updated, ==, before.n_updated + n_changed);
+  g_assert_cmpuint (stats->n_created, ==, before.n_created);
+  check_rows_reused (f);
+
+  /* the rows show the last values */
+  for (i = 0; i < f->devices->len; i += 3)
+    {
+      UpDevice *device = g_ptr_array_index (f->devices, i);
+      GtkWidget *row = g_ptr_array_index (f->device_rows, i);
+      gdouble percentage;
+      gchar *s;
+
+      g_object_get (device, "percentage", &percentage, NULL);
+      s = g_strdup_printf ("%d%%", (int) percentage);
+      g_assert_cmpstr (gtk_label_get_label (g_object_get_data (G_OBJECT (row), "level")), ==, s);
+      g_free (s);
+    }
+
+  run_frames (f, 100);
+  g_assert_cmpuint (stats->n_syncs, ==, before.n_syncs + 1);
+}
+
+static void
+test_add_device (Fixture       *f,
+                 gconstpointer  data)
+{
+  const CcPowerDeviceRowsStats *stats;
+  CcPowerDeviceRowsStats before;
+  UpDevice *device;
+
+  stats = cc_power_device_rows_get_stats (f->rows);
+  before = *stats;
+
+  device = fake_device_new (UP_DEVICE_KIND_MOUSE, N_DEVICES + 1);
+  cc_power_device_rows_add_device (f->rows, device);
+
+  run_frames (f, 0);
+  g_assert_cmpuint (stats->n_syncs, ==, before.n_syncs + 1);
+  g_assert_cmpuint (stats->n_created, ==, before.n_created + 1);
+  g_assert_cmpuint (stats->n_updated, ==, before.n_updated + 1);
+  g_assert (gtk_widget_get_parent (cc_power_device_rows_get_row (f->rows, device)) == f->device_list);
+  check_rows_reused (f);
+
+  g_object_unref (device);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/power/device-rows/initial", Fixture, NULL,
+              fixture_setup, test_initial, fixture_teardown);
+  g_test_add ("/power/device-rows/once-per-frame", Fixture, NULL,
+              fixture_setup, test_once_per_frame, fixture_teardown);
+  g_test_add ("/power/device-rows/add-device", Fixture, NULL,
+              fixture_setup, test_add_device, fixture_teardown);
+
+  return g_test_run ();
+}
@@ -61,6 +61,10 @@ CC_PANEL_REGISTER (CcPrintersPanel, cc_printers_panel)
 
 #define CUPS_STATUS_CHECK_INTERVAL 5
 
+/* Notifications arriving within this many milliseconds of each other
+ * are handled by a single update of the printers list */
+#define PRINTERS_LIST_UPDATE_DELAY 250
+
 #if (CUPS_VERSION_MAJOR > 1) || (CUPS_VERSION_MINOR > 5)
 #define HAVE_CUPS_1_6 1
 #endif
@@ -77,7 +81,7 @@ struct _CcPrintersPanelPrivate
 
   cups_dest_t *dests;
   gchar **dest_model_names;
-  gchar **ppd_file_names;
+  PPDFile **ppd_files;
   int num_dests;
   int current_dest;
 
@@ -99,6 +103,13 @@ struct _CcPrintersPanelPrivate
   guint            cups_status_check_id;
   guint            dbus_subscription_id;
 
+  guint            printers_list_update_id;
+  gboolean         printers_list_changed;
+  GHashTable      *changed_printers;
+  guint            num_pending_notifications;
+  guint            num_coalesced_notifications;
+  GCancellable    *printers_update_cancellable;
+
   GtkWidget    *headerbar_buttons;
   GtkWidget    *popup_menu;
   GList        *driver_change_list;
@@ -131,11 +142,15 @@ typedef struct
 
 static void update_jobs_count (CcPrintersPanel *self);
 static void actualize_printers_list (CcPrintersPanel *self);
+static void queue_printers_list_update (CcPrintersPanel *self,
+                                        const gchar     *printer_name,
+                                        gboolean         list_changed);
 static void update_sensitivity (gpointer user_data);
 static void printer_disable_cb (GObject *gobject, GParamSpec *pspec, gpointer user_data);
 static void printer_set_default_cb (GtkToggleButton *button, gpointer user_data);
 static void detach_from_cups_notifier (gpointer data);
 static void free_dests (CcPrintersPanel *self);
+static void printer_get_ppd_file_cb (PPDFile *ppd_file, gpointer user_data);
 
 static void
 cc_printers_panel_get_property (GObject    *object,
@@ -220,6 +235,20 @@ cc_printers_panel_dispose (GObject *object)
 
   detach_from_cups_notifier (CC_PRINTERS_PANEL (object));
 
+  if (priv->printers_list_update_id > 0)
+    {
+      g_source_remove (priv->printers_list_update_id);
+      priv->printers_list_update_id = 0;
+    }
+
+  if (priv->printers_update_cancellable)
+    {
+      g_cancellable_cancel (priv->printers_update_cancellable);
+      g_clear_object (&priv->printers_update_cancellable);
+    }
+
+  g_clear_pointer (&priv->changed_printers, g_hash_table_unref);
+
   if (priv->cups_status_check_id > 0)
     {
       g_source_remove (priv->cups_status_check_id);
@@ -409,10 +438,11 @@ on_cups_notification (GDBusConnection *connection,
     }
 
   if (g_strcmp0 (signal_name, "PrinterAdded") == 0 ||
-      g_strcmp0 (signal_name, "PrinterDeleted") == 0 ||
-      g_strcmp0 (signal_name, "PrinterStateChanged") == 0 ||
-      g_strcmp0 (signal_name, "PrinterStopped") == 0)
-    actualize_printers_list (self);
+      g_strcmp0 (signal_name, "PrinterDeleted") == 0)
+    queue_printers_list_update (self, printer_name, TRUE);
+  else if (g_strcmp0 (signal_name, "PrinterStateChanged") == 0 ||
+           g_strcmp0 (signal_name, "PrinterStopped") == 0)
+    queue_printers_list_update (self, printer_name, FALSE);
   else if (g_strcmp0 (signal_name, "JobCreated") == 0 ||
            g_strcmp0 (signal_name, "JobCompleted") == 0)
     {
@@ -608,20 +638,17 @@ free_dests (CcPrintersPanel *self)
       for (i = 0; i < priv->num_dests; i++)
         {
           g_free (priv->dest_model_names[i]);
-          if (priv->ppd_file_names[i]) {
-            g_unlink (priv->ppd_file_names[i]);
-            g_free (priv->ppd_file_names[i]);
-          }
+          ppd_file_unref (priv->ppd_files[i]);
         }
       g_free (priv->dest_model_names);
-      g_free (priv->ppd_file_names);
+      g_free (priv->ppd_files);
       cupsFreeDests (priv->num_dests, priv->dests);
     }
   priv->dests = NULL;
   priv->num_dests = 0;
   priv->current_dest = -1;
   priv->dest_model_names = NULL;
-  priv->ppd_file_names = NULL;
+  priv->ppd_files = NULL;
 }
 
 enum
@@ -782,14 +809,12 @@ printer_selection_changed_cb (GtkTreeSelection *selection,
             }
         }
 
-      if (priv->ppd_file_names[priv->current_dest] == NULL)
-        priv->ppd_file_names[priv->current_dest] =
-          g_strdup (cupsGetPPD (priv->dests[priv->current_dest].name));
-
-      if (priv->dest_model_names[priv->current_dest] == NULL)
-        priv->dest_model_names[priv->current_dest] =
-          get_ppd_attribute (priv->ppd_file_names[priv->current_dest],
-                             "ModelName");
+      /* The model name is filled in once the PPD arrives */
+      if (priv->ppd_files[priv->current_dest] == NULL)
+        printer_get_ppd_file_async (priv->dests[priv->current_dest].name,
+                                    priv->printers_update_cancellable,
+                                    printer_get_ppd_file_cb,
+                                    self);
 
       printer_model = g_strdup (priv->dest_model_names[priv->current_dest]);
 
@@ -1147,6 +1172,46 @@ printer_selection_changed_cb (GtkTreeSelection *selection,
   update_sensitivity (self);
 }
 
+static void
+printer_get_ppd_file_cb (PPDFile  *ppd_file,
+                         gpointer  user_data)
+{
+  CcPrintersPanelPrivate *priv;
+  CcPrintersPanel        *self = (CcPrintersPanel*) user_data;
+  GtkTreeSelection       *selection;
+  GtkTreeView            *treeview;
+  gboolean                current_changed = FALSE;
+  gint                    i;
+
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  if (ppd_file == NULL)
+    return;
+
+  /* Instances share the PPD of their printer */
+  for (i = 0; i < priv->num_dests; i++)
+    {
+      if (priv->ppd_files[i] != NULL ||
+          g_strcmp0 (priv->dests[i].name, ppd_file->printer_name) != 0)
+        continue;
+
+      priv->ppd_files[i] = ppd_file_ref (ppd_file);
+      g_free (priv->dest_model_names[i]);
+      priv->dest_model_names[i] = ppd_file_get_attribute (ppd_file, "ModelName");
+
+      if (i == priv->current_dest)
+        current_changed = TRUE;
+    }
+
+  if (current_changed)
+    {
+      treeview = (GtkTreeView*)
+        gtk_builder_get_object (priv->builder, "printers-treeview");
+      selection = gtk_tree_view_get_selection (treeview);
+      printer_selection_changed_cb (selection, self);
+    }
+}
+
 static void
 set_current_page (GObject      *source_object,
                   GAsyncResult *result,
@@ -1165,6 +1230,198 @@ set_current_page (GObject      *source_object,
     gtk_stack_set_visible_child_name (GTK_STACK (widget), "no-cups-page");
 }
 
+static void
+get_printer_row_values (cups_dest_t  *dest,
+                        gchar       **name,
+                        gboolean     *paused,
+                        const gchar **default_icon_name,
+                        const gchar **icon_name)
+{
+  cups_ptype_t  printer_type = 0;
+  gchar        *device_uri = NULL;
+  int           j;
+
+  if (dest->instance)
+    *name = g_strdup_printf ("%s / %s", dest->name, dest->instance);
+  else
+    *name = g_strdup (dest->name);
+
+  *paused = FALSE;
+  for (j = 0; j < dest->num_options; j++)
+    {
+      if (g_strcmp0 (dest->options[j].name, "printer-state") == 0)
+        *paused = (g_strcmp0 (dest->options[j].value, "5") == 0);
+      else if (g_strcmp0 (dest->options[j].name, "device-uri") == 0)
+        device_uri = dest->options[j].value;
+      else if (g_strcmp0 (dest->options[j].name, "printer-type") == 0)
+        printer_type = atoi (dest->options[j].value);
+    }
+
+  if (dest->is_default)
+    *default_icon_name = "object-select-symbolic";
+  else
+    *default_icon_name = NULL;
+
+  if (printer_is_local (printer_type, device_uri))
+    *icon_name = "printer";
+  else
+    *icon_name = "printer-network";
+}
+
+/* Only sets the columns which differ, each change makes the tree view
+ * redraw and measure the row again */
+static void
+set_printer_row (GtkListStore *store,
+                 GtkTreeIter  *iter,
+                 gint          id,
+                 const gchar  *name,
+                 gboolean      paused,
+                 const gchar  *default_icon_name,
+                 const gchar  *icon_name)
+{
+  gboolean  old_paused;
+  gchar    *old_name;
+  gchar    *old_default_icon_name;
+  gchar    *old_icon_name;
+  gint      old_id;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), iter,
+                      PRINTER_ID_COLUMN, &old_id,
+                      PRINTER_NAME_COLUMN, &old_name,
+                      PRINTER_PAUSED_COLUMN, &old_paused,
+                      PRINTER_DEFAULT_ICON_COLUMN, &old_default_icon_name,
+                      PRINTER_ICON_COLUMN, &old_icon_name,
+                      -1);
+
+  if (old_id != id)
+    gtk_list_store_set (store, iter, PRINTER_ID_COLUMN, id, -1);
+  if (g_strcmp0 (old_name, name) != 0)
+    gtk_list_store_set (store, iter, PRINTER_NAME_COLUMN, name, -1);
+  if (old_paused != paused)
+    gtk_list_store_set (store, iter, PRINTER_PAUSED_COLUMN, paused, -1);
+  if (g_strcmp0 (old_default_icon_name, default_icon_name) != 0)
+    gtk_list_store_set (store, iter, PRINTER_DEFAULT_ICON_COLUMN, default_icon_name, -1);
+  if (g_strcmp0 (old_icon_name, icon_name) != 0)
+    gtk_list_store_set (store, iter, PRINTER_ICON_COLUMN, icon_name, -1);
+
+  g_free (old_name);
+  g_free (old_default_icon_name);
+  g_free (old_icon_name);
+}
+
+/* Puts the row of the given printer at position, reusing its current
+ * row if it has one */
+static void
+place_printer_row (GtkListStore *store,
+                   GHashTable   *rows,
+                   gint          position,
+                   const gchar  *name,
+                   GtkTreeIter  *iter)
+{
+  GtkTreeIter *existing;
+  GtkTreeIter  sibling;
+
+  existing = g_hash_table_lookup (rows, name);
+  if (existing != NULL)
+    {
+      *iter = *existing;
+      g_hash_table_remove (rows, name);
+
+      if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &sibling, NULL, position) &&
+          sibling.user_data != iter->user_data)
+        gtk_list_store_move_before (store, iter, &sibling);
+    }
+  else
+    {
+      gtk_list_store_insert (store, iter, position);
+    }
+}
+
+static void
+select_last_used_printer_cb (cups_job_t *jobs,
+                             gint        num_of_jobs,
+                             gpointer    user_data)
+{
+  CcPrintersPanelPrivate *priv;
+  GtkTreeSelection       *selection;
+  CcPrintersPanel        *self = (CcPrintersPanel*) user_data;
+  GtkTreeModel           *model;
+  GtkTreeView            *treeview;
+  GtkTreeIter             iter;
+  gboolean                valid;
+  gint                    dest = -1;
+  gint                    id;
+  gint                    i;
+
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  /* The panel is gone */
+  if (priv->printers_update_cancellable == NULL)
+    goto out;
+
+  /* A printer got selected while the jobs were being fetched */
+  treeview = (GtkTreeView*)
+    gtk_builder_get_object (priv->builder, "printers-treeview");
+  selection = gtk_tree_view_get_selection (treeview);
+  if (gtk_tree_selection_get_selected (selection, &model, NULL) ||
+      model == NULL)
+    goto out;
+
+  /* Select last used printer */
+  if (num_of_jobs > 0)
+    {
+      for (i = 0; i < priv->num_dests; i++)
+        if (g_strcmp0 (priv->dests[i].name, jobs[num_of_jobs - 1].dest) == 0)
+          {
+            dest = i;
+            break;
+          }
+    }
+
+  /* Select default printer */
+  if (dest < 0)
+    {
+      for (i = 0; i < priv->num_dests; i++)
+        if (priv->dests[i].is_default)
+          {
+            dest = i;
+            break;
+          }
+    }
+
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  if (dest >= 0)
+    {
+      while (valid)
+        {
+          gtk_tree_model_get (model, &iter,
+                              PRINTER_ID_COLUMN, &id,
+                              -1);
+          if (id == dest)
+            break;
+
+          valid = gtk_tree_model_iter_next (model, &iter);
+        }
+
+      /* Select first printer if that one is not in the list */
+      if (!valid)
+        valid = gtk_tree_model_get_iter_first (model, &iter);
+    }
+
+  if (valid)
+    {
+      priv->current_dest = dest;
+      gtk_tree_selection_select_iter (selection, &iter);
+    }
+
+  update_sensitivity (self);
+
+ out:
+  if (num_of_jobs > 0)
+    cupsFreeJobs (num_of_jobs, jobs);
+  g_object_unref (self);
+}
+
 static void
 actualize_printers_list_cb (GObject      *source_object,
                             GAsyncResult *result,
@@ -1174,12 +1431,11 @@ actualize_printers_list_cb (GObject      *source_object,
   GtkTreeSelection       *selection;
   CcPrintersPanel        *self = (CcPrintersPanel*) user_data;
   GtkListStore           *store;
-  cups_ptype_t            printer_type = 0;
   GtkTreeModel           *model;
+  GHashTable             *rows;
   GtkTreeIter             selected_iter;
   GtkTreeView            *treeview;
   GtkTreeIter             iter;
-  cups_job_t             *jobs = NULL;
   GtkWidget              *widget;
   gboolean                paused = FALSE;
   gboolean                selected_iter_set = FALSE;
@@ -1187,13 +1443,12 @@ actualize_printers_list_cb (GObject      *source_object,
   PpCups                 *cups = PP_CUPS (source_object);
   PpCupsDests            *cups_dests;
   gchar                  *current_printer_name = NULL;
-  gchar                  *printer_icon_name = NULL;
-  gchar                  *default_icon_name = NULL;
-  gchar                  *device_uri = NULL;
+  const gchar            *printer_icon_name = NULL;
+  const gchar            *default_icon_name = NULL;
   gint                    new_printer_position = 0;
+  gint                    position;
   int                     current_dest = -1;
-  int                     i, j;
-  int                     num_jobs = 0;
+  int                     i;
 
   priv = PRINTERS_PANEL_PRIVATE (self);
 
@@ -1231,14 +1486,23 @@ actualize_printers_list_cb (GObject      *source_object,
   g_free (cups_dests);
 
   priv->dest_model_names = g_new0 (gchar *, priv->num_dests);
-  priv->ppd_file_names = g_new0 (gchar *, priv->num_dests);
+  priv->ppd_files = g_new0 (PPDFile *, priv->num_dests);
 
-  store = gtk_list_store_new (PRINTER_N_COLUMNS,
-                              G_TYPE_INT,
-                              G_TYPE_STRING,
-                              G_TYPE_BOOLEAN,
-                              G_TYPE_STRING,
-                              G_TYPE_STRING);
+  model = gtk_tree_view_get_model (treeview);
+  if (model != NULL)
+    {
+      store = g_object_ref (GTK_LIST_STORE (model));
+    }
+  else
+    {
+      store = gtk_list_store_new (PRINTER_N_COLUMNS,
+                                  G_TYPE_INT,
+                                  G_TYPE_STRING,
+                                  G_TYPE_BOOLEAN,
+                                  G_TYPE_STRING,
+                                  G_TYPE_STRING);
+      gtk_tree_view_set_model (treeview, GTK_TREE_MODEL (store));
+    }
 
   if (priv->num_dests == 0 && !priv->new_printer_name)
     {
@@ -1254,11 +1518,9 @@ actualize_printers_list_cb (GObject      *source_object,
 
   g_object_unref (cups);
 
-  for (i = 0; i < priv->num_dests; i++)
+  if (priv->new_printer_name)
     {
-      gchar *instance;
-
-      if (priv->new_printer_name && new_printer_position >= 0)
+      for (i = 0; i < priv->num_dests && new_printer_position >= 0; i++)
         {
           gint comparison_result = g_ascii_strcasecmp (priv->dests[i].name, priv->new_printer_name);
 
@@ -1267,45 +1529,73 @@ actualize_printers_list_cb (GObject      *source_object,
           else if (comparison_result == 0)
             new_printer_position = -1;
         }
+    }
 
-      gtk_list_store_append (store, &iter);
+  /* Update the rows in place, keyed by printer name, rather than
+   * building a new model; this keeps the tree view from laying out
+   * every row again on each change of a single printer */
+  rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  while (valid)
+    {
+      gchar *name;
 
-      if (priv->dests[i].instance)
-        {
-          instance = g_strdup_printf ("%s / %s", priv->dests[i].name, priv->dests[i].instance);
-        }
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                          PRINTER_NAME_COLUMN, &name,
+                          -1);
+      if (name != NULL && !g_hash_table_contains (rows, name))
+        g_hash_table_insert (rows, name, g_memdup (&iter, sizeof (GtkTreeIter)));
       else
-        {
-          instance = g_strdup (priv->dests[i].name);
-        }
+        g_free (name);
+
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter);
+    }
+
+  g_signal_handlers_block_by_func (
+    G_OBJECT (gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview))),
+    printer_selection_changed_cb,
+    self);
+
+  gtk_tree_selection_unselect_all (gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview)));
 
-      for (j = 0; j < priv->dests[i].num_options; j++)
+  position = 0;
+  for (i = 0; i <= priv->num_dests; i++)
+    {
+      gchar *instance;
+
+      if (priv->new_printer_name && new_printer_position == i)
         {
-          if (g_strcmp0 (priv->dests[i].options[j].name, "printer-state") == 0)
-            paused = (g_strcmp0 (priv->dests[i].options[j].value, "5") == 0);
-          else if (g_strcmp0 (priv->dests[i].options[j].name, "device-uri") == 0)
-            device_uri = priv->dests[i].options[j].value;
-          else if (g_strcmp0 (priv->dests[i].options[j].name, "printer-type") == 0)
-            printer_type = atoi (priv->dests[i].options[j].value);
+          place_printer_row (store, rows, position++, priv->new_printer_name, &iter);
+          set_printer_row (store, &iter,
+                           -1,
+                           priv->new_printer_name,
+                           TRUE,
+                           NULL,
+                           priv->new_printer_on_network ? "printer-network" : "printer");
+
+          if (g_strcmp0 (current_printer_name, priv->new_printer_name) == 0)
+            {
+              selected_iter = iter;
+              selected_iter_set = TRUE;
+            }
         }
 
-      if (priv->dests[i].is_default)
-        default_icon_name = g_strdup ("object-select-symbolic");
-      else
-        default_icon_name = NULL;
+      if (i == priv->num_dests)
+        break;
 
-      if (printer_is_local (printer_type, device_uri))
-        printer_icon_name = g_strdup ("printer");
-      else
-        printer_icon_name = g_strdup ("printer-network");
-
-      gtk_list_store_set (store, &iter,
-                          PRINTER_ID_COLUMN, i,
-                          PRINTER_NAME_COLUMN, instance,
-                          PRINTER_PAUSED_COLUMN, paused,
-                          PRINTER_DEFAULT_ICON_COLUMN, default_icon_name,
-                          PRINTER_ICON_COLUMN, printer_icon_name,
-                          -1);
+      get_printer_row_values (&priv->dests[i],
+                              &instance,
+                              &paused,
+                              &default_icon_name,
+                              &printer_icon_name);
+
+      place_printer_row (store, rows, position++, instance, &iter);
+      set_printer_row (store, &iter,
+                       i,
+                       instance,
+                       paused,
+                       default_icon_name,
+                       printer_icon_name);
 
       if (g_strcmp0 (current_printer_name, instance) == 0)
         {
@@ -1315,35 +1605,13 @@ actualize_printers_list_cb (GObject      *source_object,
         }
 
       g_free (instance);
-      g_free (printer_icon_name);
-      g_free (default_icon_name);
     }
 
-  if (priv->new_printer_name && new_printer_position >= 0)
-    {
-      gtk_list_store_insert (store, &iter, new_printer_position);
-      gtk_list_store_set (store, &iter,
-                          PRINTER_ID_COLUMN, -1,
-                          PRINTER_NAME_COLUMN, priv->new_printer_name,
-                          PRINTER_PAUSED_COLUMN, TRUE,
-                          PRINTER_DEFAULT_ICON_COLUMN, NULL,
-                          PRINTER_ICON_COLUMN, priv->new_printer_on_network ?
-                            "printer-network" : "printer",
-                          -1);
+  /* Whatever is left after the placed rows are gone printers */
+  while (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, position))
+    gtk_list_store_remove (store, &iter);
 
-      if (g_strcmp0 (current_printer_name, priv->new_printer_name) == 0)
-        {
-          selected_iter = iter;
-          selected_iter_set = TRUE;
-        }
-    }
-
-  g_signal_handlers_block_by_func (
-    G_OBJECT (gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview))),
-    printer_selection_changed_cb,
-    self);
-
-  gtk_tree_view_set_model (treeview, GTK_TREE_MODEL (store));
+  g_hash_table_destroy (rows);
 
   g_signal_handlers_unblock_by_func (
     G_OBJECT (gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview))),
@@ -1357,80 +1625,227 @@ actualize_printers_list_cb (GObject      *source_object,
         gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview)),
         &selected_iter);
     }
-  else
+  else if (priv->num_dests > 0)
     {
-      num_jobs = cupsGetJobs (&jobs, NULL, 1, CUPS_WHICHJOBS_ALL);
+      /* The last used printer is only known once the jobs are in */
+      cups_get_jobs_async (NULL,
+                           TRUE,
+                           CUPS_WHICHJOBS_ALL,
+                           select_last_used_printer_cb,
+                           g_object_ref (self));
+    }
 
-      /* Select last used printer */
-      if (num_jobs > 0)
-        {
-          for (i = 0; i < priv->num_dests; i++)
-            if (g_strcmp0 (priv->dests[i].name, jobs[num_jobs - 1].dest) == 0)
-              {
-                priv->current_dest = i;
-                break;
-              }
-          cupsFreeJobs (num_jobs, jobs);
-        }
+  g_free (current_printer_name);
+  g_object_unref (store);
 
-      /* Select default printer */
-      if (priv->current_dest < 0)
-        {
-          for (i = 0; i < priv->num_dests; i++)
-            if (priv->dests[i].is_default)
-              {
-                priv->current_dest = i;
-                break;
-              }
-        }
+  update_sensitivity (self);
+}
+
+static void
+actualize_printers_list (CcPrintersPanel *self)
+{
+  PpCups *cups;
+
+  cups = pp_cups_new ();
+  pp_cups_get_dests_async (cups, NULL, actualize_printers_list_cb, self);
+}
+
+/* Returns the index of the destination of the given printer, or -1 if
+ * there is none or if the printer has instances, as those are only
+ * refreshed with the whole list */
+static gint
+find_dest (CcPrintersPanel *self,
+           const gchar     *printer_name)
+{
+  CcPrintersPanelPrivate *priv;
+  gint                    index = -1;
+  gint                    i;
+
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  for (i = 0; i < priv->num_dests; i++)
+    {
+      if (g_strcmp0 (priv->dests[i].name, printer_name) != 0)
+        continue;
 
-      if (priv->current_dest >= 0)
+      if (priv->dests[i].instance != NULL)
+        return -1;
+
+      index = i;
+    }
+
+  return index;
+}
+
+static void
+update_printer_cb (GObject      *source_object,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  CcPrintersPanelPrivate *priv;
+  GtkTreeSelection       *selection;
+  CcPrintersPanel        *self;
+  const gchar            *printer_icon_name;
+  const gchar            *default_icon_name;
+  GtkTreeModel           *model;
+  PpCupsDests            *cups_dests;
+  GtkTreeView            *treeview;
+  cups_dest_t            *dest;
+  GtkTreeIter             iter;
+  gboolean                paused;
+  gboolean                valid;
+  PpCups                 *cups = PP_CUPS (source_object);
+  GError                 *error = NULL;
+  gchar                  *instance;
+  gint                    i;
+
+  cups_dests = pp_cups_get_dest_finish (cups, result, &error);
+  g_object_unref (source_object);
+
+  if (cups_dests == NULL)
+    {
+      /* The panel is gone */
+      g_error_free (error);
+      return;
+    }
+
+  self = (CcPrintersPanel*) user_data;
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  if (cups_dests->num_of_dests == 0 ||
+      (i = find_dest (self, cups_dests->dests[0].name)) < 0)
+    {
+      /* Removed, or the list changed meanwhile */
+      actualize_printers_list (self);
+    }
+  else
+    {
+      /* Keep the destination and its cached model and PPD names, only
+       * its attributes are new */
+      dest = &cups_dests->dests[0];
+      cupsFreeOptions (priv->dests[i].num_options, priv->dests[i].options);
+      priv->dests[i].num_options = dest->num_options;
+      priv->dests[i].options = dest->options;
+      dest->num_options = 0;
+      dest->options = NULL;
+
+      treeview = (GtkTreeView*)
+        gtk_builder_get_object (priv->builder, "printers-treeview");
+      model = gtk_tree_view_get_model (treeview);
+
+      get_printer_row_values (&priv->dests[i],
+                              &instance,
+                              &paused,
+                              &default_icon_name,
+                              &printer_icon_name);
+
+      valid = model != NULL && gtk_tree_model_get_iter_first (model, &iter);
+      while (valid)
         {
           gint id;
-          valid = gtk_tree_model_get_iter_first ((GtkTreeModel *) store,
-                                                 &selected_iter);
 
-          while (valid)
+          gtk_tree_model_get (model, &iter,
+                              PRINTER_ID_COLUMN, &id,
+                              -1);
+          if (id == i)
             {
-              gtk_tree_model_get ((GtkTreeModel *) store, &selected_iter,
-                                  PRINTER_ID_COLUMN, &id,
-                                  -1);
-              if (id == priv->current_dest)
-                break;
-
-              valid = gtk_tree_model_iter_next ((GtkTreeModel *) store,
-                                                &selected_iter);
+              set_printer_row (GTK_LIST_STORE (model), &iter,
+                               i,
+                               instance,
+                               paused,
+                               default_icon_name,
+                               printer_icon_name);
+              break;
             }
 
-          gtk_tree_selection_select_iter (
-            gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview)),
-            &selected_iter);
+          valid = gtk_tree_model_iter_next (model, &iter);
         }
-      else if (priv->num_dests > 0)
+
+      g_free (instance);
+
+      if (i == priv->current_dest)
         {
-          /* Select first printer */
-          gtk_tree_model_get_iter_first ((GtkTreeModel *) store,
-                                         &selected_iter);
+          selection = gtk_tree_view_get_selection (treeview);
+          printer_selection_changed_cb (selection, self);
+        }
+    }
+
+  cupsFreeDests (cups_dests->num_of_dests, cups_dests->dests);
+  g_free (cups_dests);
+}
+
+static gboolean
+printers_list_update_cb (gpointer user_data)
+{
+  CcPrintersPanelPrivate *priv;
+  CcPrintersPanel        *self = (CcPrintersPanel*) user_data;
+  GHashTableIter          iter;
+  PpCups                 *cups;
+  gpointer                printer_name;
 
-          gtk_tree_selection_select_iter (
-            gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview)),
-            &selected_iter);
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  priv->printers_list_update_id = 0;
+
+  g_debug ("Updating printers list for %u notifications (%s), %u notifications coalesced so far",
+           priv->num_pending_notifications,
+           priv->printers_list_changed ? "whole list" : "changed printers only",
+           priv->num_coalesced_notifications);
+
+  if (priv->printers_list_changed)
+    {
+      actualize_printers_list (self);
+    }
+  else
+    {
+      g_hash_table_iter_init (&iter, priv->changed_printers);
+      while (g_hash_table_iter_next (&iter, &printer_name, NULL))
+        {
+          cups = pp_cups_new ();
+          pp_cups_get_dest_async (cups,
+                                  printer_name,
+                                  priv->printers_update_cancellable,
+                                  update_printer_cb,
+                                  self);
         }
     }
 
-  g_free (current_printer_name);
-  g_object_unref (store);
+  g_hash_table_remove_all (priv->changed_printers);
+  priv->printers_list_changed = FALSE;
+  priv->num_pending_notifications = 0;
 
-  update_sensitivity (self);
+  return G_SOURCE_REMOVE;
 }
 
+/* Collects the printer notifications arriving in a burst. Printers
+ * being added or removed need the whole list, state changes of known
+ * printers only refetch those printers. */
 static void
-actualize_printers_list (CcPrintersPanel *self)
+queue_printers_list_update (CcPrintersPanel *self,
+                            const gchar     *printer_name,
+                            gboolean         list_changed)
 {
-  PpCups *cups;
+  CcPrintersPanelPrivate *priv;
 
-  cups = pp_cups_new ();
-  pp_cups_get_dests_async (cups, NULL, actualize_printers_list_cb, self);
+  priv = PRINTERS_PANEL_PRIVATE (self);
+
+  priv->num_pending_notifications++;
+
+  if (list_changed ||
+      printer_name == NULL ||
+      find_dest (self, printer_name) < 0)
+    priv->printers_list_changed = TRUE;
+  else
+    g_hash_table_add (priv->changed_printers, g_strdup (printer_name));
+
+  if (priv->printers_list_update_id != 0)
+    {
+      priv->num_coalesced_notifications++;
+      return;
+    }
+
+  priv->printers_list_update_id =
+    g_timeout_add (PRINTERS_LIST_UPDATE_DELAY, printers_list_update_cb, self);
 }
 
 static void
@@ -1957,7 +2372,10 @@ printer_remove_cb (GtkToolButton *toolbutton,
     printer_name = priv->dests[priv->current_dest].name;
 
   if (printer_name && printer_delete (printer_name))
-    actualize_printers_list (self);
+    {
+      ppd_file_cache_invalidate (printer_name);
+      actualize_printers_list (self);
+    }
 }
 
 static void
@@ -2206,8 +2624,8 @@ select_ppd_in_dialog (GtkMenuItem *menuitem,
           priv->current_dest < priv->num_dests)
         {
           device_id =
-            get_ppd_attribute (priv->ppd_file_names[priv->current_dest],
-                               "1284DeviceID");
+            ppd_file_get_attribute (priv->ppd_files[priv->current_dest],
+                                    "1284DeviceID");
 
           if (device_id)
             {
@@ -2219,8 +2637,8 @@ select_ppd_in_dialog (GtkMenuItem *menuitem,
           if (manufacturer == NULL)
             {
               manufacturer =
-                get_ppd_attribute (priv->ppd_file_names[priv->current_dest],
-                                   "Manufacturer");
+                ppd_file_get_attribute (priv->ppd_files[priv->current_dest],
+                                        "Manufacturer");
             }
 
           if (manufacturer == NULL)
@@ -3089,7 +3507,7 @@ cc_printers_panel_init (CcPrintersPanel *self)
   priv->builder = gtk_builder_new ();
   priv->dests = NULL;
   priv->dest_model_names = NULL;
-  priv->ppd_file_names = NULL;
+  priv->ppd_files = NULL;
   priv->num_dests = 0;
   priv->current_dest = -1;
 
@@ -3105,6 +3523,13 @@ cc_printers_panel_init (CcPrintersPanel *self)
   priv->cups_bus_connection = NULL;
   priv->dbus_subscription_id = 0;
 
+  priv->printers_list_update_id = 0;
+  priv->printers_list_changed = FALSE;
+  priv->changed_printers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->num_pending_notifications = 0;
+  priv->num_coalesced_notifications = 0;
+  priv->printers_update_cancellable = g_cancellable_new ();
+
   priv->new_printer_name = NULL;
   priv->new_printer_location = NULL;
   priv->new_printer_make_and_model = NULL;
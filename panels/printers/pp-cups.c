@@ -99,6 +99,49 @@ pp_cups_get_dests_finish (PpCups        *cups,
   return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+static void
+get_dest_thread (GTask        *task,
+                 gpointer      source_object,
+                 gpointer      task_data,
+                 GCancellable *cancellable)
+{
+  PpCupsDests *dests;
+  const gchar *printer_name = task_data;
+
+  dests = g_new0 (PpCupsDests, 1);
+  dests->dests = cupsGetNamedDest (CUPS_HTTP_DEFAULT, printer_name, NULL);
+  dests->num_of_dests = dests->dests != NULL ? 1 : 0;
+
+  g_task_return_pointer (task, dests, (GDestroyNotify) pp_cups_dests_free);
+}
+
+/* Fetches the destination of a single printer, the result has no
+ * destination if the printer does not exist anymore */
+void
+pp_cups_get_dest_async (PpCups              *cups,
+                        const gchar         *printer_name,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+  GTask *task;
+
+  task = g_task_new (cups, cancellable, callback, user_data);
+  g_task_set_task_data (task, g_strdup (printer_name), g_free);
+  g_task_run_in_thread (task, get_dest_thread);
+  g_object_unref (task);
+}
+
+PpCupsDests *
+pp_cups_get_dest_finish (PpCups        *cups,
+                         GAsyncResult  *res,
+                         GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, cups), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 static void
 connection_test_thread (GTask        *task,
                         gpointer      source_object,
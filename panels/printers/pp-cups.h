@@ -65,6 +65,16 @@ PpCupsDests *pp_cups_get_dests_finish (PpCups               *cups,
                                        GAsyncResult         *result,
                                        GError              **error);
 
+void         pp_cups_get_dest_async   (PpCups               *cups,
+                                       const gchar          *printer_name,
+                                       GCancellable         *cancellable,
+                                       GAsyncReadyCallback   callback,
+                                       gpointer              user_data);
+
+PpCupsDests *pp_cups_get_dest_finish  (PpCups               *cups,
+                                       GAsyncResult         *result,
+                                       GError              **error);
+
 void         pp_cups_connection_test_async (PpCups              *cups,
                                             GAsyncReadyCallback  callback,
                                             gpointer             user_data);
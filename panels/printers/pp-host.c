@@ -24,6 +24,12 @@
 
 #define BUFFER_LENGTH 1024
 
+/* Seconds to wait for a connection or an answer of a single probe */
+#define PROBE_TIMEOUT 5
+
+/* Number of LPD queue names tried at once */
+#define MAX_LPD_PROBES 8
+
 struct _PpHostPrivate
 {
   gchar *hostname;
@@ -585,6 +591,7 @@ pp_host_get_jetdirect_devices_async (PpHost              *host,
   if (address != NULL && address[0] != '/')
     {
       client = g_socket_client_new ();
+      g_socket_client_set_timeout (client, PROBE_TIMEOUT);
 
       g_socket_client_connect_to_host_async (client,
                                              address,
@@ -652,7 +659,7 @@ test_lpd_queue (GSocketClient *client,
           bytes_written = g_output_stream_write (output,
                                                  buffer,
                                                  length,
-                                                 NULL,
+                                                 cancellable,
                                                  &error);
 
           if (bytes_written != -1)
@@ -660,7 +667,7 @@ test_lpd_queue (GSocketClient *client,
               bytes_read = g_input_stream_read (input,
                                                 buffer,
                                                 BUFFER_LENGTH,
-                                                NULL,
+                                                cancellable,
                                                 &error);
 
               if (bytes_read != -1)
@@ -673,7 +680,7 @@ test_lpd_queue (GSocketClient *client,
                       bytes_written = g_output_stream_write (output,
                                                              buffer,
                                                              length,
-                                                             NULL,
+                                                             cancellable,
                                                              &error);
 
                       result = TRUE;
@@ -694,125 +701,231 @@ test_lpd_queue (GSocketClient *client,
       g_object_unref (connection);
     }
 
+  g_clear_error (&error);
+
   return result;
 }
 
+typedef struct
+{
+  PpDevicesList *devices;
+  gchar         *address;
+  gint           port;
+  GPtrArray     *candidates;
+  gboolean      *running;
+  guint          num_running;
+  guint          next_candidate;
+  gint           found;
+  gboolean       finished;
+} LpdData;
+
+typedef struct
+{
+  LpdData *data;
+  guint    index;
+} LpdProbe;
+
 static void
-_pp_host_get_lpd_devices_thread (GTask        *task,
-                                 gpointer      source_object,
-                                 gpointer      task_data,
-                                 GCancellable *cancellable)
+lpd_data_free (LpdData *data)
 {
-  GSocketConnection *connection;
-  PpPrintDevice     *device;
-  PpHost            *host = (PpHost *) source_object;
-  PpHostPrivate     *priv = host->priv;
-  GSocketClient     *client;
-  PpDevicesList     *result;
-  GSDData           *data = (GSDData *) task_data;
-  GError            *error = NULL;
-  GList             *candidates = NULL;
-  GList             *iter;
-  gchar             *found_queue = NULL;
-  gchar             *candidate;
-  gchar             *address;
-  gchar             *device_uri;
-  gint               port;
-  gint               i;
+  if (data != NULL)
+    {
+      pp_devices_list_free (data->devices);
+      g_ptr_array_unref (data->candidates);
+      g_free (data->running);
+      g_free (data->address);
+      g_free (data);
+    }
+}
 
-  if (priv->port == PP_HOST_UNSET_PORT)
-    port = PP_HOST_DEFAULT_LPD_PORT;
-  else
-    port = priv->port;
+static void
+lpd_devices_return (GTask *task)
+{
+  PpPrintDevice *device;
+  PpHostPrivate *priv;
+  LpdData       *data = g_task_get_task_data (task);
+  gpointer       result;
+  gchar         *device_uri;
+
+  priv = PP_HOST (g_task_get_source_object (task))->priv;
+
+  if (data->found >= 0)
+    {
+      device_uri = g_strdup_printf ("lpd://%s:%d/%s",
+                                    priv->hostname,
+                                    data->port,
+                                    (gchar *) g_ptr_array_index (data->candidates, data->found));
+
+      device = g_object_new (PP_TYPE_PRINT_DEVICE,
+                             "is-network-device", TRUE,
+                             "device-uri", device_uri,
+                             /* Translators: The found device is a Line Printer Daemon printer */
+                             "device-name", _("LPD Printer"),
+                             "host-name", priv->hostname,
+                             "host-port", data->port,
+                             "acquisition-method", ACQUISITION_METHOD_LPD,
+                             NULL);
+
+      g_free (device_uri);
+
+      data->devices->devices = g_list_append (data->devices->devices, device);
+    }
+
+  data->finished = TRUE;
 
   result = data->devices;
   data->devices = NULL;
+  g_task_return_pointer (task, result, (GDestroyNotify) pp_devices_list_free);
+  g_object_unref (task);
+}
 
-  address = g_strdup_printf ("%s:%d", priv->hostname, port);
-  if (address == NULL || address[0] == '/')
-    goto out;
+static void
+lpd_queue_test_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  GSocketClient *client;
+  LpdProbe      *probe = (LpdProbe *) task_data;
+  gboolean       result;
 
   client = g_socket_client_new ();
+  g_socket_client_set_timeout (client, PROBE_TIMEOUT);
 
-  connection = g_socket_client_connect_to_host (client,
-                                                address,
-                                                port,
-                                                cancellable,
-                                                &error);
+  result = test_lpd_queue (client,
+                           probe->data->address,
+                           probe->data->port,
+                           cancellable,
+                           g_ptr_array_index (probe->data->candidates, probe->index));
 
-  if (connection != NULL)
+  g_object_unref (client);
+
+  g_task_return_boolean (task, result);
+}
+
+static void lpd_queue_test_next (GTask *task);
+
+static void
+lpd_queue_test_cb (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  LpdProbe *probe;
+  LpdData  *data;
+  GTask    *task = G_TASK (user_data);
+
+  probe = g_task_get_task_data (G_TASK (res));
+  data = probe->data;
+
+  data->running[probe->index] = FALSE;
+  data->num_running--;
+
+  if (g_task_propagate_boolean (G_TASK (res), NULL) &&
+      (data->found < 0 || probe->index < data->found))
+    data->found = probe->index;
+
+  if (!data->finished)
+    lpd_queue_test_next (task);
+
+  g_object_unref (task);
+}
+
+/* Keeps up to MAX_LPD_PROBES queue names tested at once. The first
+ * answering queue in the list of candidates wins, so the answer can
+ * come as soon as all the queues before it were tried. */
+static void
+lpd_queue_test_next (GTask *task)
+{
+  GCancellable *cancellable = g_task_get_cancellable (task);
+  LpdProbe     *probe;
+  LpdData      *data = g_task_get_task_data (task);
+  GTask        *probe_task;
+  guint         i;
+
+  while (data->found < 0 &&
+         data->num_running < MAX_LPD_PROBES &&
+         data->next_candidate < data->candidates->len &&
+         !g_cancellable_is_cancelled (cancellable))
     {
-      g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
-      g_object_unref (connection);
+      probe = g_new0 (LpdProbe, 1);
+      probe->data = data;
+      probe->index = data->next_candidate++;
+
+      data->running[probe->index] = TRUE;
+      data->num_running++;
+
+      probe_task = g_task_new (g_task_get_source_object (task),
+                               cancellable,
+                               lpd_queue_test_cb,
+                               g_object_ref (task));
+      g_task_set_task_data (probe_task, probe, g_free);
+      g_task_run_in_thread (probe_task, lpd_queue_test_thread);
+      g_object_unref (probe_task);
+    }
 
-      /* Most of this list is taken from system-config-printer */
-      candidates = g_list_append (candidates, g_strdup ("PASSTHRU"));
-      candidates = g_list_append (candidates, g_strdup ("AUTO"));
-      candidates = g_list_append (candidates, g_strdup ("BINPS"));
-      candidates = g_list_append (candidates, g_strdup ("RAW"));
-      candidates = g_list_append (candidates, g_strdup ("TEXT"));
-      candidates = g_list_append (candidates, g_strdup ("ps"));
-      candidates = g_list_append (candidates, g_strdup ("lp"));
-      candidates = g_list_append (candidates, g_strdup ("PORT1"));
-
-      for (i = 0; i < 8; i++)
-        {
-          candidates = g_list_append (candidates, g_strdup_printf ("LPT%d", i));
-          candidates = g_list_append (candidates, g_strdup_printf ("LPT%d_PASSTHRU", i));
-          candidates = g_list_append (candidates, g_strdup_printf ("COM%d", i));
-          candidates = g_list_append (candidates, g_strdup_printf ("COM%d_PASSTHRU", i));
-        }
+  if (data->found >= 0)
+    {
+      for (i = 0; i < data->found; i++)
+        if (data->running[i])
+          return;
+    }
+  else if (data->num_running > 0)
+    {
+      return;
+    }
 
-      for (i = 0; i < 50; i++)
-        candidates = g_list_append (candidates, g_strdup_printf ("pr%d", i));
+  lpd_devices_return (task);
+}
 
-      for (iter = candidates; iter != NULL; iter = iter->next)
-        {
-          candidate = (gchar *) iter->data;
+static void
+lpd_port_test_cb (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  GSocketConnection *connection;
+  LpdData           *data;
+  GTask             *task = G_TASK (user_data);
+  gint               i;
 
-          if (test_lpd_queue (client,
-                              address,
-                              port,
-                              cancellable,
-                              candidate))
-            {
-              found_queue = g_strdup (candidate);
-              break;
-            }
-        }
+  data = g_task_get_task_data (task);
 
-      if (found_queue != NULL)
-        {
-          device_uri = g_strdup_printf ("lpd://%s:%d/%s",
-                                        priv->hostname,
-                                        port,
-                                        found_queue);
+  connection = g_socket_client_connect_to_host_finish (G_SOCKET_CLIENT (source_object),
+                                                       res,
+                                                       NULL);
 
-          device = g_object_new (PP_TYPE_PRINT_DEVICE,
-                                 "is-network-device", TRUE,
-                                 "device-uri", device_uri,
-                                 /* Translators: The found device is a Line Printer Daemon printer */
-                                 "device-name", _("LPD Printer"),
-                                 "host-name", priv->hostname,
-                                 "host-port", port,
-                                 "acquisition-method", ACQUISITION_METHOD_LPD,
-                                 NULL);
+  if (connection == NULL)
+    {
+      lpd_devices_return (task);
+      return;
+    }
 
-          g_free (device_uri);
+  g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+  g_object_unref (connection);
 
-          result->devices = g_list_append (result->devices, device);
-        }
+  /* Most of this list is taken from system-config-printer */
+  g_ptr_array_add (data->candidates, g_strdup ("PASSTHRU"));
+  g_ptr_array_add (data->candidates, g_strdup ("AUTO"));
+  g_ptr_array_add (data->candidates, g_strdup ("BINPS"));
+  g_ptr_array_add (data->candidates, g_strdup ("RAW"));
+  g_ptr_array_add (data->candidates, g_strdup ("TEXT"));
+  g_ptr_array_add (data->candidates, g_strdup ("ps"));
+  g_ptr_array_add (data->candidates, g_strdup ("lp"));
+  g_ptr_array_add (data->candidates, g_strdup ("PORT1"));
 
-      g_list_free_full (candidates, g_free);
+  for (i = 0; i < 8; i++)
+    {
+      g_ptr_array_add (data->candidates, g_strdup_printf ("LPT%d", i));
+      g_ptr_array_add (data->candidates, g_strdup_printf ("LPT%d_PASSTHRU", i));
+      g_ptr_array_add (data->candidates, g_strdup_printf ("COM%d", i));
+      g_ptr_array_add (data->candidates, g_strdup_printf ("COM%d_PASSTHRU", i));
     }
 
-  g_object_unref (client);
+  for (i = 0; i < 50; i++)
+    g_ptr_array_add (data->candidates, g_strdup_printf ("pr%d", i));
 
-out:
-  g_task_return_pointer (task, result, (GDestroyNotify) pp_devices_list_free);
-  g_object_unref (task);
+  data->running = g_new0 (gboolean, data->candidates->len);
 
-  g_free (address);
+  lpd_queue_test_next (task);
 }
 
 void
@@ -821,15 +934,42 @@ pp_host_get_lpd_devices_async (PpHost              *host,
                                GAsyncReadyCallback  callback,
                                gpointer             user_data)
 {
-  GSDData *data;
-  GTask   *task;
+  PpHostPrivate *priv = host->priv;
+  GSocketClient *client;
+  LpdData       *data;
+  GTask         *task;
 
-  data = g_new0 (GSDData, 1);
+  data = g_new0 (LpdData, 1);
   data->devices = g_new0 (PpDevicesList, 1);
+  data->candidates = g_ptr_array_new_with_free_func (g_free);
+  data->found = -1;
+
+  if (priv->port == PP_HOST_UNSET_PORT)
+    data->port = PP_HOST_DEFAULT_LPD_PORT;
+  else
+    data->port = priv->port;
 
   task = g_task_new (G_OBJECT (host), cancellable, callback, user_data);
-  g_task_set_task_data (task, data, (GDestroyNotify) gsd_data_free);
-  g_task_run_in_thread (task, _pp_host_get_lpd_devices_thread);
+  g_task_set_task_data (task, data, (GDestroyNotify) lpd_data_free);
+
+  data->address = g_strdup_printf ("%s:%d", priv->hostname, data->port);
+  if (data->address == NULL || data->address[0] == '/')
+    {
+      lpd_devices_return (task);
+      return;
+    }
+
+  client = g_socket_client_new ();
+  g_socket_client_set_timeout (client, PROBE_TIMEOUT);
+
+  g_socket_client_connect_to_host_async (client,
+                                         data->address,
+                                         data->port,
+                                         cancellable,
+                                         lpd_port_test_cb,
+                                         task);
+
+  g_object_unref (client);
 }
 
 PpDevicesList *
@@ -213,6 +213,7 @@ pp_new_printer_dialog_set_ppd_list (PpNewPrinterDialog *dialog,
 {
   PpNewPrinterDialogPrivate *priv = dialog->priv;
 
+  ppd_list_free (priv->list);
   priv->list = ppd_list_copy (list);
 
   if (priv->ppd_selection_dialog)
@@ -440,6 +441,8 @@ pp_new_printer_dialog_finalize (GObject *object)
   priv->text_renderer = NULL;
   priv->icon_renderer = NULL;
 
+  g_clear_pointer (&priv->list, ppd_list_free);
+
   if (priv->host_search_timeout_id != 0)
     {
       g_source_remove (priv->host_search_timeout_id);
@@ -903,7 +903,7 @@ typedef struct
   GList        *executables;
   GList        *packages;
   guint         window_id;
-  gchar        *ppd_file_name;
+  PPDFile      *ppd_file;
   GCancellable *cancellable;
   gpointer      user_data;
 } IMEData;
@@ -916,11 +916,7 @@ install_missing_executables_cb (IMEData *data)
   pc_data->install_missing_executables_finished = TRUE;
   printer_configure_async_finish (pc_data);
 
-  if (data->ppd_file_name)
-    {
-      g_unlink (data->ppd_file_name);
-      g_clear_pointer (&data->ppd_file_name, g_free);
-    }
+  g_clear_pointer (&data->ppd_file, ppd_file_unref);
 
   if (data->executables)
     {
@@ -1081,11 +1077,7 @@ get_missing_executables_cb (GObject      *source_object,
   GList    *executables = NULL;
   GList    *item;
 
-  if (data->ppd_file_name)
-    {
-      g_unlink (data->ppd_file_name);
-      g_clear_pointer (&data->ppd_file_name, g_free);
-    }
+  g_clear_pointer (&data->ppd_file, ppd_file_unref);
 
   output = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
                                           res,
@@ -1166,16 +1158,17 @@ DBus method \"MissingExecutables\" to find missing executables and filters.");
 }
 
 static void
-printer_get_ppd_cb (const gchar *ppd_filename,
-                    gpointer     user_data)
+printer_get_ppd_file_cb (PPDFile  *ppd_file,
+                         gpointer  user_data)
 {
   GDBusConnection *bus;
   IMEData         *data = (IMEData *) user_data;
   GError          *error = NULL;
 
-  data->ppd_file_name = g_strdup (ppd_filename);
-  if (data->ppd_file_name)
+  if (ppd_file)
     {
+      data->ppd_file = ppd_file_ref (ppd_file);
+
       bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
       if (!bus)
         {
@@ -1189,7 +1182,7 @@ printer_get_ppd_cb (const gchar *ppd_filename,
                                   SCP_PATH,
                                   SCP_IFACE,
                                   "MissingExecutables",
-                                  g_variant_new ("(s)", data->ppd_file_name),
+                                  g_variant_new ("(s)", data->ppd_file->filename),
                                   G_VARIANT_TYPE ("(as)"),
                                   G_DBUS_CALL_FLAGS_NONE,
                                   DBUS_TIMEOUT,
@@ -1339,11 +1332,10 @@ printer_configure_async (PpNewPrinter *new_printer)
     ime_data->cancellable = g_object_ref (data->cancellable);
   ime_data->user_data = data;
 
-  printer_get_ppd_async (priv->name,
-                         NULL,
-                         0,
-                         printer_get_ppd_cb,
-                         ime_data);
+  printer_get_ppd_file_async (priv->name,
+                              NULL,
+                              printer_get_ppd_file_cb,
+                              ime_data);
 }
 
 static void
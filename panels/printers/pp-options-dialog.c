@@ -49,8 +49,8 @@ struct _PpOptionsDialog {
 
   gchar       *printer_name;
 
-  gchar       *ppd_filename;
-  gboolean     ppd_filename_set;
+  PPDFile     *ppd_file;
+  gboolean     ppd_file_set;
 
   cups_dest_t *destination;
   gboolean     destination_set;
@@ -560,81 +560,70 @@ populate_options_real (PpOptionsDialog *dialog)
                       dialog->sensitive);
     }
 
-  if (dialog->destination && dialog->ppd_filename)
+  if (dialog->destination && dialog->ppd_file)
     {
-      ppd_file = ppdOpenFile (dialog->ppd_filename);
-      ppdLocalize (ppd_file);
+      ppd_file = dialog->ppd_file->ppd;
 
-      if (ppd_file)
-        {
-          ppdMarkDefaults (ppd_file);
-          cupsMarkOptions (ppd_file,
-                           dialog->destination->num_options,
-                           dialog->destination->options);
+      ppdMarkDefaults (ppd_file);
+      cupsMarkOptions (ppd_file,
+                       dialog->destination->num_options,
+                       dialog->destination->options);
 
-          for (i = 0; i < ppd_file->num_groups; i++)
+      for (i = 0; i < ppd_file->num_groups; i++)
+        {
+          for (j = 0; j < ppd_file->groups[i].num_options; j++)
             {
-              for (j = 0; j < ppd_file->groups[i].num_options; j++)
+              grid = NULL;
+
+              if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                   color_group_whitelist))
+                grid = color_tab_grid;
+              else if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                        image_quality_group_whitelist))
+                grid = image_quality_tab_grid;
+              else if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                        job_group_whitelist))
+                grid = job_tab_grid;
+              else if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                        finishing_group_whitelist))
+                grid = finishing_tab_grid;
+              else if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                        installable_options_group_whitelist))
+                grid = installable_options_tab_grid;
+              else if (STRING_IN_TABLE (ppd_file->groups[i].name,
+                                        page_setup_group_whitelist))
+                grid = page_setup_tab_grid;
+
+              if (!STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                                    ppd_option_blacklist))
                 {
-                  grid = NULL;
-
-                  if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                       color_group_whitelist))
+                  if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                                                color_option_whitelist))
                     grid = color_tab_grid;
-                  else if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                            image_quality_group_whitelist))
+                  else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                                                     image_quality_option_whitelist))
                     grid = image_quality_tab_grid;
-                  else if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                            job_group_whitelist))
-                    grid = job_tab_grid;
-                  else if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                            finishing_group_whitelist))
+                  else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                                                     finishing_option_whitelist))
                     grid = finishing_tab_grid;
-                  else if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                            installable_options_group_whitelist))
-                    grid = installable_options_tab_grid;
-                  else if (STRING_IN_TABLE (ppd_file->groups[i].name,
-                                            page_setup_group_whitelist))
+                  else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
+                                                     page_setup_option_whitelist))
                     grid = page_setup_tab_grid;
 
-                  if (!STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                        ppd_option_blacklist))
-                    {
-                      if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                    color_option_whitelist))
-                        grid = color_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         image_quality_option_whitelist))
-                        grid = image_quality_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         finishing_option_whitelist))
-                        grid = finishing_tab_grid;
-                      else if (!grid && STRING_IN_TABLE (ppd_file->groups[i].options[j].keyword,
-                                                         page_setup_option_whitelist))
-                        grid = page_setup_tab_grid;
-
-                      if (!grid)
-                        grid = advanced_tab_grid;
-
-                      ppd_option_add (ppd_file->groups[i].options[j],
-                                      dialog->printer_name,
-                                      grid,
-                                      dialog->sensitive);
-                    }
+                  if (!grid)
+                    grid = advanced_tab_grid;
+
+                  ppd_option_add (ppd_file->groups[i].options[j],
+                                  dialog->printer_name,
+                                  grid,
+                                  dialog->sensitive);
                 }
             }
-
-          ppdClose (ppd_file);
         }
     }
 
-  dialog->ppd_filename_set = FALSE;
-  if (dialog->ppd_filename)
-    {
-      g_unlink (dialog->ppd_filename);
-      g_free (dialog->ppd_filename);
-      dialog->ppd_filename = NULL;
-    }
+  dialog->ppd_file_set = FALSE;
+  g_clear_pointer (&dialog->ppd_file, ppd_file_unref);
 
   dialog->destination_set = FALSE;
   if (dialog->destination)
@@ -696,19 +685,14 @@ populate_options_real (PpOptionsDialog *dialog)
 }
 
 static void
-printer_get_ppd_cb (const gchar *ppd_filename,
-                    gpointer     user_data)
+printer_get_ppd_file_cb (PPDFile  *ppd_file,
+                         gpointer  user_data)
 {
   PpOptionsDialog *dialog = (PpOptionsDialog *) user_data;
 
-  if (dialog->ppd_filename)
-    {
-      g_unlink (dialog->ppd_filename);
-      g_free (dialog->ppd_filename);
-    }
-
-  dialog->ppd_filename = g_strdup (ppd_filename);
-  dialog->ppd_filename_set = TRUE;
+  ppd_file_unref (dialog->ppd_file);
+  dialog->ppd_file = ppd_file ? ppd_file_ref (ppd_file) : NULL;
+  dialog->ppd_file_set = TRUE;
 
   if (dialog->destination_set &&
       dialog->ipp_attributes_set)
@@ -729,7 +713,7 @@ get_named_dest_cb (cups_dest_t *dest,
   dialog->destination = dest;
   dialog->destination_set = TRUE;
 
-  if (dialog->ppd_filename_set &&
+  if (dialog->ppd_file_set &&
       dialog->ipp_attributes_set)
     {
       populate_options_real (dialog);
@@ -748,7 +732,7 @@ get_ipp_attributes_cb (GHashTable *table,
   dialog->ipp_attributes = table;
   dialog->ipp_attributes_set = TRUE;
 
-  if (dialog->ppd_filename_set &&
+  if (dialog->ppd_file_set &&
       dialog->destination_set)
     {
       populate_options_real (dialog);
@@ -796,11 +780,10 @@ populate_options (PpOptionsDialog *dialog)
     gtk_builder_get_object (dialog->builder, "progress-label");
   gtk_widget_show (widget);
 
-  printer_get_ppd_async (dialog->printer_name,
-                         NULL,
-                         0,
-                         printer_get_ppd_cb,
-                         dialog);
+  printer_get_ppd_file_async (dialog->printer_name,
+                              NULL,
+                              printer_get_ppd_file_cb,
+                              dialog);
 
   get_named_dest_async (dialog->printer_name,
                         get_named_dest_cb,
@@ -862,8 +845,8 @@ pp_options_dialog_new (GtkWindow            *parent,
 
   dialog->printer_name = g_strdup (printer_name);
 
-  dialog->ppd_filename = NULL;
-  dialog->ppd_filename_set = FALSE;
+  dialog->ppd_file = NULL;
+  dialog->ppd_file_set = FALSE;
 
   dialog->destination = NULL;
   dialog->destination_set = FALSE;
@@ -900,12 +883,7 @@ pp_options_dialog_free (PpOptionsDialog *dialog)
   g_free (dialog->printer_name);
   dialog->printer_name = NULL;
 
-  if (dialog->ppd_filename)
-    {
-      g_unlink (dialog->ppd_filename);
-      g_free (dialog->ppd_filename);
-      dialog->ppd_filename = NULL;
-    }
+  g_clear_pointer (&dialog->ppd_file, ppd_file_unref);
 
   if (dialog->destination)
     {
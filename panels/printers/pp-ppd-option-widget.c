@@ -53,8 +53,8 @@ struct PpPPDOptionWidgetPrivate
   cups_dest_t *destination;
   gboolean     destination_set;
 
-  gchar    *ppd_filename;
-  gboolean  ppd_filename_set;
+  PPDFile  *ppd_file;
+  gboolean  ppd_file_set;
 
   GCancellable *cancellable;
 };
@@ -164,8 +164,8 @@ pp_ppd_option_widget_init (PpPPDOptionWidget *widget)
   priv->destination = NULL;
   priv->destination_set = FALSE;
 
-  priv->ppd_filename = NULL;
-  priv->ppd_filename_set = FALSE;
+  priv->ppd_file = NULL;
+  priv->ppd_file_set = FALSE;
 }
 
 static void
@@ -200,12 +200,7 @@ pp_ppd_option_widget_finalize (GObject *object)
           priv->destination = NULL;
         }
 
-      if (priv->ppd_filename)
-        {
-          g_unlink (priv->ppd_filename);
-          g_free (priv->ppd_filename);
-          priv->ppd_filename = NULL;
-        }
+      g_clear_pointer (&priv->ppd_file, ppd_file_unref);
 
       if (priv->cancellable)
         {
@@ -516,30 +511,22 @@ update_widget_real (PpPPDOptionWidget *widget)
       cups_option_free (priv->option);
       priv->option = NULL;
     }
-  else if (priv->ppd_filename)
+  else if (priv->ppd_file)
     {
-      ppd_file = ppdOpenFile (priv->ppd_filename);
-      ppdLocalize (ppd_file);
+      ppd_file = priv->ppd_file->ppd;
 
-      if (ppd_file)
-        {
-          ppdMarkDefaults (ppd_file);
+      ppdMarkDefaults (ppd_file);
 
-          for (iter = ppdFirstOption(ppd_file); iter; iter = ppdNextOption(ppd_file))
+      for (iter = ppdFirstOption(ppd_file); iter; iter = ppdNextOption(ppd_file))
+        {
+          if (g_str_equal (iter->keyword, priv->option_name))
             {
-              if (g_str_equal (iter->keyword, priv->option_name))
-                {
-                  option = cups_option_copy (iter);
-                  break;
-                }
+              option = cups_option_copy (iter);
+              break;
             }
-
-          ppdClose (ppd_file);
         }
 
-      g_unlink (priv->ppd_filename);
-      g_free (priv->ppd_filename);
-      priv->ppd_filename = NULL;
+      g_clear_pointer (&priv->ppd_file, ppd_file_unref);
     }
 
   if (option)
@@ -605,27 +592,22 @@ get_named_dest_cb (cups_dest_t *dest,
   priv->destination = dest;
   priv->destination_set = TRUE;
 
-  if (priv->ppd_filename_set)
+  if (priv->ppd_file_set)
     {
       update_widget_real (widget);
     }
 }
 
 static void
-printer_get_ppd_cb (const gchar *ppd_filename,
-                    gpointer     user_data)
+printer_get_ppd_file_cb (PPDFile  *ppd_file,
+                         gpointer  user_data)
 {
   PpPPDOptionWidget        *widget = (PpPPDOptionWidget *) user_data;
   PpPPDOptionWidgetPrivate *priv = widget->priv;
 
-  if (priv->ppd_filename)
-    {
-      g_unlink (priv->ppd_filename);
-      g_free (priv->ppd_filename);
-    }
-
-  priv->ppd_filename = g_strdup (ppd_filename);
-  priv->ppd_filename_set = TRUE;
+  ppd_file_unref (priv->ppd_file);
+  priv->ppd_file = ppd_file ? ppd_file_ref (ppd_file) : NULL;
+  priv->ppd_file_set = TRUE;
 
   if (priv->destination_set)
     {
@@ -638,16 +620,15 @@ update_widget (PpPPDOptionWidget *widget)
 {
   PpPPDOptionWidgetPrivate *priv = widget->priv;
 
-  priv->ppd_filename_set = FALSE;
+  priv->ppd_file_set = FALSE;
   priv->destination_set = FALSE;
 
   get_named_dest_async (priv->printer_name,
                         get_named_dest_cb,
                         widget);
 
-  printer_get_ppd_async (priv->printer_name,
-                         NULL,
-                         0,
-                         printer_get_ppd_cb,
-                         widget);
+  printer_get_ppd_file_async (priv->printer_name,
+                              priv->cancellable,
+                              printer_get_ppd_file_cb,
+                              widget);
 }
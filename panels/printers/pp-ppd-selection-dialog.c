@@ -393,6 +393,8 @@ pp_ppd_selection_dialog_free (PpPPDSelectionDialog *dialog)
 
   g_free (dialog->manufacturer);
 
+  ppd_list_free (dialog->list);
+
   g_free (dialog);
 }
 
@@ -412,7 +414,8 @@ void
 pp_ppd_selection_dialog_set_ppd_list (PpPPDSelectionDialog *dialog,
                                       PPDList              *list)
 {
-  dialog->list = list;
+  ppd_list_free (dialog->list);
+  dialog->list = ppd_list_copy (list);
   fill_ppds_list (dialog);
 }
 
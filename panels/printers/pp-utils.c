@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <glib.h>
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
@@ -1244,36 +1245,178 @@ get_page_size_from_locale (void)
     return "A4";
 }
 
+/*
+ * The blocking CUPS calls below run in one small pool of worker threads
+ * shared by the whole panel, rather than in a new thread each, so that
+ * opening dialogs for many printers does not flood cupsd with
+ * connections. Each worker keeps its own connection to the server.
+ */
+
+#define PP_WORK_QUEUE_MAX_WORKERS 4
+
+typedef enum
+{
+  /* Results the user is waiting for */
+  PP_WORK_PRIORITY_HIGH,
+  /* Prefetching */
+  PP_WORK_PRIORITY_LOW
+} PpWorkPriority;
+
+typedef struct
+{
+  GThreadFunc     func;
+  gpointer        data;
+  PpWorkPriority  priority;
+  guint           serial;
+} PpWork;
+
+static GPrivate worker_connection = G_PRIVATE_INIT ((GDestroyNotify) httpClose);
+
+static http_t *
+get_worker_connection (void)
+{
+  http_t *http;
+
+  http = g_private_get (&worker_connection);
+  if (http == NULL)
+    {
+      http = httpConnectEncrypt (cupsServer (), ippPort (), cupsEncryption ());
+      if (http == NULL)
+        return CUPS_HTTP_DEFAULT;
+
+      g_private_set (&worker_connection, http);
+    }
+
+  return http;
+}
+
+static void
+pp_work_run (gpointer data,
+             gpointer user_data)
+{
+  PpWork *work = (PpWork *) data;
+
+  work->func (work->data);
+  g_free (work);
+}
+
+static gint
+pp_work_compare (gconstpointer a,
+                 gconstpointer b,
+                 gpointer      user_data)
+{
+  const PpWork *work_a = a;
+  const PpWork *work_b = b;
+
+  if (work_a->priority != work_b->priority)
+    return work_a->priority < work_b->priority ? -1 : 1;
+
+  /* First come, first served within a priority */
+  return (gint) (work_a->serial - work_b->serial);
+}
+
+static GThreadPool *
+get_work_queue (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+      const gchar *env;
+      gint         max_workers = PP_WORK_QUEUE_MAX_WORKERS;
+
+      /* The number of workers can be tuned for big print servers */
+      env = g_getenv ("GNOME_CONTROL_CENTER_PRINTERS_WORKERS");
+      if (env != NULL && atoi (env) > 0)
+        max_workers = atoi (env);
+
+      new_pool = g_thread_pool_new (pp_work_run, NULL, max_workers, FALSE, NULL);
+      g_thread_pool_set_sort_function (new_pool, pp_work_compare, NULL);
+
+      g_once_init_leave (&pool, (gsize) new_pool);
+    }
+
+  return (GThreadPool *) pool;
+}
+
+static void
+pp_work_queue_push (GThreadFunc    func,
+                    gpointer       data,
+                    PpWorkPriority priority)
+{
+  static gint  serial = 0;
+  PpWork      *work;
+  GError      *error = NULL;
+
+  work = g_new0 (PpWork, 1);
+  work->func = func;
+  work->data = data;
+  work->priority = priority;
+  work->serial = (guint) g_atomic_int_add (&serial, 1);
+
+  /* The work stays queued even when a new worker could not be started */
+  if (!g_thread_pool_push (get_work_queue (), work, &error))
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+    }
+}
+
 typedef struct
 {
-  gchar        *printer_name;
-  gchar       **attributes_names;
   GHashTable   *result;
   GIACallback   callback;
   gpointer      user_data;
   GMainContext *context;
+} GIAReply;
+
+typedef struct
+{
+  gchar        *key;
+  gchar        *printer_name;
+  gchar       **attributes_names;
+  GHashTable   *result;
+  GList        *replies;
 } GIAData;
 
+/* Requests for the same attributes of the same printer share one
+ * IPP request while it is queued. Once it runs, the answer could
+ * predate changes made since, so later requests get their own. */
+static GMutex      gia_mutex;
+static GHashTable *gia_queued = NULL;
+
 static gboolean
 get_ipp_attributes_idle_cb (gpointer user_data)
 {
-  GIAData *data = (GIAData *) user_data;
+  GIAReply *reply = (GIAReply *) user_data;
 
-  data->callback (data->result, data->user_data);
+  reply->callback (reply->result, reply->user_data);
 
   return FALSE;
 }
 
+static void
+get_ipp_attributes_reply_free (gpointer user_data)
+{
+  GIAReply *reply = (GIAReply *) user_data;
+
+  if (reply->context)
+    g_main_context_unref (reply->context);
+  g_free (reply);
+}
+
 static void
 get_ipp_attributes_data_free (gpointer user_data)
 {
   GIAData *data = (GIAData *) user_data;
 
-  if (data->context)
-    g_main_context_unref (data->context);
+  g_free (data->key);
   g_free (data->printer_name);
   if (data->attributes_names)
     g_strfreev (data->attributes_names);
+  if (data->result)
+    g_hash_table_unref (data->result);
   g_free (data);
 }
 
@@ -1282,14 +1425,32 @@ get_ipp_attributes_cb (gpointer user_data)
 {
   GIAData *data = (GIAData *) user_data;
   GSource *idle_source;
+  GList   *replies;
+  GList   *iter;
 
-  idle_source = g_idle_source_new ();
-  g_source_set_callback (idle_source,
-                         get_ipp_attributes_idle_cb,
-                         data,
-                         get_ipp_attributes_data_free);
-  g_source_attach (idle_source, data->context);
-  g_source_unref (idle_source);
+  g_mutex_lock (&gia_mutex);
+  replies = data->replies;
+  data->replies = NULL;
+  g_mutex_unlock (&gia_mutex);
+
+  for (iter = replies; iter; iter = iter->next)
+    {
+      GIAReply *reply = (GIAReply *) iter->data;
+
+      if (data->result)
+        reply->result = g_hash_table_ref (data->result);
+
+      idle_source = g_idle_source_new ();
+      g_source_set_callback (idle_source,
+                             get_ipp_attributes_idle_cb,
+                             reply,
+                             get_ipp_attributes_reply_free);
+      g_source_attach (idle_source, reply->context);
+      g_source_unref (idle_source);
+    }
+
+  g_list_free (replies);
+  get_ipp_attributes_data_free (data);
 }
 
 static void
@@ -1310,6 +1471,11 @@ get_ipp_attributes_func (gpointer user_data)
   char            **requested_attrs = NULL;
   gint              i, j, length = 0;
 
+  /* No more requests join this one from now on */
+  g_mutex_lock (&gia_mutex);
+  g_hash_table_remove (gia_queued, data->key);
+  g_mutex_unlock (&gia_mutex);
+
   printer_uri = g_strdup_printf ("ipp://localhost/printers/%s", data->printer_name);
 
   if (data->attributes_names)
@@ -1325,7 +1491,7 @@ get_ipp_attributes_func (gpointer user_data)
                     "printer-uri", NULL, printer_uri);
       ippAddStrings (request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
                      "requested-attributes", length, NULL, (const char **) requested_attrs);
-      response = cupsDoRequest (CUPS_HTTP_DEFAULT, request, "/");
+      response = cupsDoRequest (get_worker_connection (), request, "/");
     }
 
   if (response)
@@ -1411,34 +1577,44 @@ get_ipp_attributes_async (const gchar  *printer_name,
                           GIACallback   callback,
                           gpointer      user_data)
 {
-  GIAData *data;
-  GThread *thread;
-  GError  *error = NULL;
+  GIAReply *reply;
+  GIAData  *data;
+  gchar    *names;
+  gchar    *key;
 
-  data = g_new0 (GIAData, 1);
-  data->printer_name = g_strdup (printer_name);
-  data->attributes_names = g_strdupv (attributes_names);
-  data->callback = callback;
-  data->user_data = user_data;
-  data->context = g_main_context_ref_thread_default ();
+  reply = g_new0 (GIAReply, 1);
+  reply->callback = callback;
+  reply->user_data = user_data;
+  reply->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("get-ipp-attributes",
-                             get_ipp_attributes_func,
-                             data,
-                             &error);
+  names = attributes_names ? g_strjoinv (",", attributes_names) : NULL;
+  key = g_strdup_printf ("%s\n%s", printer_name, names ? names : "");
+  g_free (names);
 
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
+  g_mutex_lock (&gia_mutex);
 
-      g_error_free (error);
-      get_ipp_attributes_data_free (data);
-    }
-  else
+  if (gia_queued == NULL)
+    gia_queued = g_hash_table_new (g_str_hash, g_str_equal);
+
+  data = g_hash_table_lookup (gia_queued, key);
+  if (data != NULL)
     {
-      g_thread_unref (thread);
+      data->replies = g_list_append (data->replies, reply);
+      g_mutex_unlock (&gia_mutex);
+      g_free (key);
+      return;
     }
+
+  data = g_new0 (GIAData, 1);
+  data->key = key;
+  data->printer_name = g_strdup (printer_name);
+  data->attributes_names = g_strdupv (attributes_names);
+  data->replies = g_list_append (NULL, reply);
+  g_hash_table_insert (gia_queued, data->key, data);
+
+  g_mutex_unlock (&gia_mutex);
+
+  pp_work_queue_push (get_ipp_attributes_func, data, PP_WORK_PRIORITY_HIGH);
 }
 
 IPPAttribute *
@@ -1517,6 +1693,8 @@ printer_set_ppd_async_dbus_cb (GObject      *source_object,
       else
         result = TRUE;
 
+      ppd_file_cache_invalidate (data->printer_name);
+
       g_variant_unref (output);
     }
   else
@@ -1796,7 +1974,7 @@ get_ppds_attribute_func (gpointer user_data)
   data->result = g_new0 (gchar *, g_strv_length (data->ppds_names) + 1);
   for (i = 0; data->ppds_names[i]; i++)
     {
-      ppd_filename = g_strdup (cupsGetServerPPD (CUPS_HTTP_DEFAULT, data->ppds_names[i]));
+      ppd_filename = g_strdup (cupsGetServerPPD (get_worker_connection (), data->ppds_names[i]));
       if (ppd_filename)
         {
           ppd_file = ppdOpenFile (ppd_filename);
@@ -1829,8 +2007,6 @@ get_ppds_attribute_async (gchar       **ppds_names,
                           gpointer      user_data)
 {
   GPAData *data;
-  GThread *thread;
-  GError  *error = NULL;
 
   if (!ppds_names || !attribute_name)
     {
@@ -1845,23 +2021,7 @@ get_ppds_attribute_async (gchar       **ppds_names,
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("get-ppds-attribute",
-                             get_ppds_attribute_func,
-                             data,
-                             &error);
-
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
-
-      g_error_free (error);
-      get_ppds_attribute_data_free (data);
-    }
-  else
-    {
-      g_thread_unref (thread);
-    }
+  pp_work_queue_push (get_ppds_attribute_func, data, PP_WORK_PRIORITY_HIGH);
 }
 
 
@@ -2651,6 +2811,229 @@ static const struct {
   { "zebra", "Zebra" },
 };
 
+/*
+ * Asking cupsd for all its PPDs takes seconds with big driver packages
+ * installed, so the resulting list is kept on disk. It is used as long
+ * as the same cupsd answers and none of the usual driver directories
+ * changed.
+ */
+
+#define PPDS_CACHE_TYPE "(sa(ssa(ss)))"
+
+static const gchar * const ppds_dirs[] =
+{
+  "/usr/share/cups/model",
+  "/usr/share/cups/drv",
+  "/usr/share/ppd",
+  "/usr/local/share/ppd",
+  "/opt/share/ppd",
+  "/usr/lib/cups/driver",
+  "/usr/libexec/cups/driver",
+};
+
+static gchar *
+get_ppds_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-control-center",
+                           "ppds.cache",
+                           NULL);
+}
+
+/* Drivers get installed in subdirectories, so look one level down */
+static gint64
+get_ppds_dir_mtime (const gchar *path)
+{
+  const gchar *name;
+  GStatBuf     buf;
+  gint64       mtime;
+  GDir        *dir;
+
+  if (g_stat (path, &buf) != 0)
+    return -1;
+
+  mtime = buf.st_mtime;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return mtime;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *subpath;
+
+      subpath = g_build_filename (path, name, NULL);
+      if (g_stat (subpath, &buf) == 0 && S_ISDIR (buf.st_mode))
+        mtime = MAX (mtime, buf.st_mtime);
+      g_free (subpath);
+    }
+
+  g_dir_close (dir);
+
+  return mtime;
+}
+
+static gchar *
+get_ppds_cache_key (http_t *http)
+{
+  const gchar *server;
+  GString     *key;
+  ipp_t       *response;
+  gint         i;
+
+  if (http == CUPS_HTTP_DEFAULT)
+    return NULL;
+
+  /* Any small request tells which cupsd we are talking to */
+  response = cupsDoRequest (http, ippNewRequest (CUPS_GET_DEFAULT), "/");
+  if (response == NULL)
+    return NULL;
+  ippDelete (response);
+
+  server = httpGetField (http, HTTP_FIELD_SERVER);
+  if (server == NULL || server[0] == '\0')
+    return NULL;
+
+  key = g_string_new (NULL);
+  g_string_append_printf (key, "%s:%d %s", cupsServer (), ippPort (), server);
+
+  for (i = 0; i < G_N_ELEMENTS (ppds_dirs); i++)
+    g_string_append_printf (key, " %s:%" G_GINT64_FORMAT,
+                            ppds_dirs[i], get_ppds_dir_mtime (ppds_dirs[i]));
+
+  return g_string_free (key, FALSE);
+}
+
+static PPDList *
+load_ppds_cache (const gchar *key)
+{
+  GVariantIter *manufacturers_iter;
+  GMappedFile  *file;
+  const gchar  *cache_key;
+  GVariant     *cache;
+  GVariant     *manufacturers;
+  PPDList      *list;
+  GBytes       *bytes;
+  gchar        *path;
+  gint          i, j;
+
+  path = get_ppds_cache_path ();
+  file = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+
+  if (file == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (PPDS_CACHE_TYPE), bytes, FALSE));
+  g_bytes_unref (bytes);
+
+  if (!g_variant_is_normal_form (cache))
+    {
+      g_variant_unref (cache);
+      return NULL;
+    }
+
+  g_variant_get (cache, "(&s@a(ssa(ss)))", &cache_key, &manufacturers);
+
+  if (g_strcmp0 (cache_key, key) != 0)
+    {
+      g_variant_unref (manufacturers);
+      g_variant_unref (cache);
+      return NULL;
+    }
+
+  list = g_new0 (PPDList, 1);
+  list->ref_count = 1;
+  list->num_of_manufacturers = g_variant_n_children (manufacturers);
+  list->manufacturers = g_new0 (PPDManufacturerItem *, list->num_of_manufacturers);
+
+  for (i = 0; i < list->num_of_manufacturers; i++)
+    {
+      PPDManufacturerItem *manufacturer;
+      const gchar         *name;
+      const gchar         *display_name;
+
+      manufacturer = g_new0 (PPDManufacturerItem, 1);
+      g_variant_get_child (manufacturers, i, "(&s&sa(ss))",
+                           &name, &display_name, &manufacturers_iter);
+      manufacturer->manufacturer_name = g_strdup (name);
+      manufacturer->manufacturer_display_name = g_strdup (display_name);
+      manufacturer->num_of_ppds = g_variant_iter_n_children (manufacturers_iter);
+      manufacturer->ppds = g_new0 (PPDName *, manufacturer->num_of_ppds);
+
+      for (j = 0; g_variant_iter_next (manufacturers_iter, "(&s&s)", &name, &display_name); j++)
+        {
+          manufacturer->ppds[j] = g_new0 (PPDName, 1);
+          manufacturer->ppds[j]->ppd_name = g_strdup (name);
+          manufacturer->ppds[j]->ppd_display_name = g_strdup (display_name);
+          manufacturer->ppds[j]->ppd_match_level = -1;
+        }
+
+      g_variant_iter_free (manufacturers_iter);
+      list->manufacturers[i] = manufacturer;
+    }
+
+  g_variant_unref (manufacturers);
+  g_variant_unref (cache);
+
+  return list;
+}
+
+static void
+save_ppds_cache (const gchar *key,
+                 PPDList     *list)
+{
+  GVariantBuilder  manufacturers;
+  GVariant        *cache;
+  GError          *error = NULL;
+  gchar           *path;
+  gchar           *dirname;
+  gint             i, j;
+
+  g_variant_builder_init (&manufacturers, G_VARIANT_TYPE ("a(ssa(ss))"));
+
+  for (i = 0; i < list->num_of_manufacturers; i++)
+    {
+      PPDManufacturerItem *manufacturer = list->manufacturers[i];
+
+      g_variant_builder_open (&manufacturers, G_VARIANT_TYPE ("(ssa(ss))"));
+      g_variant_builder_add (&manufacturers, "s", manufacturer->manufacturer_name);
+      g_variant_builder_add (&manufacturers, "s", manufacturer->manufacturer_display_name);
+      g_variant_builder_open (&manufacturers, G_VARIANT_TYPE ("a(ss)"));
+      for (j = 0; j < manufacturer->num_of_ppds; j++)
+        g_variant_builder_add (&manufacturers, "(ss)",
+                               manufacturer->ppds[j]->ppd_name,
+                               manufacturer->ppds[j]->ppd_display_name);
+      g_variant_builder_close (&manufacturers);
+      g_variant_builder_close (&manufacturers);
+    }
+
+  cache = g_variant_ref_sink (g_variant_new ("(s@a(ssa(ss)))",
+                                             key,
+                                             g_variant_builder_end (&manufacturers)));
+
+  path = get_ppds_cache_path ();
+  dirname = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dirname, 0755) != 0 ||
+      !g_file_set_contents (path,
+                            g_variant_get_data (cache),
+                            g_variant_get_size (cache),
+                            &error))
+    {
+      g_debug ("Failed to write PPD cache %s: %s", path,
+               error ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_free (dirname);
+  g_free (path);
+  g_variant_unref (cache);
+}
+
 static gpointer
 get_all_ppds_func (gpointer user_data)
 {
@@ -2671,10 +3054,31 @@ get_all_ppds_func (gpointer user_data)
   gchar           *mfg_normalized;
   gchar           *mdl;
   gchar           *manufacturer_display_name;
+  gchar           *cache_key;
   gint             i, j;
 
+  /* Nobody is waiting for it anymore */
+  if (data->cancellable &&
+      g_cancellable_is_cancelled (data->cancellable))
+    {
+      get_all_ppds_cb (data);
+      return NULL;
+    }
+
+  cache_key = get_ppds_cache_key (get_worker_connection ());
+  if (cache_key != NULL)
+    {
+      data->result = load_ppds_cache (cache_key);
+      if (data->result != NULL)
+        {
+          g_free (cache_key);
+          get_all_ppds_cb (data);
+          return NULL;
+        }
+    }
+
   request = ippNewRequest (CUPS_GET_PPDS);
-  response = cupsDoRequest (CUPS_HTTP_DEFAULT, request, "/");
+  response = cupsDoRequest (get_worker_connection (), request, "/");
 
   if (response &&
       ippGetStatusCode (response) <= IPP_OK_CONFLICT)
@@ -2834,6 +3238,7 @@ get_all_ppds_func (gpointer user_data)
       gchar          *name;
 
       data->result = g_new0 (PPDList, 1);
+      data->result->ref_count = 1;
       data->result->num_of_manufacturers = g_hash_table_size (ppds_hash);
       data->result->manufacturers = g_new0 (PPDManufacturerItem *, data->result->num_of_manufacturers);
 
@@ -2875,8 +3280,13 @@ get_all_ppds_func (gpointer user_data)
       g_list_free_full (sort_list, g_free);
       g_hash_table_destroy (ppds_hash);
       g_hash_table_destroy (manufacturers_hash);
+
+      if (cache_key != NULL)
+        save_ppds_cache (cache_key, data->result);
     }
 
+  g_free (cache_key);
+
   get_all_ppds_cb (data);
 
   return NULL;
@@ -2891,8 +3301,6 @@ get_all_ppds_async (GCancellable *cancellable,
                     gpointer      user_data)
 {
   GAPData *data;
-  GThread *thread;
-  GError  *error = NULL;
 
   data = g_new0 (GAPData, 1);
   if (cancellable)
@@ -2901,66 +3309,17 @@ get_all_ppds_async (GCancellable *cancellable,
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("get-all-ppds",
-                             get_all_ppds_func,
-                             data,
-                             &error);
-
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
-
-      g_error_free (error);
-      get_all_ppds_data_free (data);
-    }
-  else
-    {
-      g_thread_unref (thread);
-    }
+  /* Only needed once the user picks a driver */
+  pp_work_queue_push (get_all_ppds_func, data, PP_WORK_PRIORITY_LOW);
 }
 
 PPDList *
 ppd_list_copy (PPDList *list)
 {
-  PPDList *result = NULL;
-  gint     i, j;
-
   if (list)
-    {
-      result = g_new0 (PPDList, 1);
-      result->num_of_manufacturers = list->num_of_manufacturers;
-      result->manufacturers = g_new0 (PPDManufacturerItem *, list->num_of_manufacturers);
-
-      for (i = 0; i < result->num_of_manufacturers; i++)
-        {
-          result->manufacturers[i] = g_new0 (PPDManufacturerItem, 1);
-          result->manufacturers[i]->num_of_ppds = list->manufacturers[i]->num_of_ppds;
-          result->manufacturers[i]->ppds = g_new0 (PPDName *, result->manufacturers[i]->num_of_ppds);
-
-          result->manufacturers[i]->manufacturer_display_name =
-            g_strdup (list->manufacturers[i]->manufacturer_display_name);
-
-          result->manufacturers[i]->manufacturer_name =
-            g_strdup (list->manufacturers[i]->manufacturer_name);
+    g_atomic_int_inc (&list->ref_count);
 
-          for (j = 0; j < result->manufacturers[i]->num_of_ppds; j++)
-            {
-              result->manufacturers[i]->ppds[j] = g_new0 (PPDName, 1);
-
-              result->manufacturers[i]->ppds[j]->ppd_display_name =
-                g_strdup (list->manufacturers[i]->ppds[j]->ppd_display_name);
-
-              result->manufacturers[i]->ppds[j]->ppd_name =
-                g_strdup (list->manufacturers[i]->ppds[j]->ppd_name);
-
-              result->manufacturers[i]->ppds[j]->ppd_match_level =
-                list->manufacturers[i]->ppds[j]->ppd_match_level;
-            }
-        }
-    }
-
-  return result;
+  return list;
 }
 
 void
@@ -2968,7 +3327,7 @@ ppd_list_free (PPDList *list)
 {
   gint i, j;
 
-  if (list)
+  if (list && g_atomic_int_dec_and_test (&list->ref_count))
     {
       for (i = 0; i < list->num_of_manufacturers; i++)
         {
@@ -3083,7 +3442,7 @@ printer_get_ppd_func (gpointer user_data)
     }
   else
     {
-      data->result = g_strdup (cupsGetPPD (data->printer_name));
+      data->result = g_strdup (cupsGetPPD2 (get_worker_connection (), data->printer_name));
     }
 
   printer_get_ppd_cb (data);
@@ -3099,8 +3458,6 @@ printer_get_ppd_async (const gchar *printer_name,
                        gpointer     user_data)
 {
   PGPData *data;
-  GThread *thread;
-  GError  *error = NULL;
 
   data = g_new0 (PGPData, 1);
   data->printer_name = g_strdup (printer_name);
@@ -3110,25 +3467,306 @@ printer_get_ppd_async (const gchar *printer_name,
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("printer-get-ppd",
-                             printer_get_ppd_func,
-                             data,
-                             &error);
+  pp_work_queue_push (printer_get_ppd_func, data, PP_WORK_PRIORITY_HIGH);
+}
 
-  if (!thread)
+/*
+ * The PPD files of local printers are fetched and parsed once and then
+ * shared. A cached file is handed out as is for a while, after that cupsd
+ * is only asked whether it changed since. Only used from the main thread.
+ */
+
+#define PPD_CACHE_MAX_AGE (30 * G_USEC_PER_SEC)
+
+typedef struct
+{
+  PPDFile  *ppd_file;
+  time_t    modtime;
+  gint64    validated;
+  guint     serial;
+  gboolean  fetching;
+  GList    *requests;
+} PPDCacheEntry;
+
+typedef struct
+{
+  GCancellable *cancellable;
+  PGPFCallback  callback;
+  gpointer      user_data;
+} PPDCacheRequest;
+
+typedef struct
+{
+  gchar         *printer_name;
+  guint          serial;
+  gboolean       checked;
+  time_t         modtime;
+  http_status_t  status;
+  PPDFile       *result;
+  GMainContext  *context;
+} PPDCacheFetch;
+
+static GHashTable *ppd_cache = NULL;
+
+PPDFile *
+ppd_file_ref (PPDFile *ppd_file)
+{
+  g_atomic_int_inc (&ppd_file->ref_count);
+
+  return ppd_file;
+}
+
+void
+ppd_file_unref (PPDFile *ppd_file)
+{
+  if (ppd_file && g_atomic_int_dec_and_test (&ppd_file->ref_count))
     {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
+      ppdClose (ppd_file->ppd);
+      g_unlink (ppd_file->filename);
+      g_free (ppd_file->filename);
+      g_free (ppd_file->printer_name);
+      g_free (ppd_file);
+    }
+}
 
-      g_error_free (error);
-      printer_get_ppd_data_free (data);
+gchar *
+ppd_file_get_attribute (PPDFile     *ppd_file,
+                        const gchar *attribute_name)
+{
+  ppd_attr_t *ppd_attr;
+
+  if (ppd_file == NULL)
+    return NULL;
+
+  ppd_attr = ppdFindAttr (ppd_file->ppd, attribute_name, NULL);
+  if (ppd_attr == NULL)
+    return NULL;
+
+  return g_strdup (ppd_attr->value);
+}
+
+static void
+ppd_cache_entry_free (gpointer user_data)
+{
+  PPDCacheEntry *entry = (PPDCacheEntry *) user_data;
+
+  ppd_file_unref (entry->ppd_file);
+  g_free (entry);
+}
+
+static void
+ppd_cache_fetch_free (gpointer user_data)
+{
+  PPDCacheFetch *fetch = (PPDCacheFetch *) user_data;
+
+  if (fetch->context)
+    g_main_context_unref (fetch->context);
+  ppd_file_unref (fetch->result);
+  g_free (fetch->printer_name);
+  g_free (fetch);
+}
+
+static void ppd_cache_fetch (const gchar   *printer_name,
+                             PPDCacheEntry *entry,
+                             gboolean       check);
+
+static gboolean
+ppd_cache_fetch_done (gpointer user_data)
+{
+  PPDCacheRequest *request;
+  PPDCacheFetch   *fetch = (PPDCacheFetch *) user_data;
+  PPDCacheEntry   *entry;
+  PPDFile         *ppd_file;
+  GList           *requests;
+  GList           *iter;
+
+  entry = g_hash_table_lookup (ppd_cache, fetch->printer_name);
+
+  if (fetch->serial != entry->serial)
+    {
+      /* Invalidated meanwhile, what we got may be outdated already */
+      ppd_cache_fetch (fetch->printer_name, entry, TRUE);
+      return FALSE;
+    }
+
+  if (fetch->checked)
+    {
+      if (fetch->status == HTTP_OK)
+        {
+          ppd_file_unref (entry->ppd_file);
+          entry->ppd_file = fetch->result;
+          entry->modtime = fetch->modtime;
+          fetch->result = NULL;
+        }
+      else if (fetch->status != HTTP_NOT_MODIFIED)
+        {
+          g_clear_pointer (&entry->ppd_file, ppd_file_unref);
+          entry->modtime = 0;
+        }
+
+      entry->validated = entry->ppd_file ? g_get_monotonic_time () : 0;
+    }
+
+  requests = entry->requests;
+  entry->requests = NULL;
+  entry->fetching = FALSE;
+
+  /* Callbacks may ask for it again or invalidate the entry */
+  ppd_file = entry->ppd_file ? ppd_file_ref (entry->ppd_file) : NULL;
+
+  for (iter = requests; iter; iter = iter->next)
+    {
+      request = (PPDCacheRequest *) iter->data;
+
+      if (request->cancellable == NULL ||
+          !g_cancellable_is_cancelled (request->cancellable))
+        request->callback (ppd_file, request->user_data);
+
+      g_clear_object (&request->cancellable);
+      g_free (request);
+    }
+
+  g_list_free (requests);
+  ppd_file_unref (ppd_file);
+
+  return FALSE;
+}
+
+static gpointer
+ppd_cache_fetch_func (gpointer user_data)
+{
+  PPDCacheFetch *fetch = (PPDCacheFetch *) user_data;
+  ppd_file_t    *ppd;
+  GSource       *idle_source;
+  gchar          filename[1024] = "";
+
+  /* Answers HTTP_NOT_MODIFIED if the PPD is not newer than modtime */
+  fetch->status = cupsGetPPD3 (get_worker_connection (),
+                               fetch->printer_name,
+                               &fetch->modtime,
+                               filename,
+                               sizeof (filename));
+
+  if (fetch->status == HTTP_OK)
+    {
+      ppd = ppdOpenFile (filename);
+      if (ppd)
+        {
+          ppdLocalize (ppd);
+
+          fetch->result = g_new0 (PPDFile, 1);
+          fetch->result->printer_name = g_strdup (fetch->printer_name);
+          fetch->result->filename = g_strdup (filename);
+          fetch->result->ppd = ppd;
+          fetch->result->ref_count = 1;
+        }
+      else
+        {
+          g_unlink (filename);
+        }
+    }
+
+  idle_source = g_idle_source_new ();
+  g_source_set_callback (idle_source,
+                         ppd_cache_fetch_done,
+                         fetch,
+                         ppd_cache_fetch_free);
+  g_source_attach (idle_source, fetch->context);
+  g_source_unref (idle_source);
+
+  return NULL;
+}
+
+static void
+ppd_cache_fetch (const gchar   *printer_name,
+                 PPDCacheEntry *entry,
+                 gboolean       check)
+{
+  PPDCacheFetch *fetch;
+  GSource       *idle_source;
+
+  fetch = g_new0 (PPDCacheFetch, 1);
+  fetch->printer_name = g_strdup (printer_name);
+  fetch->serial = entry->serial;
+  fetch->checked = check;
+  fetch->modtime = entry->ppd_file ? entry->modtime : 0;
+  fetch->context = g_main_context_ref_thread_default ();
+
+  entry->fetching = TRUE;
+
+  if (check)
+    {
+      pp_work_queue_push (ppd_cache_fetch_func, fetch, PP_WORK_PRIORITY_HIGH);
     }
   else
     {
-      g_thread_unref (thread);
+      idle_source = g_idle_source_new ();
+      g_source_set_callback (idle_source,
+                             ppd_cache_fetch_done,
+                             fetch,
+                             ppd_cache_fetch_free);
+      g_source_attach (idle_source, fetch->context);
+      g_source_unref (idle_source);
     }
 }
 
+/* Calls callback with the PPD file of printer_name, or NULL if it has
+ * none or it could not be fetched. The callback gets a borrowed
+ * reference and is not called if cancellable got cancelled. */
+void
+printer_get_ppd_file_async (const gchar  *printer_name,
+                            GCancellable *cancellable,
+                            PGPFCallback  callback,
+                            gpointer      user_data)
+{
+  PPDCacheRequest *request;
+  PPDCacheEntry   *entry;
+
+  if (ppd_cache == NULL)
+    ppd_cache = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       ppd_cache_entry_free);
+
+  entry = g_hash_table_lookup (ppd_cache, printer_name);
+  if (entry == NULL)
+    {
+      entry = g_new0 (PPDCacheEntry, 1);
+      g_hash_table_insert (ppd_cache, g_strdup (printer_name), entry);
+    }
+
+  request = g_new0 (PPDCacheRequest, 1);
+  if (cancellable)
+    request->cancellable = g_object_ref (cancellable);
+  request->callback = callback;
+  request->user_data = user_data;
+
+  entry->requests = g_list_append (entry->requests, request);
+
+  /* Joins the fetch in progress otherwise */
+  if (!entry->fetching)
+    ppd_cache_fetch (printer_name,
+                     entry,
+                     entry->ppd_file == NULL ||
+                     g_get_monotonic_time () - entry->validated > PPD_CACHE_MAX_AGE);
+}
+
+/* To be called when the PPD of printer_name got changed or removed */
+void
+ppd_file_cache_invalidate (const gchar *printer_name)
+{
+  PPDCacheEntry *entry;
+
+  if (ppd_cache == NULL ||
+      (entry = g_hash_table_lookup (ppd_cache, printer_name)) == NULL)
+    return;
+
+  entry->serial++;
+  entry->modtime = 0;
+  entry->validated = 0;
+  g_clear_pointer (&entry->ppd_file, ppd_file_unref);
+}
+
 void
 pp_devices_list_free (PpDevicesList *result)
 {
@@ -3189,7 +3827,7 @@ get_named_dest_func (gpointer user_data)
 {
   GNDData *data = (GNDData *) user_data;
 
-  data->result = cupsGetNamedDest (CUPS_HTTP_DEFAULT, data->printer_name, NULL);
+  data->result = cupsGetNamedDest (get_worker_connection (), data->printer_name, NULL);
 
   get_named_dest_cb (data);
 
@@ -3202,8 +3840,6 @@ get_named_dest_async (const gchar *printer_name,
                       gpointer     user_data)
 {
   GNDData *data;
-  GThread *thread;
-  GError  *error = NULL;
 
   data = g_new0 (GNDData, 1);
   data->printer_name = g_strdup (printer_name);
@@ -3211,27 +3847,12 @@ get_named_dest_async (const gchar *printer_name,
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("get-named-dest",
-                             get_named_dest_func,
-                             data,
-                             &error);
-
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
-
-      g_error_free (error);
-      get_named_dest_data_free (data);
-    }
-  else
-    {
-      g_thread_unref (thread);
-    }
+  pp_work_queue_push (get_named_dest_func, data, PP_WORK_PRIORITY_HIGH);
 }
 
 typedef struct
 {
+  gchar        *printer_name;
   GCancellable *cancellable;
   PAOCallback   callback;
   gpointer      user_data;
@@ -3262,6 +3883,9 @@ printer_add_option_async_dbus_cb (GObject      *source_object,
       else
         success = TRUE;
 
+      /* The new default is stored in the PPD */
+      ppd_file_cache_invalidate (data->printer_name);
+
       g_variant_unref (output);
     }
   else
@@ -3276,6 +3900,7 @@ printer_add_option_async_dbus_cb (GObject      *source_object,
 
   if (data->cancellable)
     g_object_unref (data->cancellable);
+  g_free (data->printer_name);
   g_free (data);
 }
 
@@ -3311,6 +3936,7 @@ printer_add_option_async (const gchar   *printer_name,
     }
 
   data = g_new0 (PAOData, 1);
+  data->printer_name = g_strdup (printer_name);
   if (cancellable)
     data->cancellable = g_object_ref (cancellable);
   data->callback = callback;
@@ -3679,10 +4305,11 @@ cups_get_jobs_func (gpointer user_data)
 {
   CGJData *data = (CGJData *) user_data;
 
-  data->num_of_jobs = cupsGetJobs (&data->jobs,
-                                   data->printer_name,
-                                   data->my_jobs ? 1 : 0,
-                                   data->which_jobs);
+  data->num_of_jobs = cupsGetJobs2 (get_worker_connection (),
+                                    &data->jobs,
+                                    data->printer_name,
+                                    data->my_jobs ? 1 : 0,
+                                    data->which_jobs);
 
   cups_get_jobs_cb (data);
 
@@ -3697,8 +4324,6 @@ cups_get_jobs_async (const gchar *printer_name,
                      gpointer     user_data)
 {
   CGJData *data;
-  GThread *thread;
-  GError  *error = NULL;
 
   data = g_new0 (CGJData, 1);
   data->printer_name = g_strdup (printer_name);
@@ -3708,23 +4333,7 @@ cups_get_jobs_async (const gchar *printer_name,
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
 
-  thread = g_thread_try_new ("cups-get-jobs",
-                             cups_get_jobs_func,
-                             data,
-                             &error);
-
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, 0, user_data);
-
-      g_error_free (error);
-      cups_get_jobs_data_free (data);
-    }
-  else
-    {
-      g_thread_unref (thread);
-    }
+  pp_work_queue_push (cups_get_jobs_func, data, PP_WORK_PRIORITY_HIGH);
 }
 
 gchar *
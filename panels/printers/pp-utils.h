@@ -22,6 +22,7 @@
 
 #include <gtk/gtk.h>
 #include <cups/cups.h>
+#include <cups/ppd.h>
 
 #include "pp-print-device.h"
 
@@ -75,10 +76,13 @@ typedef struct
   gsize     num_of_ppds;
 } PPDManufacturerItem;
 
+/* Shared, use ppd_list_copy () and ppd_list_free () to keep and drop
+ * a reference; the list must not be modified. */
 typedef struct
 {
   PPDManufacturerItem **manufacturers;
   gsize                 num_of_manufacturers;
+  gint                  ref_count;
 } PPDList;
 
 typedef struct
@@ -224,6 +228,35 @@ void        printer_get_ppd_async (const gchar *printer_name,
                                    PGPCallback  callback,
                                    gpointer     user_data);
 
+/* A printer's PPD file, parsed and localized. It is shared by everyone
+ * asking for the same printer, so callers re-mark the options they are
+ * interested in (ppdMarkDefaults () first) and must not keep pointers
+ * into it across main loop iterations without a reference. */
+typedef struct
+{
+  gchar      *printer_name;
+  gchar      *filename;
+  ppd_file_t *ppd;
+  gint        ref_count;
+} PPDFile;
+
+PPDFile    *ppd_file_ref (PPDFile *ppd_file);
+
+void        ppd_file_unref (PPDFile *ppd_file);
+
+gchar      *ppd_file_get_attribute (PPDFile     *ppd_file,
+                                    const gchar *attribute_name);
+
+typedef void (*PGPFCallback) (PPDFile  *ppd_file,
+                              gpointer  user_data);
+
+void        printer_get_ppd_file_async (const gchar  *printer_name,
+                                        GCancellable *cancellable,
+                                        PGPFCallback  callback,
+                                        gpointer      user_data);
+
+void        ppd_file_cache_invalidate (const gchar *printer_name);
+
 typedef void (*GNDCallback) (cups_dest_t *destination,
                              gpointer     user_data);
 
@@ -0,0 +1,191 @@
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "pp-host.h"
+
+/* Time the fake LPD server takes to answer about any queue, in ms */
+#define LPD_ANSWER_DELAY 200
+
+/* The queue served by the fake LPD server, 7th in the list of candidates */
+#define LPD_QUEUE "lp"
+
+typedef struct
+{
+  GMainLoop     *loop;
+  gint           pending;
+  PpDevicesList *lpd_devices;
+  PpDevicesList *jetdirect_devices;
+  gint64         lpd_time;
+  gint64         jetdirect_time;
+} DiscoveryData;
+
+static gboolean
+lpd_run_cb (GThreadedSocketService *service,
+            GSocketConnection      *connection,
+            GObject                *source_object,
+            gpointer                user_data)
+{
+  GOutputStream *output;
+  GInputStream  *input;
+  gssize         length;
+  gchar          buffer[256];
+  gchar          answer;
+
+  input = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  /* The port test closes without sending anything */
+  length = g_input_stream_read (input, buffer, sizeof (buffer) - 1, NULL, NULL);
+  if (length <= 0)
+    return TRUE;
+  buffer[length] = '\0';
+
+  g_usleep (LPD_ANSWER_DELAY * 1000);
+
+  /* "\2queue\n" asks whether the queue is there, 0 means yes */
+  if (buffer[0] == '\2' &&
+      strncmp (buffer + 1, LPD_QUEUE, strlen (LPD_QUEUE)) == 0 &&
+      buffer[1 + strlen (LPD_QUEUE)] == '\n')
+    answer = 0;
+  else
+    answer = 1;
+
+  g_output_stream_write (output, &answer, 1, NULL, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+jetdirect_incoming_cb (GSocketService    *service,
+                       GSocketConnection *connection,
+                       GObject           *source_object,
+                       gpointer           user_data)
+{
+  /* Accepting the connection is all a JetDirect probe looks for */
+  return TRUE;
+}
+
+static void
+discovery_done (DiscoveryData *data)
+{
+  if (--data->pending == 0)
+    g_main_loop_quit (data->loop);
+}
+
+static void
+lpd_devices_cb (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+  DiscoveryData *data = user_data;
+
+  data->lpd_devices = pp_host_get_lpd_devices_finish (PP_HOST (source_object), res, NULL);
+  data->lpd_time = g_get_monotonic_time ();
+  discovery_done (data);
+}
+
+static void
+jetdirect_devices_cb (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  DiscoveryData *data = user_data;
+
+  data->jetdirect_devices = pp_host_get_jetdirect_devices_finish (PP_HOST (source_object), res, NULL);
+  data->jetdirect_time = g_get_monotonic_time ();
+  discovery_done (data);
+}
+
+static gchar *
+get_device_uri (PpDevicesList *list)
+{
+  g_assert (list != NULL);
+  g_assert_cmpint (g_list_length (list->devices), ==, 1);
+
+  return pp_print_device_get_device_uri (PP_PRINT_DEVICE (list->devices->data));
+}
+
+static void
+test_discovery (void)
+{
+  GSocketService *lpd_service;
+  GSocketService *jetdirect_service;
+  DiscoveryData   data = { 0 };
+  PpHost         *lpd_host;
+  PpHost         *jetdirect_host;
+  GError         *error = NULL;
+  guint16         lpd_port;
+  guint16         jetdirect_port;
+  gint64          start;
+  gint64          elapsed;
+  gchar          *uri;
+
+  lpd_service = g_threaded_socket_service_new (16);
+  lpd_port = g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER (lpd_service), NULL, &error);
+  g_assert_no_error (error);
+  g_signal_connect (lpd_service, "run", G_CALLBACK (lpd_run_cb), NULL);
+
+  jetdirect_service = g_socket_service_new ();
+  jetdirect_port = g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER (jetdirect_service), NULL, &error);
+  g_assert_no_error (error);
+  g_signal_connect (jetdirect_service, "incoming", G_CALLBACK (jetdirect_incoming_cb), NULL);
+
+  lpd_host = pp_host_new ("127.0.0.1");
+  g_object_set (lpd_host, "port", (gint) lpd_port, NULL);
+  jetdirect_host = pp_host_new ("127.0.0.1");
+  g_object_set (jetdirect_host, "port", (gint) jetdirect_port, NULL);
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+  data.pending = 2;
+
+  start = g_get_monotonic_time ();
+
+  pp_host_get_lpd_devices_async (lpd_host, NULL, lpd_devices_cb, &data);
+  pp_host_get_jetdirect_devices_async (jetdirect_host, NULL, jetdirect_devices_cb, &data);
+
+  g_main_loop_run (data.loop);
+
+  elapsed = (g_get_monotonic_time () - start) / 1000;
+
+  uri = g_strdup_printf ("lpd://127.0.0.1:%d/" LPD_QUEUE, lpd_port);
+  g_assert_cmpstr (get_device_uri (data.lpd_devices), ==, uri);
+  g_free (uri);
+
+  uri = g_strdup_printf ("socket://127.0.0.1:%d", jetdirect_port);
+  g_assert_cmpstr (get_device_uri (data.jetdirect_devices), ==, uri);
+  g_free (uri);
+
+  /* The JetDirect probe does not wait for the LPD one */
+  g_assert_cmpint (data.jetdirect_time, <, data.lpd_time);
+
+  /* Asking for the 7 queues up to LPD_QUEUE one after another would take
+   * 7 times LPD_ANSWER_DELAY, they are all asked at once */
+  g_test_message ("Discovery took %" G_GINT64_FORMAT " ms", elapsed);
+  g_assert_cmpint (elapsed, <, 3 * LPD_ANSWER_DELAY);
+
+  pp_devices_list_free (data.lpd_devices);
+  pp_devices_list_free (data.jetdirect_devices);
+  g_main_loop_unref (data.loop);
+  g_object_unref (lpd_host);
+  g_object_unref (jetdirect_host);
+
+  g_socket_service_stop (lpd_service);
+  g_socket_listener_close (G_SOCKET_LISTENER (lpd_service));
+  g_object_unref (lpd_service);
+  g_socket_service_stop (jetdirect_service);
+  g_socket_listener_close (G_SOCKET_LISTENER (jetdirect_service));
+  g_object_unref (jetdirect_service);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/printers/host/discovery", test_discovery);
+
+  return g_test_run ();
+}
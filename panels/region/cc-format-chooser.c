@@ -256,6 +256,14 @@ region_widget_new (const gchar *locale_id,
         g_object_set_data_full (G_OBJECT (row), "locale-untranslated-name", locale_untranslated_name, g_free);
         g_object_set_data (G_OBJECT (row), "is-extra", GUINT_TO_POINTER (is_extra));
 
+        /* Normalized once here, so that filtering only has to match them */
+        g_object_set_data_full (G_OBJECT (row), "locale-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_name), g_free);
+        g_object_set_data_full (G_OBJECT (row), "locale-current-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_current_name), g_free);
+        g_object_set_data_full (G_OBJECT (row), "locale-untranslated-name-key",
+                                cc_util_normalize_casefold_and_unaccent (locale_untranslated_name), g_free);
+
         return row;
 }
 
@@ -356,11 +364,7 @@ region_visible (GtkListBoxRow *row,
 {
         GtkDialog *chooser = user_data;
         CcFormatChooserPrivate *priv = GET_PRIVATE (chooser);
-        gchar *locale_name = NULL;
-        gchar *locale_current_name = NULL;
-        gchar *locale_untranslated_name = NULL;
         gboolean is_extra;
-        gboolean visible;
 
         if (row == priv->more_item)
                 return !priv->showing_extra;
@@ -373,29 +377,9 @@ region_visible (GtkListBoxRow *row,
         if (!priv->filter_words)
                 return TRUE;
 
-        visible = FALSE;
-
-        locale_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-name"));
-        visible = match_all (priv->filter_words, locale_name);
-        if (visible)
-                 goto out;
-
-        locale_current_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-current-name"));
-        visible = match_all (priv->filter_words, locale_current_name);
-        if (visible)
-                 goto out;
-
-        locale_untranslated_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-untranslated-name"));
-        visible = match_all (priv->filter_words, locale_untranslated_name);
-
-out:
-        g_free (locale_untranslated_name);
-        g_free (locale_current_name);
-        g_free (locale_name);
-        return visible;
+        return match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-name-key")) ||
+               match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-current-name-key")) ||
+               match_all (priv->filter_words, g_object_get_data (G_OBJECT (row), "locale-untranslated-name-key"));
 }
 
 static void
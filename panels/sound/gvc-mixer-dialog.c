@@ -46,6 +46,9 @@
 
 #define SCALE_SIZE 128
 
+/* How often to check whether the last volume change reached PulseAudio, in ms */
+#define VOLUME_WRITE_CHECK_INTERVAL 20
+
 #define GVC_MIXER_DIALOG_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), GVC_TYPE_MIXER_DIALOG, GvcMixerDialogPrivate))
 
 struct GvcMixerDialogPrivate
@@ -53,6 +56,7 @@ struct GvcMixerDialogPrivate
         GvcMixerControl *mixer_control;
         GHashTable      *bars; /* Application and event bars only */
         GtkWidget       *notebook;
+        GHashTable      *volume_writes; /* GvcMixerStream -> VolumeWrite */
         GtkWidget       *output_bar;
         GtkWidget       *input_bar;
         GtkWidget       *input_level_bar;
@@ -82,6 +86,16 @@ struct GvcMixerDialogPrivate
         guint            num_apps;
 };
 
+/* Volume changes from a slider, only one at a time is sent to
+ * PulseAudio, and the latest one is sent once it is done */
+typedef struct {
+        GvcMixerDialog *dialog;
+        GvcMixerStream *stream;
+        gboolean        has_pending;
+        pa_volume_t     pending;
+        guint           check_id;
+} VolumeWrite;
+
 enum {
         NAME_COLUMN,
         DEVICE_COLUMN,
@@ -107,6 +121,9 @@ static void     bar_set_stream              (GvcMixerDialog      *dialog,
 
 static void     on_adjustment_value_changed (GtkAdjustment  *adjustment,
                                              GvcMixerDialog *dialog);
+static void     queue_volume_write          (GvcMixerDialog *dialog,
+                                             GvcMixerStream *stream,
+                                             pa_volume_t     volume);
 static void     on_control_active_output_update (GvcMixerControl *control,
                                                  guint            id,
                                                  GvcMixerDialog  *dialog);
@@ -644,9 +661,7 @@ on_adjustment_value_changed (GtkAdjustment  *adjustment,
                 /* Make sure we do not unmute muted streams, there's a button for that */
                 if (volume == 0.0)
                         gvc_mixer_stream_set_is_muted (stream, TRUE);
-                /* Only push the volume if it's actually changed */
-                if (gvc_mixer_stream_set_volume (stream, (pa_volume_t) rounded) != FALSE)
-                        gvc_mixer_stream_push_volume (stream);
+                queue_volume_write (dialog, stream, (pa_volume_t) rounded);
         }
 }
 
@@ -690,20 +705,16 @@ lookup_bar_for_stream (GvcMixerDialog *dialog,
 }
 
 static void
-on_stream_volume_notify (GObject        *object,
-                         GParamSpec     *pspec,
-                         GvcMixerDialog *dialog)
+update_bar_volume (GvcMixerDialog *dialog,
+                   GvcMixerStream *stream)
 {
-        GvcMixerStream *stream;
         GtkWidget      *bar;
         GtkAdjustment  *adj;
 
-        stream = GVC_MIXER_STREAM (object);
-
         bar = lookup_bar_for_stream (dialog, stream);
 
         if (bar == NULL) {
-                g_warning ("Unable to find bar for stream %s in on_stream_volume_notify()",
+                g_warning ("Unable to find bar for stream %s in update_bar_volume()",
                            gvc_mixer_stream_get_name (stream));
                 return;
         }
@@ -722,6 +733,106 @@ on_stream_volume_notify (GObject        *object,
                                            dialog);
 }
 
+static void
+volume_write_free (VolumeWrite *write)
+{
+        if (write->check_id != 0)
+                g_source_remove (write->check_id);
+        g_object_unref (write->stream);
+        g_free (write);
+}
+
+/* Returns TRUE while a volume change is on its way to PulseAudio */
+static gboolean
+volume_write_flush (VolumeWrite *write)
+{
+        if (gvc_mixer_stream_is_running (write->stream))
+                return TRUE;
+
+        if (!write->has_pending)
+                return FALSE;
+        write->has_pending = FALSE;
+
+        /* Only push the volume if it's actually changed */
+        if (gvc_mixer_stream_set_volume (write->stream, write->pending) == FALSE)
+                return FALSE;
+        gvc_mixer_stream_push_volume (write->stream);
+
+        return gvc_mixer_stream_is_running (write->stream);
+}
+
+static gboolean
+volume_write_check_cb (gpointer user_data)
+{
+        VolumeWrite    *write = user_data;
+        GvcMixerDialog *dialog = write->dialog;
+        GvcMixerStream *stream;
+
+        if (volume_write_flush (write))
+                return G_SOURCE_CONTINUE;
+
+        write->check_id = 0;
+        stream = g_object_ref (write->stream);
+        g_hash_table_remove (dialog->priv->volume_writes, stream);
+
+        /* The echoes of our own changes were skipped, catch up with
+         * whatever PulseAudio ended up with */
+        if (lookup_bar_for_stream (dialog, stream) != NULL)
+                update_bar_volume (dialog, stream);
+        g_object_unref (stream);
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+queue_volume_write (GvcMixerDialog *dialog,
+                    GvcMixerStream *stream,
+                    pa_volume_t     volume)
+{
+        VolumeWrite *write;
+
+        write = g_hash_table_lookup (dialog->priv->volume_writes, stream);
+        if (write == NULL) {
+                write = g_new0 (VolumeWrite, 1);
+                write->dialog = dialog;
+                write->stream = g_object_ref (stream);
+                g_hash_table_insert (dialog->priv->volume_writes, stream, write);
+        }
+
+        write->pending = volume;
+        write->has_pending = TRUE;
+
+        /* Anything sent before is still in flight, the latest volume
+         * goes out once it is done */
+        if (write->check_id != 0)
+                return;
+
+        if (volume_write_flush (write)) {
+                write->check_id = g_timeout_add (VOLUME_WRITE_CHECK_INTERVAL,
+                                                 volume_write_check_cb,
+                                                 write);
+        } else {
+                g_hash_table_remove (dialog->priv->volume_writes, stream);
+        }
+}
+
+static void
+on_stream_volume_notify (GObject        *object,
+                         GParamSpec     *pspec,
+                         GvcMixerDialog *dialog)
+{
+        GvcMixerStream *stream;
+
+        stream = GVC_MIXER_STREAM (object);
+
+        /* Don't let the slider jump back to volumes we sent earlier */
+        if (dialog->priv->volume_writes != NULL &&
+            g_hash_table_contains (dialog->priv->volume_writes, stream))
+                return;
+
+        update_bar_volume (dialog, stream);
+}
+
 static void
 on_stream_is_muted_notify (GObject        *object,
                            GParamSpec     *pspec,
@@ -949,6 +1060,7 @@ bar_set_stream (GvcMixerDialog *dialog,
                 g_signal_handlers_disconnect_by_func (old_stream, on_stream_is_muted_notify, dialog);
                 g_signal_handlers_disconnect_by_func (old_stream, on_stream_volume_notify, dialog);
                 g_hash_table_remove (dialog->priv->bars, GUINT_TO_POINTER (gvc_mixer_stream_get_id (old_stream)));
+                g_hash_table_remove (dialog->priv->volume_writes, old_stream);
         }
 
         gtk_widget_set_sensitive (bar, (stream != NULL));
@@ -1866,6 +1978,11 @@ gvc_mixer_dialog_dispose (GObject *object)
                 dialog->priv->bars = NULL;
         }
 
+        if (dialog->priv->volume_writes != NULL) {
+                g_hash_table_destroy (dialog->priv->volume_writes);
+                dialog->priv->volume_writes = NULL;
+        }
+
         if (dialog->priv->test_dialog != NULL) {
                 gtk_dialog_response (GTK_DIALOG (dialog->priv->test_dialog),
                                      GTK_RESPONSE_OK);
@@ -1904,6 +2021,8 @@ gvc_mixer_dialog_init (GvcMixerDialog *dialog)
                                         GTK_ORIENTATION_VERTICAL);
         dialog->priv = GVC_MIXER_DIALOG_GET_PRIVATE (dialog);
         dialog->priv->bars = g_hash_table_new (NULL, NULL);
+        dialog->priv->volume_writes = g_hash_table_new_full (NULL, NULL, NULL,
+                                                             (GDestroyNotify) volume_write_free);
         dialog->priv->size_group = gtk_size_group_new (GTK_SIZE_GROUP_HORIZONTAL);
 }
 
@@ -40,7 +40,9 @@ struct _CcSearchProvider
 
   CcShellSearchProvider2 *skeleton;
 
-  GHashTable *iter_table; /* COL_ID -> GtkTreeIter */
+  /* Terms of the previous query, and their casefolded versions */
+  gchar **previous_terms;
+  gchar **previous_casefolded_terms;
 };
 
 struct _CcSearchProviderClass
@@ -56,38 +58,34 @@ typedef enum {
 
 G_DEFINE_TYPE (CcSearchProvider, cc_search_provider, G_TYPE_OBJECT)
 
+/* Shell calls us once per keystroke, with terms that mostly repeat
+ * those of the previous query, so only normalize the ones that changed. */
 static char **
-get_casefolded_terms (char **terms)
+get_casefolded_terms (CcSearchProvider  *self,
+                      char             **terms)
 {
   char **casefolded_terms;
-  int i, n;
+  int i, n, n_previous;
 
   n = g_strv_length ((char**) terms);
+  n_previous = self->previous_terms ? g_strv_length (self->previous_terms) : 0;
   casefolded_terms = g_new (char*, n + 1);
 
   for (i = 0; i < n; i++)
-    casefolded_terms[i] = cc_util_normalize_casefold_and_unaccent (terms[i]);
-  casefolded_terms[n] = NULL;
-
-  return casefolded_terms;
-}
-
-static gboolean
-matches_all_terms (GtkTreeModel  *model,
-                   GtkTreeIter   *iter,
-                   char         **terms)
-{
-  int i;
-
-  for (i = 0; terms[i]; i++)
     {
-      if (!cc_shell_model_iter_matches_search (CC_SHELL_MODEL (model),
-                                               iter,
-                                               terms[i]))
-        return FALSE;
+      if (i < n_previous && g_str_equal (terms[i], self->previous_terms[i]))
+        casefolded_terms[i] = g_strdup (self->previous_casefolded_terms[i]);
+      else
+        casefolded_terms[i] = cc_util_normalize_casefold_and_unaccent (terms[i]);
     }
+  casefolded_terms[n] = NULL;
 
-  return TRUE;
+  g_strfreev (self->previous_terms);
+  self->previous_terms = g_strdupv (terms);
+  g_strfreev (self->previous_casefolded_terms);
+  self->previous_casefolded_terms = g_strdupv (casefolded_terms);
+
+  return casefolded_terms;
 }
 
 static GtkTreeModel *
@@ -100,36 +98,36 @@ get_model (void)
 }
 
 static gchar **
-get_results (gchar **terms)
+get_results (CcSearchProvider  *self,
+             gchar            **terms)
 {
-  GtkTreeModel *model = get_model ();
-  GtkTreeIter iter;
-  GPtrArray *results;
-  gboolean ok;
+  CcShellModel *model = CC_SHELL_MODEL (get_model ());
   gchar **casefolded_terms;
+  gchar **results;
 
-  casefolded_terms = get_casefolded_terms (terms);
-  results = g_ptr_array_new ();
+  casefolded_terms = get_casefolded_terms (self, terms);
+  results = cc_shell_model_get_results (model, casefolded_terms);
+  g_strfreev (casefolded_terms);
 
-  cc_shell_model_set_sort_terms (CC_SHELL_MODEL (model), casefolded_terms);
+  return results;
+}
 
-  ok = gtk_tree_model_get_iter_first (model, &iter);
-  while (ok)
-    {
-      if (matches_all_terms (model, &iter, casefolded_terms))
-        {
-          gchar *id;
-          gtk_tree_model_get (model, &iter, COL_ID, &id, -1);
-          g_ptr_array_add (results, id);
-        }
-
-      ok = gtk_tree_model_iter_next (model, &iter);
-    }
+static gchar **
+get_subsearch_results (CcSearchProvider  *self,
+                       gchar            **previous_results,
+                       gchar            **terms)
+{
+  CcShellModel *model = CC_SHELL_MODEL (get_model ());
+  gchar **casefolded_terms;
+  gchar **results;
 
-  g_ptr_array_add (results, NULL);
+  casefolded_terms = get_casefolded_terms (self, terms);
+  results = cc_shell_model_get_subsearch_results (model,
+                                                  previous_results,
+                                                  casefolded_terms);
   g_strfreev (casefolded_terms);
 
-  return (char**) g_ptr_array_free (results, FALSE);
+  return results;
 }
 
 static gboolean
@@ -138,7 +136,7 @@ handle_get_initial_result_set (CcShellSearchProvider2  *skeleton,
                                char                   **terms,
                                CcSearchProvider        *self)
 {
-  gchar **results = get_results (terms);
+  gchar **results = get_results (self, terms);
   cc_shell_search_provider2_complete_get_initial_result_set (skeleton,
                                                              invocation,
                                                              (const char* const*) results);
@@ -153,14 +151,10 @@ handle_get_subsearch_result_set (CcShellSearchProvider2  *skeleton,
                                  char                   **terms,
                                  CcSearchProvider        *self)
 {
-  /* We ignore the previous results here since the model re-sorts for
-   * the new terms. This means that we're not really doing a subsearch
-   * but, on the other hand, the results are consistent with the
-   * control center's own search. In any case, the number of elements
-   * in the model is always small enough that we don't need to worry
-   * about this taking too long.
+  /* Only the previous results are filtered and ranked again, in the
+   * same order the control center's own search would use.
    */
-  gchar **results = get_results (terms);
+  gchar **results = get_subsearch_results (self, previous_results, terms);
   cc_shell_search_provider2_complete_get_subsearch_result_set (skeleton,
                                                                invocation,
                                                                (const char* const*) results);
@@ -168,40 +162,6 @@ handle_get_subsearch_result_set (CcShellSearchProvider2  *skeleton,
   return TRUE;
 }
 
-static GtkTreeIter *
-get_iter_for_result (CcSearchProvider *self,
-                     const gchar      *result)
-{
-  GtkTreeModel *model;
-  GtkTreeIter iter;
-  gboolean ok;
-  gchar *id;
-
-  /* Caching GtkTreeIters in this way is only OK because the model is
-   * a GtkListStore which guarantees that while a row exists, the iter
-   * is persistent.
-   */
-  if (self->iter_table)
-    goto lookup;
-
-  self->iter_table = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                            g_free, (GDestroyNotify) gtk_tree_iter_free);
-
-  model = get_model ();
-  ok = gtk_tree_model_get_iter_first (model, &iter);
-  while (ok)
-    {
-      gtk_tree_model_get (model, &iter, COL_ID, &id, -1);
-
-      g_hash_table_replace (self->iter_table, id, gtk_tree_iter_copy (&iter));
-
-      ok = gtk_tree_model_iter_next (model, &iter);
-    }
-
- lookup:
-  return g_hash_table_lookup (self->iter_table, result);
-}
-
 static gboolean
 handle_get_result_metas (CcShellSearchProvider2  *skeleton,
                          GDBusMethodInvocation   *invocation,
@@ -209,29 +169,26 @@ handle_get_result_metas (CcShellSearchProvider2  *skeleton,
                          CcSearchProvider        *self)
 {
   GtkTreeModel *model = get_model ();
-  GtkTreeIter *iter;
+  GtkTreeIter iter;
   int i;
   GVariantBuilder builder;
-  GAppInfo *app;
-  const char *id;
-  char *name, *description, *escaped_description;
+  char *id, *name, *description, *escaped_description;
   GIcon *icon;
 
   g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
 
   for (i = 0; results[i]; i++)
     {
-      iter = get_iter_for_result (self, results[i]);
-      if (!iter)
+      if (!cc_shell_model_get_iter_for_id (CC_SHELL_MODEL (model), results[i], &iter))
         continue;
 
-      gtk_tree_model_get (model, iter,
-                          COL_APP, &app,
+      /* Rows filled from the panel cache have no COL_APP */
+      gtk_tree_model_get (model, &iter,
                           COL_NAME, &name,
                           COL_GICON, &icon,
                           COL_DESCRIPTION, &description,
                           -1);
-      id = g_app_info_get_id (app);
+      id = cc_panel_loader_get_desktop_id (results[i]);
       escaped_description = g_markup_escape_text (description, -1);
 
       g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
@@ -248,7 +205,7 @@ handle_get_result_metas (CcShellSearchProvider2  *skeleton,
       g_free (name);
       g_free (description);
       g_free (escaped_description);
-      g_object_unref (app);
+      g_free (id);
       g_object_unref (icon);
     }
 
@@ -380,7 +337,8 @@ cc_search_provider_dispose (GObject *object)
   self = CC_SEARCH_PROVIDER (object);
 
   g_clear_object (&self->skeleton);
-  g_clear_pointer (&self->iter_table, g_hash_table_destroy);
+  g_clear_pointer (&self->previous_terms, g_strfreev);
+  g_clear_pointer (&self->previous_casefolded_terms, g_strfreev);
 
   G_OBJECT_CLASS (cc_search_provider_parent_class)->dispose (object);
 }
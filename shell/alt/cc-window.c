@@ -39,6 +39,7 @@
 #include "cc-shell-model.h"
 #include "cc-panel-list.h"
 #include "cc-panel-loader.h"
+#include "cc-shell-log.h"
 #include "cc-util.h"
 
 #define MOUSE_BACK_BUTTON 8
@@ -74,6 +75,8 @@ struct _CcWindow
   GtkListStore *store;
 
   CcPanel *active_panel;
+
+  gboolean panel_timing_logged;
 };
 
 static void     cc_shell_iface_init         (CcShellInterface      *iface);
@@ -128,6 +131,11 @@ activate_panel (CcWindow           *self,
     return FALSE;
 
   self->current_panel = GTK_WIDGET (cc_panel_loader_load_by_name (CC_SHELL (self), id, parameters));
+  if (!self->panel_timing_logged)
+    {
+      cc_shell_log_timing ("first panel constructed");
+      self->panel_timing_logged = TRUE;
+    }
   cc_shell_set_active_panel (CC_SHELL (self), CC_PANEL (self->current_panel));
   gtk_widget_show (self->current_panel);
 
@@ -324,6 +332,7 @@ setup_model (CcWindow *shell)
   model = GTK_TREE_MODEL (shell->store);
 
   cc_panel_loader_fill_model (CC_SHELL_MODEL (shell->store));
+  cc_shell_log_timing ("model filled");
 
   /* Create a row for each panel */
   valid = gtk_tree_model_get_iter_first (model, &iter);
@@ -803,6 +812,17 @@ create_window (CcWindow *self)
                     G_CALLBACK (window_button_release_event), self);
 }
 
+static gboolean
+first_draw_cb (GtkWidget *widget,
+               cairo_t   *cr,
+               gpointer   user_data)
+{
+  cc_shell_log_timing ("first frame drawn");
+  g_signal_handlers_disconnect_by_func (widget, first_draw_cb, user_data);
+
+  return FALSE;
+}
+
 static void
 cc_window_init (CcWindow *self)
 {
@@ -817,6 +837,9 @@ cc_window_init (CcWindow *self)
 
   /* After everything is loaded, select the first visible panel */
   cc_panel_list_activate (CC_PANEL_LIST (self->panel_list));
+
+  if (cc_shell_log_timings_enabled ())
+    g_signal_connect_after (self, "draw", G_CALLBACK (first_draw_cb), NULL);
 }
 
 CcWindow *
@@ -0,0 +1,143 @@
+/*
+ * The Control Center is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * The Control Center is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the Control Center; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Loads the panel list a number of times into a CcShellModel and
+ * reports how long sorting and filtering take for a few term sets.
+ *
+ * Usage: bench-shell-model [COPIES] [ROUNDS]
+ */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#include "cc-panel-loader.h"
+#include "cc-shell-model.h"
+#include "cc-util.h"
+
+#define DEFAULT_COPIES 20
+#define DEFAULT_ROUNDS 50
+
+static const char *term_sets[] = {
+  "",
+  "d",
+  "dis",
+  "display",
+  "net work",
+  "power bat",
+  "sound vol",
+  "a e i",
+  "zzz",
+  NULL
+};
+
+static char **
+get_casefolded_terms (const char *str)
+{
+  char *casefolded;
+  char **terms;
+
+  casefolded = cc_util_normalize_casefold_and_unaccent (str);
+  terms = g_strsplit (casefolded, " ", -1);
+  g_free (casefolded);
+
+  return terms;
+}
+
+static guint
+filter_model (CcShellModel  *model,
+              char         **terms)
+{
+  GtkTreeIter iter;
+  gboolean ok;
+  guint n = 0;
+
+  ok = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &iter);
+  while (ok)
+    {
+      gboolean matches = TRUE;
+      char **t;
+
+      for (t = terms; matches && *t; t++)
+        matches = cc_shell_model_iter_matches_search (model, &iter, *t);
+
+      if (matches)
+        n++;
+
+      ok = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter);
+    }
+
+  return n;
+}
+
+int
+main (int argc, char **argv)
+{
+  CcShellModel *model;
+  GTimer *timer;
+  guint copies, rounds;
+  guint i, j;
+
+  setlocale (LC_ALL, "");
+
+  copies = argc > 1 ? atoi (argv[1]) : DEFAULT_COPIES;
+  rounds = argc > 2 ? atoi (argv[2]) : DEFAULT_ROUNDS;
+
+  model = cc_shell_model_new ();
+  timer = g_timer_new ();
+
+  for (i = 0; i < copies; i++)
+    cc_panel_loader_fill_model (model);
+
+  g_print ("Filled model with %d rows in %.3f ms\n",
+           gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL),
+           g_timer_elapsed (timer, NULL) * 1000);
+
+  for (i = 0; term_sets[i]; i++)
+    {
+      char **terms;
+      gdouble sort_time, filter_time;
+      guint matches = 0;
+
+      terms = get_casefolded_terms (term_sets[i]);
+
+      g_timer_start (timer);
+      for (j = 0; j < rounds; j++)
+        {
+          cc_shell_model_set_sort_terms (model, NULL);
+          cc_shell_model_set_sort_terms (model, terms);
+        }
+      sort_time = g_timer_elapsed (timer, NULL) / rounds;
+
+      g_timer_start (timer);
+      for (j = 0; j < rounds; j++)
+        matches = filter_model (model, terms);
+      filter_time = g_timer_elapsed (timer, NULL) / rounds;
+
+      g_print ("%-12s sort: %8.3f ms  filter: %8.3f ms  (%u matches)\n",
+               term_sets[i], sort_time * 1000, filter_time * 1000, matches);
+
+      g_strfreev (terms);
+    }
+
+  g_timer_destroy (timer);
+  g_object_unref (model);
+
+  return 0;
+}
@@ -21,7 +21,9 @@
 
 #include <config.h>
 
+#include <errno.h>
 #include <string.h>
+#include <glib/gstdio.h>
 #include <gio/gdesktopappinfo.h>
 
 #include "cc-panel-loader.h"
@@ -164,19 +166,290 @@ parse_categories (GDesktopAppInfo *app)
   return retval;
 }
 
+char *
+cc_panel_loader_get_desktop_id (const char *name)
+{
+  return g_strconcat ("gnome-", name, "-panel.desktop", NULL);
+}
+
+/* The panel cache holds the model, with all strings already normalized,
+ * so that filling it at startup needs neither the desktop files nor any
+ * Unicode processing. It is only valid for the locale it was built in,
+ * and as long as neither the desktop files nor the directories they can
+ * be found in change. */
+
+#define CACHE_TYPE         "(ssa(sx)a(susmssmsasmv))"
+#define CACHE_ENTRY_FORMAT "(&su&sm&s&sm&s^a&smv)"
+
+#ifdef CC_ENABLE_ALT_CATEGORIES
+#define CACHE_FILENAME "panels-alt.cache"
+#else
+#define CACHE_FILENAME "panels.cache"
+#endif
+
+static char *
+get_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-control-center",
+                           CACHE_FILENAME,
+                           NULL);
+}
+
+/* Invalidates the cache when the panels built in change */
+static char *
+get_cache_version (void)
+{
+  GString *version;
+  int i;
+
+  version = g_string_new (PACKAGE_VERSION);
+  for (i = 0; i < G_N_ELEMENTS (all_panels); i++)
+    g_string_append_printf (version, ":%s", all_panels[i].name);
+
+  return g_string_free (version, FALSE);
+}
+
+static char *
+get_cache_locale (void)
+{
+  return g_strjoinv (":", (char **) g_get_language_names ());
+}
+
+static gint64
+get_mtime (const char *path)
+{
+  GStatBuf buf;
+
+  if (g_stat (path, &buf) != 0)
+    return -1;
+
+  return buf.st_mtime;
+}
+
+static GPtrArray *
+get_application_dirs (void)
+{
+  const char * const *data_dirs;
+  GPtrArray *dirs;
+  int i;
+
+  dirs = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (dirs, g_build_filename (g_get_user_data_dir (), "applications", NULL));
+
+  data_dirs = g_get_system_data_dirs ();
+  for (i = 0; data_dirs[i] != NULL; i++)
+    g_ptr_array_add (dirs, g_build_filename (data_dirs[i], "applications", NULL));
+
+  return dirs;
+}
+
+static gboolean
+cache_stamps_are_valid (GVariant *stamps)
+{
+  GVariantIter iter;
+  const char *path;
+  gint64 mtime;
+
+  g_variant_iter_init (&iter, stamps);
+  while (g_variant_iter_next (&iter, "(&sx)", &path, &mtime))
+    {
+      if (get_mtime (path) != mtime)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+fill_model_from_cache (CcShellModel *model)
+{
+  GMappedFile *file;
+  GBytes *bytes;
+  GVariant *cache, *stamps, *entries;
+  GVariantIter iter;
+  const char *version, *locale;
+  char *path, *expected_version, *expected_locale;
+  gboolean ret = FALSE;
+  const char *id, *name, *description, *casefolded_name, *casefolded_description;
+  const char **keywords;
+  guint32 category;
+  GVariant *serialized_icon;
+
+  path = get_cache_path ();
+  file = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+
+  if (file == NULL)
+    return FALSE;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+  g_bytes_unref (bytes);
+
+  if (!g_variant_is_normal_form (cache))
+    {
+      g_variant_unref (cache);
+      return FALSE;
+    }
+
+  g_variant_get (cache, "(&s&s@a(sx)@a(susmssmsasmv))",
+                 &version, &locale, &stamps, &entries);
+
+  expected_version = get_cache_version ();
+  expected_locale = get_cache_locale ();
+
+  if (g_strcmp0 (version, expected_version) != 0 ||
+      g_strcmp0 (locale, expected_locale) != 0 ||
+      !cache_stamps_are_valid (stamps))
+    goto out;
+
+  g_variant_iter_init (&iter, entries);
+  while (g_variant_iter_loop (&iter, CACHE_ENTRY_FORMAT,
+                              &id, &category, &name, &description,
+                              &casefolded_name, &casefolded_description,
+                              &keywords, &serialized_icon))
+    {
+      GIcon *icon = NULL;
+
+      if (serialized_icon != NULL)
+        icon = g_icon_deserialize (serialized_icon);
+
+      cc_shell_model_add_cached_item (model, category, id, name, description,
+                                      casefolded_name, casefolded_description,
+                                      keywords, icon);
+      g_clear_object (&icon);
+    }
+
+  ret = TRUE;
+
+ out:
+  g_free (expected_version);
+  g_free (expected_locale);
+  g_variant_unref (stamps);
+  g_variant_unref (entries);
+  g_variant_unref (cache);
+
+  return ret;
+}
+
+static void
+save_cache (CcShellModel *model,
+            GPtrArray    *desktop_files)
+{
+  GVariantBuilder stamps, entries;
+  GVariant *cache;
+  GPtrArray *dirs;
+  GError *error = NULL;
+  char *path, *dirname, *version, *locale;
+  int i;
+
+  g_variant_builder_init (&stamps, G_VARIANT_TYPE ("a(sx)"));
+
+  dirs = get_application_dirs ();
+  for (i = 0; i < dirs->len; i++)
+    {
+      const char *dir = g_ptr_array_index (dirs, i);
+      g_variant_builder_add (&stamps, "(sx)", dir, get_mtime (dir));
+    }
+  g_ptr_array_unref (dirs);
+
+  for (i = 0; i < desktop_files->len; i++)
+    {
+      const char *file = g_ptr_array_index (desktop_files, i);
+      g_variant_builder_add (&stamps, "(sx)", file, get_mtime (file));
+    }
+
+  g_variant_builder_init (&entries, G_VARIANT_TYPE ("a(susmssmsasmv)"));
+
+  for (i = 0; i < G_N_ELEMENTS (all_panels); i++)
+    {
+      GtkTreeIter iter;
+      guint category;
+      char *name, *description, *casefolded_name, *casefolded_description;
+      char **keywords;
+      GIcon *icon;
+      GVariant *serialized_icon = NULL;
+
+      if (!cc_shell_model_get_iter_for_id (model, all_panels[i].name, &iter))
+        continue;
+
+      gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
+                          COL_CATEGORY, &category,
+                          COL_NAME, &name,
+                          COL_DESCRIPTION, &description,
+                          COL_CASEFOLDED_NAME, &casefolded_name,
+                          COL_CASEFOLDED_DESCRIPTION, &casefolded_description,
+                          COL_KEYWORDS, &keywords,
+                          COL_GICON, &icon,
+                          -1);
+
+      if (icon != NULL)
+        serialized_icon = g_icon_serialize (icon);
+
+      g_variant_builder_add (&entries, "(susmssms^asmv)",
+                             all_panels[i].name, category, name, description,
+                             casefolded_name, casefolded_description,
+                             keywords ? keywords : (char *[]) { NULL },
+                             serialized_icon);
+
+      g_free (name);
+      g_free (description);
+      g_free (casefolded_name);
+      g_free (casefolded_description);
+      g_strfreev (keywords);
+      g_clear_object (&icon);
+      g_clear_pointer (&serialized_icon, g_variant_unref);
+    }
+
+  version = get_cache_version ();
+  locale = get_cache_locale ();
+  cache = g_variant_ref_sink (g_variant_new ("(ss@a(sx)@a(susmssmsasmv))",
+                                             version, locale,
+                                             g_variant_builder_end (&stamps),
+                                             g_variant_builder_end (&entries)));
+  g_free (version);
+  g_free (locale);
+
+  path = get_cache_path ();
+  dirname = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dirname, 0755) != 0 ||
+      !g_file_set_contents (path,
+                            g_variant_get_data (cache),
+                            g_variant_get_size (cache),
+                            &error))
+    {
+      g_debug ("Failed to write panel cache %s: %s", path,
+               error ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_free (dirname);
+  g_free (path);
+  g_variant_unref (cache);
+}
+
 void
 cc_panel_loader_fill_model (CcShellModel *model)
 {
+  GPtrArray *desktop_files;
   int i;
 
+  if (fill_model_from_cache (model))
+    return;
+
+  desktop_files = g_ptr_array_new_with_free_func (g_free);
+
   for (i = 0; i < G_N_ELEMENTS (all_panels); i++)
     {
       GDesktopAppInfo *app;
       char *desktop_name;
       int category;
 
-      desktop_name = g_strconcat ("gnome-", all_panels[i].name,
-                                  "-panel.desktop", NULL);
+      desktop_name = cc_panel_loader_get_desktop_id (all_panels[i].name);
       app = g_desktop_app_info_new (desktop_name);
       g_free (desktop_name);
 
@@ -187,6 +460,8 @@ cc_panel_loader_fill_model (CcShellModel *model)
           continue;
         }
 
+      g_ptr_array_add (desktop_files, g_strdup (g_desktop_app_info_get_filename (app)));
+
       category = parse_categories (app);
       if (G_UNLIKELY (category < 0))
         continue;
@@ -194,6 +469,9 @@ cc_panel_loader_fill_model (CcShellModel *model)
       cc_shell_model_add_item (model, category, G_APP_INFO (app), all_panels[i].name);
       g_object_unref (app);
     }
+
+  save_cache (model, desktop_files);
+  g_ptr_array_unref (desktop_files);
 }
 
 #ifndef CC_PANEL_LOADER_NO_GTYPES
@@ -30,6 +30,7 @@ G_BEGIN_DECLS
 
 void     cc_panel_loader_fill_model     (CcShellModel  *model);
 GList   *cc_panel_loader_get_panels     (void);
+char    *cc_panel_loader_get_desktop_id (const char    *name);
 CcPanel *cc_panel_loader_load_by_name   (CcShell       *shell,
                                          const char    *name,
                                          GVariant      *parameters);
@@ -44,6 +44,38 @@ cc_shell_log_default_handler (const gchar    *log_domain,
         g_log_default_handler (log_domain, log_level, message, unused_data);
 }
 
+/* Monotonic time at which timings started, or -1 when disabled */
+static gint64 timings_start = -1;
+
+void
+cc_shell_log_timings_init (void)
+{
+        if (g_getenv ("GNOME_CONTROL_CENTER_TIMINGS") == NULL)
+                return;
+
+        timings_start = g_get_monotonic_time ();
+        cc_shell_log_timing ("process start");
+}
+
+gboolean
+cc_shell_log_timings_enabled (void)
+{
+        return timings_start >= 0;
+}
+
+void
+cc_shell_log_timing (const char *event)
+{
+        gint64 now;
+
+        if (timings_start < 0)
+                return;
+
+        now = g_get_monotonic_time ();
+        g_printerr ("gnome-control-center timing: %" G_GINT64_FORMAT " us (+%.3f ms) %s\n",
+                    now, (now - timings_start) / 1000.0, event);
+}
+
 void
 cc_shell_log_init (void)
 {
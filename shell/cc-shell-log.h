@@ -27,6 +27,10 @@ G_BEGIN_DECLS
 void cc_shell_log_init      (void);
 void cc_shell_log_set_debug (gboolean debug);
 
+void     cc_shell_log_timings_init    (void);
+gboolean cc_shell_log_timings_enabled (void);
+void     cc_shell_log_timing          (const char *event);
+
 G_END_DECLS
 
 #endif /* __CC_SHELL_LOG_H */
@@ -30,74 +30,92 @@
 #define GNOME_SETTINGS_PANEL_CATEGORY GNOME_SETTINGS_PANEL_ID_KEY
 #define GNOME_SETTINGS_PANEL_ID_KEYWORDS "Keywords"
 
+typedef struct
+{
+  guint64 name;
+  gint    keywords;
+  gint    description;
+} CcShellModelScore;
+
+/* Per-row search data, built once when the row is added. All strings
+ * are interned, so comparing and sorting rows never allocates. */
+typedef struct
+{
+  GtkTreeIter        iter;
+  const gchar       *id;
+  const gchar       *casefolded_name;
+  const gchar       *casefolded_description;
+  const gchar      **keywords;
+  const gchar      **description_tokens;
+
+  /* Score against the current sort terms, see rank_entries() */
+  CcShellModelScore  score;
+} CcShellModelEntry;
+
+typedef struct
+{
+  CcShellModelEntry *entry;
+  CcShellModelScore  score;
+} CcShellModelResult;
+
 struct _CcShellModelPrivate
 {
   gchar **sort_terms;
+
+  /* GSequenceIter (GtkTreeIter.user_data) -> CcShellModelEntry. This,
+   * and keeping a GtkTreeIter in each entry, is only OK because the
+   * model is a GtkListStore, which guarantees that the iter of a row
+   * is persistent while the row exists. */
+  GHashTable *index;
+
+  /* COL_ID -> CcShellModelEntry */
+  GHashTable *ids;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (CcShellModel, cc_shell_model, GTK_TYPE_LIST_STORE)
 
-static gint
-sort_by_name (GtkTreeModel *model,
-              GtkTreeIter  *a,
-              GtkTreeIter  *b)
+static const gchar **
+intern_strv (gchar **strv)
 {
-  gchar *a_name = NULL;
-  gchar *b_name = NULL;
-  gint rval = 0;
+  const gchar **interned;
+  guint i, n;
 
-  gtk_tree_model_get (model, a, COL_CASEFOLDED_NAME, &a_name, -1);
-  gtk_tree_model_get (model, b, COL_CASEFOLDED_NAME, &b_name, -1);
+  if (strv == NULL)
+    return NULL;
 
-  rval = g_strcmp0 (a_name, b_name);
+  n = g_strv_length (strv);
+  interned = g_new (const gchar *, n + 1);
 
-  g_free (a_name);
-  g_free (b_name);
+  for (i = 0; i < n; i++)
+    interned[i] = g_intern_string (strv[i]);
+  interned[n] = NULL;
 
-  return rval;
+  return interned;
 }
 
-static gint
-sort_by_name_with_terms (GtkTreeModel  *model,
-                         GtkTreeIter   *a,
-                         GtkTreeIter   *b,
-                         gchar        **terms)
+static void
+entry_free (CcShellModelEntry *entry)
 {
-  gboolean a_match, b_match;
-  gchar *a_name = NULL;
-  gchar *b_name = NULL;
-  gint rval = 0;
-  gint i;
-
-  gtk_tree_model_get (model, a, COL_CASEFOLDED_NAME, &a_name, -1);
-  gtk_tree_model_get (model, b, COL_CASEFOLDED_NAME, &b_name, -1);
+  g_free (entry->keywords);
+  g_free (entry->description_tokens);
+  g_slice_free (CcShellModelEntry, entry);
+}
 
-  for (i = 0; terms[i]; ++i)
-    {
-      a_match = strstr (a_name, terms[i]) != NULL;
-      b_match = strstr (b_name, terms[i]) != NULL;
-
-      if (a_match && !b_match)
-        {
-          rval = -1;
-          break;
-        }
-      else if (!a_match && b_match)
-        {
-          rval = 1;
-          break;
-        }
-    }
+static CcShellModelEntry *
+get_entry (CcShellModel *self,
+           GtkTreeIter  *iter)
+{
+  CcShellModelEntry *entry;
 
-  g_free (a_name);
-  g_free (b_name);
+  entry = g_hash_table_lookup (self->priv->index, iter->user_data);
+  g_assert (entry != NULL);
 
-  return rval;
+  return entry;
 }
 
 static gint
-count_matches (gchar **keywords,
-               gchar **terms)
+count_matches (const gchar **keywords,
+               gchar       **terms)
 {
   gint i, j, c;
 
@@ -114,107 +132,71 @@ count_matches (gchar **keywords,
   return c;
 }
 
-static gint
-sort_by_keywords_with_terms (GtkTreeModel  *model,
-                             GtkTreeIter   *a,
-                             GtkTreeIter   *b,
-                             gchar        **terms)
+/* The name score has one bit per term, the first term being the most
+ * significant one, so that comparing scores gives the same result as
+ * comparing matches term by term. */
+static void
+compute_score (CcShellModelEntry  *entry,
+               gchar             **terms,
+               CcShellModelScore  *score)
 {
-  gint a_matches, b_matches;
-  gchar **a_keywords = NULL;
-  gchar **b_keywords = NULL;
-  gint rval = 0;
+  gint i;
 
-  gtk_tree_model_get (model, a, COL_KEYWORDS, &a_keywords, -1);
-  gtk_tree_model_get (model, b, COL_KEYWORDS, &b_keywords, -1);
+  score->name = 0;
+  score->keywords = 0;
+  score->description = 0;
 
-  a_matches = count_matches (a_keywords, terms);
-  b_matches = count_matches (b_keywords, terms);
+  if (!terms || !terms[0])
+    return;
 
-  if (a_matches > b_matches)
-    rval = -1;
-  else if (a_matches < b_matches)
-    rval = 1;
+  for (i = 0; terms[i] && i < 64; ++i)
+    if (strstr (entry->casefolded_name, terms[i]) != NULL)
+      score->name |= G_GUINT64_CONSTANT (1) << (63 - i);
 
-  g_strfreev (a_keywords);
-  g_strfreev (b_keywords);
+  score->keywords = count_matches (entry->keywords, terms);
 
-  return rval;
+  /* Rows with a description always sort before rows without one */
+  if (entry->description_tokens)
+    score->description = count_matches (entry->description_tokens, terms);
+  else
+    score->description = -1;
 }
 
-static gint
-sort_by_description_with_terms (GtkTreeModel  *model,
-                                GtkTreeIter   *a,
-                                GtkTreeIter   *b,
-                                gchar        **terms)
+static void
+rank_entries (CcShellModel *self)
 {
-  gint a_matches, b_matches;
-  gchar *a_description = NULL;
-  gchar *b_description = NULL;
-  gchar **a_description_split = NULL;
-  gchar **b_description_split = NULL;
-  gint rval = 0;
-
-  gtk_tree_model_get (model, a, COL_DESCRIPTION, &a_description, -1);
-  gtk_tree_model_get (model, b, COL_DESCRIPTION, &b_description, -1);
-
-  if (a_description && !b_description)
-    {
-      rval = -1;
-      goto out;
-    }
-  else if (!a_description && b_description)
-    {
-      rval = 1;
-      goto out;
-    }
-  else if (!a_description && !b_description)
-    {
-      rval = 0;
-      goto out;
-    }
-
-  a_description_split = g_strsplit (a_description, " ", -1);
-  b_description_split = g_strsplit (b_description, " ", -1);
-
-  a_matches = count_matches (a_description_split, terms);
-  b_matches = count_matches (b_description_split, terms);
-
-  if (a_matches > b_matches)
-    rval = -1;
-  else if (a_matches < b_matches)
-    rval = 1;
-
- out:
-  g_free (a_description);
-  g_free (b_description);
-  g_strfreev (a_description_split);
-  g_strfreev (b_description_split);
+  CcShellModelPrivate *priv = self->priv;
+  CcShellModelEntry *entry;
+  GHashTableIter iter;
 
-  return rval;
+  g_hash_table_iter_init (&iter, priv->index);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    compute_score (entry, priv->sort_terms, &entry->score);
 }
 
 static gint
-sort_with_terms (GtkTreeModel  *model,
-                 GtkTreeIter   *a,
-                 GtkTreeIter   *b,
-                 gchar        **terms)
+sort_by_name (CcShellModelEntry *a,
+              CcShellModelEntry *b)
 {
-  gint rval;
+  return g_strcmp0 (a->casefolded_name, b->casefolded_name);
+}
 
-  rval = sort_by_name_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
+static gint
+sort_with_terms (CcShellModelEntry *a,
+                 CcShellModelScore *a_score,
+                 CcShellModelEntry *b,
+                 CcShellModelScore *b_score)
+{
+  if (a_score->name != b_score->name)
+    return a_score->name > b_score->name ? -1 : 1;
 
-  rval = sort_by_keywords_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
+  if (a_score->keywords != b_score->keywords)
+    return a_score->keywords > b_score->keywords ? -1 : 1;
 
-  rval = sort_by_description_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
+  if (a_score->description != b_score->description)
+    return a_score->description > b_score->description ? -1 : 1;
 
-  return sort_by_name (model, a, b);
+  return sort_by_name (a, b);
 }
 
 static gint
@@ -225,11 +207,55 @@ cc_shell_model_sort_func (GtkTreeModel *model,
 {
   CcShellModel *self = data;
   CcShellModelPrivate *priv = self->priv;
+  CcShellModelEntry *a_entry, *b_entry;
+
+  a_entry = get_entry (self, a);
+  b_entry = get_entry (self, b);
 
   if (!priv->sort_terms || !priv->sort_terms[0])
-    return sort_by_name (model, a, b);
+    return sort_by_name (a_entry, b_entry);
   else
-    return sort_with_terms (model, a, b, priv->sort_terms);
+    return sort_with_terms (a_entry, &a_entry->score, b_entry, &b_entry->score);
+}
+
+static gboolean
+collect_row (GtkTreeModel *model,
+             GtkTreePath  *path,
+             GtkTreeIter  *iter,
+             gpointer      data)
+{
+  g_hash_table_add (data, iter->user_data);
+  return FALSE;
+}
+
+/* The iter of a deleted row is gone by the time we are told, so drop
+ * the entries of all the rows that are no longer in the store. There
+ * are only a few dozen panels. */
+static void
+cc_shell_model_row_deleted (GtkTreeModel *model,
+                            GtkTreePath  *path,
+                            gpointer      user_data)
+{
+  CcShellModelPrivate *priv = CC_SHELL_MODEL (model)->priv;
+  CcShellModelEntry *entry;
+  GHashTableIter iter;
+  GHashTable *rows;
+
+  rows = g_hash_table_new (NULL, NULL);
+  gtk_tree_model_foreach (model, collect_row, rows);
+
+  g_hash_table_iter_init (&iter, priv->index);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+      if (g_hash_table_contains (rows, entry->iter.user_data))
+        continue;
+
+      if (g_hash_table_lookup (priv->ids, entry->id) == entry)
+        g_hash_table_remove (priv->ids, entry->id);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  g_hash_table_destroy (rows);
 }
 
 static void
@@ -238,6 +264,8 @@ cc_shell_model_finalize (GObject *object)
   CcShellModelPrivate *priv = CC_SHELL_MODEL (object)->priv;;
 
   g_strfreev (priv->sort_terms);
+  g_hash_table_destroy (priv->ids);
+  g_hash_table_destroy (priv->index);
 
   G_OBJECT_CLASS (cc_shell_model_parent_class)->finalize (object);
 }
@@ -258,6 +286,12 @@ cc_shell_model_init (CcShellModel *self)
                    G_TYPE_UINT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_ICON, G_TYPE_STRV};
 
   self->priv = cc_shell_model_get_instance_private (self);
+  self->priv->index = g_hash_table_new_full (NULL, NULL, NULL,
+                                             (GDestroyNotify) entry_free);
+  self->priv->ids = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_signal_connect (self, "row-deleted",
+                    G_CALLBACK (cc_shell_model_row_deleted), NULL);
 
   gtk_list_store_set_column_types (GTK_LIST_STORE (self),
                                    N_COLS, types);
@@ -294,6 +328,54 @@ get_casefolded_keywords (GAppInfo *appinfo)
   return casefolded_keywords;
 }
 
+static void
+add_row (CcShellModel     *model,
+         CcPanelCategory   category,
+         GAppInfo         *appinfo,
+         const char       *id,
+         const char       *name,
+         const char       *description,
+         const char       *casefolded_name,
+         const char       *casefolded_description,
+         const char      **keywords,
+         GIcon            *icon)
+{
+  CcShellModelEntry *entry;
+
+  entry = g_slice_new0 (CcShellModelEntry);
+  entry->id = g_intern_string (id);
+  entry->casefolded_name = g_intern_string (casefolded_name);
+  entry->keywords = intern_strv ((gchar **) keywords);
+  if (casefolded_description)
+    {
+      char **tokens;
+
+      entry->casefolded_description = g_intern_string (casefolded_description);
+      tokens = g_strsplit (casefolded_description, " ", -1);
+      entry->description_tokens = intern_strv (tokens);
+      g_strfreev (tokens);
+    }
+  compute_score (entry, model->priv->sort_terms, &entry->score);
+
+  /* The row must be in the index before its values are set, as that
+   * is when the store sorts it into place */
+  gtk_list_store_insert (GTK_LIST_STORE (model), &entry->iter, 0);
+  g_hash_table_insert (model->priv->index, entry->iter.user_data, entry);
+  g_hash_table_insert (model->priv->ids, (gpointer) entry->id, entry);
+
+  gtk_list_store_set (GTK_LIST_STORE (model), &entry->iter,
+                      COL_NAME, name,
+                      COL_CASEFOLDED_NAME, casefolded_name,
+                      COL_APP, appinfo,
+                      COL_ID, id,
+                      COL_CATEGORY, category,
+                      COL_DESCRIPTION, description,
+                      COL_CASEFOLDED_DESCRIPTION, casefolded_description,
+                      COL_GICON, icon,
+                      COL_KEYWORDS, keywords,
+                      -1);
+}
+
 void
 cc_shell_model_add_item (CcShellModel    *model,
                          CcPanelCategory  category,
@@ -310,58 +392,109 @@ cc_shell_model_add_item (CcShellModel    *model,
   casefolded_description = cc_util_normalize_casefold_and_unaccent (comment);
   keywords = get_casefolded_keywords (appinfo);
 
-  gtk_list_store_insert_with_values (GTK_LIST_STORE (model), NULL, 0,
-                                     COL_NAME, name,
-                                     COL_CASEFOLDED_NAME, casefolded_name,
-                                     COL_APP, appinfo,
-                                     COL_ID, id,
-                                     COL_CATEGORY, category,
-                                     COL_DESCRIPTION, comment,
-                                     COL_CASEFOLDED_DESCRIPTION, casefolded_description,
-                                     COL_GICON, icon,
-                                     COL_KEYWORDS, keywords,
-                                     -1);
+  add_row (model, category, appinfo, id,
+           name, comment,
+           casefolded_name, casefolded_description,
+           (const char **) keywords, icon);
 
   g_free (casefolded_name);
   g_free (casefolded_description);
   g_strfreev (keywords);
 }
 
-gboolean
-cc_shell_model_iter_matches_search (CcShellModel *model,
-                                    GtkTreeIter  *iter,
-                                    const char   *term)
+/**
+ * cc_shell_model_add_cached_item:
+ * @model: a #CcShellModel
+ * @category: the panel's category
+ * @id: the panel's ID
+ * @name: the panel's name
+ * @description: (allow-none): the panel's description
+ * @casefolded_name: @name, as returned by cc_util_normalize_casefold_and_unaccent()
+ * @casefolded_description: (allow-none): same for @description
+ * @keywords: the normalized keywords
+ * @icon: (allow-none): the panel's icon
+ *
+ * Adds a panel whose strings were normalized beforehand, typically
+ * when reading them back from the panel cache. Rows added this way
+ * have no %COL_APP.
+ */
+void
+cc_shell_model_add_cached_item (CcShellModel    *model,
+                                CcPanelCategory  category,
+                                const char      *id,
+                                const char      *name,
+                                const char      *description,
+                                const char      *casefolded_name,
+                                const char      *casefolded_description,
+                                const char     **keywords,
+                                GIcon           *icon)
 {
-  gchar *name, *description;
-  gboolean result;
-  gchar **keywords;
+  add_row (model, category, NULL, id,
+           name, description,
+           casefolded_name, casefolded_description,
+           keywords, icon);
+}
 
-  gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
-                      COL_CASEFOLDED_NAME, &name,
-                      COL_CASEFOLDED_DESCRIPTION, &description,
-                      COL_KEYWORDS, &keywords,
-                      -1);
+static gboolean
+entry_matches_search (CcShellModelEntry *entry,
+                      const char        *term)
+{
+  gboolean result;
 
-  result = (strstr (name, term) != NULL);
+  result = (strstr (entry->casefolded_name, term) != NULL);
 
-  if (!result && description)
-    result = (strstr (description, term) != NULL);
+  if (!result && entry->casefolded_description)
+    result = (strstr (entry->casefolded_description, term) != NULL);
 
-  if (!result && keywords)
+  if (!result && entry->keywords)
     {
       gint i;
 
-      for (i = 0; !result && keywords[i]; i++)
-        result = (strstr (keywords[i], term) == keywords[i]);
+      for (i = 0; !result && entry->keywords[i]; i++)
+        result = g_str_has_prefix (entry->keywords[i], term);
     }
 
-  g_free (name);
-  g_free (description);
-  g_strfreev (keywords);
-
   return result;
 }
 
+static gboolean
+entry_matches_all_terms (CcShellModelEntry  *entry,
+                         gchar             **terms)
+{
+  gint i;
+
+  for (i = 0; terms[i]; i++)
+    {
+      if (!entry_matches_search (entry, terms[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+gboolean
+cc_shell_model_iter_matches_search (CcShellModel *model,
+                                    GtkTreeIter  *iter,
+                                    const char   *term)
+{
+  return entry_matches_search (get_entry (model, iter), term);
+}
+
+gboolean
+cc_shell_model_get_iter_for_id (CcShellModel *model,
+                                const char   *id,
+                                GtkTreeIter  *iter)
+{
+  CcShellModelEntry *entry;
+
+  entry = g_hash_table_lookup (model->priv->ids, id);
+  if (entry == NULL)
+    return FALSE;
+
+  *iter = entry->iter;
+  return TRUE;
+}
+
 void
 cc_shell_model_set_sort_terms (CcShellModel  *self,
                                gchar        **terms)
@@ -371,8 +504,111 @@ cc_shell_model_set_sort_terms (CcShellModel  *self,
   g_strfreev (priv->sort_terms);
   priv->sort_terms = g_strdupv (terms);
 
+  /* score every row once, so that comparisons are cheap */
+  rank_entries (self);
+
   /* trigger a re-sort */
   gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (self),
                                            cc_shell_model_sort_func,
                                            self, NULL);
 }
+
+/**
+ * cc_shell_model_get_results:
+ * @model: a #CcShellModel
+ * @terms: casefolded search terms
+ *
+ * Sorts the model for @terms and returns the IDs of the rows which match
+ * all of them, in model order.
+ *
+ * Returns: (transfer full): a %NULL-terminated array of panel IDs
+ */
+gchar **
+cc_shell_model_get_results (CcShellModel  *model,
+                            gchar        **terms)
+{
+  GtkTreeModel *tree_model = GTK_TREE_MODEL (model);
+  GtkTreeIter iter;
+  GPtrArray *results;
+  gboolean ok;
+
+  results = g_ptr_array_new ();
+
+  cc_shell_model_set_sort_terms (model, terms);
+
+  ok = gtk_tree_model_get_iter_first (tree_model, &iter);
+  while (ok)
+    {
+      CcShellModelEntry *entry = get_entry (model, &iter);
+
+      if (entry_matches_all_terms (entry, terms))
+        g_ptr_array_add (results, g_strdup (entry->id));
+
+      ok = gtk_tree_model_iter_next (tree_model, &iter);
+    }
+
+  g_ptr_array_add (results, NULL);
+
+  return (gchar **) g_ptr_array_free (results, FALSE);
+}
+
+static gint
+compare_results (gconstpointer a,
+                 gconstpointer b)
+{
+  CcShellModelResult *a_result = (CcShellModelResult *) a;
+  CcShellModelResult *b_result = (CcShellModelResult *) b;
+
+  return sort_with_terms (a_result->entry, &a_result->score,
+                          b_result->entry, &b_result->score);
+}
+
+/**
+ * cc_shell_model_get_subsearch_results:
+ * @model: a #CcShellModel
+ * @previous_results: IDs returned for a previous search
+ * @terms: casefolded search terms, refining the previous ones
+ *
+ * Like cc_shell_model_get_results(), but only considers the rows in
+ * @previous_results, and leaves the model itself untouched. The cost
+ * is proportional to the number of previous results rather than to the
+ * size of the model.
+ *
+ * Returns: (transfer full): a %NULL-terminated array of panel IDs
+ */
+gchar **
+cc_shell_model_get_subsearch_results (CcShellModel  *model,
+                                      gchar        **previous_results,
+                                      gchar        **terms)
+{
+  CcShellModelPrivate *priv = model->priv;
+  GArray *matches;
+  gchar **results;
+  guint i, n;
+
+  n = g_strv_length (previous_results);
+  matches = g_array_sized_new (FALSE, FALSE, sizeof (CcShellModelResult), n);
+
+  for (i = 0; i < n; i++)
+    {
+      CcShellModelResult result;
+
+      result.entry = g_hash_table_lookup (priv->ids, previous_results[i]);
+      if (result.entry == NULL || !entry_matches_all_terms (result.entry, terms))
+        continue;
+
+      compute_score (result.entry, terms, &result.score);
+      g_array_append_val (matches, result);
+    }
+
+  g_array_sort (matches, compare_results);
+
+  results = g_new (gchar *, matches->len + 1);
+  for (i = 0; i < matches->len; i++)
+    results[i] = g_strdup (g_array_index (matches, CcShellModelResult, i).entry->id);
+  results[matches->len] = NULL;
+
+  g_array_free (matches, TRUE);
+
+  return results;
+}
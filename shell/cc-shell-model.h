@@ -105,6 +105,16 @@ void cc_shell_model_add_item (CcShellModel   *model,
                               GAppInfo       *appinfo,
                               const char     *id);
 
+void cc_shell_model_add_cached_item (CcShellModel     *model,
+                                     CcPanelCategory   category,
+                                     const char       *id,
+                                     const char       *name,
+                                     const char       *description,
+                                     const char       *casefolded_name,
+                                     const char       *casefolded_description,
+                                     const char      **keywords,
+                                     GIcon            *icon);
+
 gboolean cc_shell_model_iter_matches_search (CcShellModel *model,
                                              GtkTreeIter  *iter,
                                              const char   *term);
@@ -112,6 +122,16 @@ gboolean cc_shell_model_iter_matches_search (CcShellModel *model,
 void cc_shell_model_set_sort_terms (CcShellModel  *model,
                                     gchar        **terms);
 
+gboolean cc_shell_model_get_iter_for_id (CcShellModel *model,
+                                         const char   *id,
+                                         GtkTreeIter  *iter);
+
+gchar **cc_shell_model_get_results           (CcShellModel  *model,
+                                              gchar        **terms);
+gchar **cc_shell_model_get_subsearch_results (CcShellModel  *model,
+                                              gchar        **previous_results,
+                                              gchar        **terms);
+
 G_END_DECLS
 
 #endif /* _CC_SHELL_MODEL_H */
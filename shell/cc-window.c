@@ -37,6 +37,7 @@
 #include "cc-shell-category-view.h"
 #include "cc-shell-model.h"
 #include "cc-panel-loader.h"
+#include "cc-shell-log.h"
 #include "cc-util.h"
 
 /* Use a fixed width for the shell, since resizing horizontally is more awkward
@@ -97,6 +98,8 @@ struct _CcWindow
 
   int monitor_num;
   CcSmallScreen small_screen;
+
+  gboolean panel_timing_logged;
 };
 
 static void     cc_shell_iface_init         (CcShellInterface      *iface);
@@ -153,6 +156,11 @@ activate_panel (CcWindow           *self,
     return FALSE;
 
   self->current_panel = GTK_WIDGET (cc_panel_loader_load_by_name (CC_SHELL (self), id, parameters));
+  if (!self->panel_timing_logged)
+    {
+      cc_shell_log_timing ("first panel constructed");
+      self->panel_timing_logged = TRUE;
+    }
   cc_shell_set_active_panel (CC_SHELL (self), CC_PANEL (self->current_panel));
   gtk_widget_show (self->current_panel);
 
@@ -877,6 +885,7 @@ setup_model (CcWindow *shell)
   add_category_view (shell, CC_CATEGORY_SYSTEM, C_("category", "System"));
 
   cc_panel_loader_fill_model (CC_SHELL_MODEL (shell->store));
+  cc_shell_log_timing ("model filled");
 }
 
 static void
@@ -1563,6 +1572,17 @@ create_window (CcWindow *self)
   gtk_widget_show_all (box);
 }
 
+static gboolean
+first_draw_cb (GtkWidget *widget,
+               cairo_t   *cr,
+               gpointer   user_data)
+{
+  cc_shell_log_timing ("first frame drawn");
+  g_signal_handlers_disconnect_by_func (widget, first_draw_cb, user_data);
+
+  return FALSE;
+}
+
 static void
 cc_window_init (CcWindow *self)
 {
@@ -1577,6 +1597,9 @@ cc_window_init (CcWindow *self)
   self->custom_widgets = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 
   stack_page_notify_cb (GTK_STACK (self->stack), NULL, self);
+
+  if (cc_shell_log_timings_enabled ())
+    g_signal_connect_after (self, "draw", G_CALLBACK (first_draw_cb), NULL);
 }
 
 CcWindow *
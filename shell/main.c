@@ -34,6 +34,7 @@
 #endif /* HAVE_CHEESE */
 
 #include "cc-application.h"
+#include "cc-shell-log.h"
 
 int
 main (int argc, char **argv)
@@ -41,6 +42,9 @@ main (int argc, char **argv)
   GtkApplication *application;
   int status;
 
+  /* Set GNOME_CONTROL_CENTER_TIMINGS to log startup timings */
+  cc_shell_log_timings_init ();
+
   bindtextdomain (GETTEXT_PACKAGE, GNOMELOCALEDIR);
   bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
   textdomain (GETTEXT_PACKAGE);
@@ -0,0 +1,227 @@
+#include "config.h"
+
+#include <locale.h>
+#include <string.h>
+#include <gio/gdesktopappinfo.h>
+
+#include "cc-shell-model.h"
+#include "cc-util.h"
+
+#define N_PANELS  60
+#define N_QUERIES 200
+
+static const char *words[] = {
+	"display", "sound", "network", "power", "battery", "mouse", "keyboard",
+	"printer", "color", "region", "language", "privacy", "sharing", "search",
+	"users", "accounts", "wifi", "bluetooth", "background", "date", "time",
+	"notifications", "screen", "brightness", "volume", "input", "output",
+	"touchpad", "zone", "profile", "tablet", "access", "universal", "details"
+};
+
+static const char *
+random_word (void)
+{
+	return words[g_test_rand_int_range (0, G_N_ELEMENTS (words))];
+}
+
+static char *
+random_words (guint n)
+{
+	GString *str;
+	guint i;
+
+	str = g_string_new (NULL);
+	for (i = 0; i < n; i++) {
+		if (i > 0)
+			g_string_append_c (str, ' ');
+		g_string_append (str, random_word ());
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+static CcShellModel *
+create_model (void)
+{
+	CcShellModel *model;
+	guint i;
+
+	model = cc_shell_model_new ();
+
+	for (i = 0; i < N_PANELS; i++) {
+		GDesktopAppInfo *app;
+		GKeyFile *keyfile;
+		char *id, *name, *comment, *keywords;
+
+		id = g_strdup_printf ("panel-%u", i);
+		/* Names are kept unique, so that the order is fully defined */
+		name = g_strdup_printf ("%s %s %u", random_word (), random_word (), i);
+		comment = random_words (g_test_rand_int_range (0, 6));
+		keywords = random_words (g_test_rand_int_range (0, 4));
+		g_strdelimit (keywords, " ", ';');
+
+		keyfile = g_key_file_new ();
+		g_key_file_set_string (keyfile, "Desktop Entry", "Type", "Application");
+		g_key_file_set_string (keyfile, "Desktop Entry", "Exec", "true");
+		g_key_file_set_string (keyfile, "Desktop Entry", "Name", name);
+		if (*comment != '\0')
+			g_key_file_set_string (keyfile, "Desktop Entry", "Comment", comment);
+		g_key_file_set_string (keyfile, "Desktop Entry", "Keywords", keywords);
+
+		app = g_desktop_app_info_new_from_keyfile (keyfile);
+		g_assert (app != NULL);
+
+		cc_shell_model_add_item (model, 0, G_APP_INFO (app), id);
+
+		g_object_unref (app);
+		g_key_file_free (keyfile);
+		g_free (keywords);
+		g_free (comment);
+		g_free (name);
+		g_free (id);
+	}
+
+	return model;
+}
+
+static char **
+split_terms (const char *query)
+{
+	GPtrArray *terms;
+	char **split;
+	guint i;
+
+	terms = g_ptr_array_new ();
+	split = g_strsplit (query, " ", -1);
+	for (i = 0; split[i] != NULL; i++) {
+		if (*split[i] != '\0')
+			g_ptr_array_add (terms, cc_util_normalize_casefold_and_unaccent (split[i]));
+	}
+	g_ptr_array_add (terms, NULL);
+	g_strfreev (split);
+
+	return (char **) g_ptr_array_free (terms, FALSE);
+}
+
+static void
+assert_results_equal (char       **expected,
+		      char       **results,
+		      const char  *query)
+{
+	guint i;
+
+	for (i = 0; expected[i] != NULL && results[i] != NULL; i++) {
+		if (g_strcmp0 (expected[i], results[i]) != 0)
+			g_error ("Result %u for '%s' is '%s', expected '%s'",
+				 i, query, results[i], expected[i]);
+	}
+
+	if (expected[i] != NULL || results[i] != NULL)
+		g_error ("Got %u results for '%s', expected %u",
+			 g_strv_length (results), query, g_strv_length (expected));
+}
+
+static void
+test_subsearch (void)
+{
+	CcShellModel *model;
+	guint i;
+
+	model = create_model ();
+
+	for (i = 0; i < N_QUERIES; i++) {
+		char *query, **previous_results;
+		guint len, j;
+
+		/* Type a query one character at a time, the way the shell
+		 * refines its searches, and check that every subsearch gives
+		 * the same answer as a full search */
+		query = random_words (g_test_rand_int_range (1, 4));
+		len = strlen (query);
+		previous_results = NULL;
+
+		for (j = 1; j <= len; j++) {
+			char *typed, **terms, **results, **expected;
+
+			typed = g_strndup (query, j);
+			terms = split_terms (typed);
+
+			expected = cc_shell_model_get_results (model, terms);
+			if (previous_results == NULL)
+				results = g_strdupv (expected);
+			else
+				results = cc_shell_model_get_subsearch_results (model,
+										previous_results,
+										terms);
+
+			assert_results_equal (expected, results, typed);
+
+			g_strfreev (previous_results);
+			previous_results = results;
+
+			g_strfreev (expected);
+			g_strfreev (terms);
+			g_free (typed);
+		}
+
+		g_strfreev (previous_results);
+		g_free (query);
+	}
+
+	g_object_unref (model);
+}
+
+static void
+test_remove (void)
+{
+	CcShellModel *model;
+	GtkTreeIter iter;
+	char **terms, **results;
+	char *id;
+	guint i, j;
+
+	model = create_model ();
+
+	/* Remove every other panel */
+	for (i = 0; i < N_PANELS; i += 2) {
+		id = g_strdup_printf ("panel-%u", i);
+		g_assert (cc_shell_model_get_iter_for_id (model, id, &iter));
+		gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
+		g_free (id);
+	}
+
+	for (i = 0; i < N_PANELS; i++) {
+		id = g_strdup_printf ("panel-%u", i);
+		g_assert (cc_shell_model_get_iter_for_id (model, id, &iter) == (i % 2 == 1));
+		g_free (id);
+	}
+
+	/* Searching and sorting only ever see the rows left */
+	for (i = 0; i < G_N_ELEMENTS (words); i++) {
+		terms = split_terms (words[i]);
+		cc_shell_model_set_sort_terms (model, terms);
+		results = cc_shell_model_get_results (model, terms);
+		for (j = 0; results[j] != NULL; j++) {
+			g_assert (cc_shell_model_get_iter_for_id (model, results[j], &iter));
+			g_assert (cc_shell_model_iter_matches_search (model, &iter, terms[0]));
+		}
+		g_strfreev (results);
+		g_strfreev (terms);
+	}
+
+	gtk_list_store_clear (GTK_LIST_STORE (model));
+	g_assert (!cc_shell_model_get_iter_for_id (model, "panel-1", &iter));
+
+	g_object_unref (model);
+}
+
+int main (int argc, char **argv)
+{
+	setlocale (LC_ALL, "");
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/shell/model/subsearch", test_subsearch);
+	g_test_add_func ("/shell/model/remove", test_remove);
+
+	return g_test_run ();
+}